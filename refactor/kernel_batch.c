@@ -0,0 +1,227 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/*************************************************************************
+
+           -------------------------------------------------
+          |                                                 |
+          |        Outbound Frame Batching per Tunnel       |
+          |                                                 |
+           -------------------------------------------------
+
+ Note:
+ 1.every frame sent out of a tunnel goes through kernel_batch_send, frames
+   are packed into one binary frame of KERNEL_WIRE_BATCH:
+        [KERNEL_WIRE_MAGIC][KERNEL_WIRE_BATCH]([WIRE_PART][len][frame])...
+   each part is a complete JSON / binary frame, unpacked one by one
+ 2.batch is only used when every core announced "SupportBatch", otherwise
+   frame is sent straight through the tunnel
+ 3.queue is flushed when next frame does not fit in KERNEL_BATCH_SIZE, at
+   the end of scheduler pass (KERNEL_BATCH_DELAY_MS == 0) or when the
+   oldest frame waited KERNEL_BATCH_DELAY_MS
+ 4.frame larger than the batch, or batch with single part, is sent as it
+   is, queued frames are always flushed first to keep the order
+ 5.senders of any thread may queue, each batch has its own lock, a slow
+   sender only holds frames of its tunnel
+
+*************************************************************************/
+
+#ifndef KERNEL_BATCH_SIZE
+#define KERNEL_BATCH_SIZE               256             // <! bytes of physical frame, 0 to disable
+#endif
+
+#ifndef KERNEL_BATCH_DELAY_MS
+#define KERNEL_BATCH_DELAY_MS           0               // <! 0: flush at the end of each scheduler pass
+#endif
+
+#define KERNEL_BATCH_HEAD               2               // <! magic + type
+#define KERNEL_BATCH_PART_HEAD          6               // <! tag + varint length
+
+struct kernel_batch_t {
+    struct kernel_batch_t         *next;
+    struct comm_tunnel_t          *tunnel;
+    uint8_t                       *buf;                 // <! x_malloc, handed to tunnel when flushed
+    int32_t                       len;
+    int32_t                       parts;
+    int32_t                       part_offset;          // <! first part, used when batch has single part
+    int32_t                       age_ms;               // <! waited time of oldest part
+
+    uint32_t                      frames;               // <! frames queued
+    uint32_t                      flushed;              // <! physical frames sent by batch
+    #ifdef PTHREAD_H
+    pthread_mutex_t               mutex;
+    #endif
+};
+
+static struct kernel_batch_t *kernel_batch_queue = NULL;
+
+#ifdef PTHREAD_H
+static pthread_mutex_t kernel_batch_list_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define KERNEL_BATCH_LOCK(m)            pthread_mutex_lock( m )
+#define KERNEL_BATCH_UNLOCK(m)          pthread_mutex_unlock( m )
+#else
+#define KERNEL_BATCH_LOCK(m)
+#define KERNEL_BATCH_UNLOCK(m)
+#endif
+
+static struct kernel_batch_t * kernel_batch_of(struct comm_tunnel_t *tunnel){
+    KERNEL_BATCH_LOCK( &kernel_batch_list_mutex );
+    struct kernel_batch_t *b = kernel_batch_queue;
+    while( b != NULL ){
+        if( b->tunnel == tunnel ){ break; }
+        b = b->next;
+    }
+
+    if( b == NULL ){
+        if( NULL != (b = (struct kernel_batch_t *)x_malloc( sizeof(struct kernel_batch_t) )) ){
+            memset( b, 0x0, sizeof(struct kernel_batch_t) );
+            b->tunnel = tunnel;
+            #ifdef PTHREAD_H
+            pthread_mutex_init( &b->mutex, NULL );
+            #endif
+            MOUNT( kernel_batch_queue, b );
+        }
+    }
+    KERNEL_BATCH_UNLOCK( &kernel_batch_list_mutex );
+    return b;
+}
+
+static bool kernel_tx_data(struct comm_tunnel_t *tunnel, uint8_t *frame, int32_t length);
+static bool kernel_tx_data_room(struct comm_tunnel_t *tunnel);
+
+static bool kernel_batch_tunnel_send(struct comm_tunnel_t *tunnel, uint8_t *frame, int32_t length){
+    return kernel_tx_data( tunnel, frame, length );     // <! queued to data lane, see kernel_tx.c
+}
+
+/**
+ *  @brief send out queued parts of tunnel as one frame
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+static void kernel_batch_flush(struct kernel_batch_t *b){
+    if( b->parts == 0 ){ return; }
+
+    uint8_t *frame = b->buf;  int32_t length = b->len;
+    if( b->parts == 1 ){                                // <! no need to wrap single frame
+        length = b->len - b->part_offset;
+        memmove( frame, &frame[b->part_offset], length );
+    }
+    b->buf = NULL;  b->len = 0;  b->parts = 0;  b->age_ms = 0;
+    b->flushed++;
+    kernel_batch_tunnel_send( b->tunnel, frame, length );
+}
+
+#if ( KERNEL_BATCH_SIZE > 0 )
+// !> called with b->mutex held
+static bool kernel_batch_put(struct kernel_batch_t *b, struct comm_tunnel_t *tunnel, uint8_t *frame, int32_t length){
+    bool batch = (all_support & KERNEL_CAP_BATCH) && (length + KERNEL_BATCH_PART_HEAD + KERNEL_BATCH_HEAD <= KERNEL_BATCH_SIZE);
+    if( (b->parts > 0) && ((! batch) || (b->len + KERNEL_BATCH_PART_HEAD + length > KERNEL_BATCH_SIZE)) ){
+        kernel_batch_flush( b );
+    }
+    if( ! batch ){ return kernel_batch_tunnel_send( tunnel, frame, length ); }
+    if( (b->parts == 0) && (! kernel_tx_data_room(tunnel)) ){          // <! lane keeps the room until flush, only
+        return kernel_batch_tunnel_send( tunnel, frame, length );       // <! batch is pushed to it meanwhile, dropped there
+    }
+
+    if( b->buf == NULL ){
+        if( NULL == (b->buf = (uint8_t *)x_malloc(KERNEL_BATCH_SIZE)) ){
+            return kernel_batch_tunnel_send( tunnel, frame, length );
+        }
+        b->buf[0] = KERNEL_WIRE_MAGIC;
+        b->buf[1] = KERNEL_WIRE_BATCH;
+        b->len    = KERNEL_BATCH_HEAD;
+    }
+
+    struct kernel_wire_t w = { b->buf, b->len, KERNEL_BATCH_SIZE, false };    // <! fits, never grows
+    w.buf[ w.len++ ] = WIRE_PART;
+    kernel_wire_put_varint( &w, length );
+    if( b->parts == 0 ){ b->part_offset = w.len; }
+    memcpy( &w.buf[w.len], frame, length );
+    b->len = w.len + length;
+    b->parts++;
+    b->frames++;
+    x_free( frame );
+    return true;
+}
+#endif
+
+/**
+ *  @brief queue frame to tunnel, frame is freed inside
+ *
+ *  @param [in] frame x_malloc
+ *  @param [out]
+ *  @return false if dropped
+ **/
+static bool kernel_batch_send(struct comm_tunnel_t *tunnel, uint8_t *frame, int32_t length){
+    #if ( KERNEL_BATCH_SIZE > 0 )
+    struct kernel_batch_t *b = kernel_batch_of( tunnel );
+    if( b == NULL ){ return kernel_batch_tunnel_send( tunnel, frame, length ); }
+
+    KERNEL_BATCH_LOCK( &b->mutex );
+    bool ret = kernel_batch_put( b, tunnel, frame, length );
+    KERNEL_BATCH_UNLOCK( &b->mutex );
+    return ret;
+    #else
+    return kernel_batch_tunnel_send( tunnel, frame, length );
+    #endif
+}
+
+/**
+ *  @brief called at the end of scheduler pass
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+void kernel_batch_pass_end(int32_t delta_ms){
+    struct kernel_batch_t *b = kernel_batch_queue;
+    while( b != NULL ){
+        KERNEL_BATCH_LOCK( &b->mutex );
+        if( b->parts > 0 ){
+            b->age_ms += delta_ms;
+            if( b->age_ms >= KERNEL_BATCH_DELAY_MS ){ kernel_batch_flush( b ); }
+        }
+        KERNEL_BATCH_UNLOCK( &b->mutex );
+        b = b->next;
+    }
+}
+
+/**
+ *  @brief time before next flush, used by kernel_idle_time
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return -1 if nothing queued
+ **/
+int32_t kernel_batch_next_time(void){
+    int32_t min_time = -1;
+    struct kernel_batch_t *b = kernel_batch_queue;
+    while( b != NULL ){
+        if( b->parts > 0 ){
+            int32_t t = KERNEL_BATCH_DELAY_MS - b->age_ms;
+            if( t < 0 ){ t = 0; }
+            if( (min_time < 0) || (t < min_time) ){ min_time = t; }
+        }
+        b = b->next;
+    }
+    return min_time;
+}
+
+/**
+ *  @brief unpack every part of batch frame, called by kernel_wire_unpack
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+static void kernel_batch_unpack(struct comm_tunnel_t *tunnel, struct kernel_wire_reader_t *r){
+    uint8_t tag;  const uint8_t *v;  int32_t len;
+    while( kernel_wire_next(r, &tag, &v, &len) ){
+        if( (tag != WIRE_PART) || (len == 0) ){ continue; }
+        if( (len >= 2) && (v[0] == KERNEL_WIRE_MAGIC) && (v[1] == KERNEL_WIRE_BATCH) ){ continue; }     // <! no nested batch
+        kernel_frame_unpack( tunnel, (uint8_t *)v, len );
+    }
+}
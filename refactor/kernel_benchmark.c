@@ -0,0 +1,388 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/*************************************************************************
+
+           -------------------------------------------------
+          |                                                 |
+          |       Host Benchmark of Kernel Hot Paths        |
+          |                                                 |
+           -------------------------------------------------
+
+ Build with KERNEL_BENCHMARK (and KERNEL_BENCHMARK_MAIN for standalone),
+ target kernel_benchmark of port/posix does both
+ Every result is printed as one line, grep "^BENCH " to collect:
+
+   BENCH {"case":"post_deliver","param":16,"ops":4096,"total_us":812,
+          "ns_per_op":198,"max_us":3}
+
+ ops       : operation count of the case
+ param     : queue depth / task count / thread count / payload size
+ max_us    : worst single operation (latency cases only, else 0)
+
+ hex_check lines carry "ok":1 when SIMD hex code matches the scalar code
+
+*************************************************************************/
+
+#if defined (KERNEL_BENCHMARK)
+
+#ifndef KERNEL_BENCH_ROUNDS
+#define KERNEL_BENCH_ROUNDS             4096            // <! operations per case
+#endif
+
+#define KERNEL_BENCH_MAX_TASKS          256
+
+static char    bench_task_names[KERNEL_BENCH_MAX_TASKS][16];
+static int32_t bench_delivered  = 0;
+static int32_t bench_latency_max = 0;
+
+static void bench_report(const char *name, int32_t param, int32_t ops, int32_t total_us, int32_t max_us){
+    int64_t ns_per_op = (ops > 0)?( (int64_t)total_us * 1000 / ops ):(0);
+    LOG( "BENCH {\"case\":\"%s\",\"param\":%d,\"ops\":%d,\"total_us\":%d,\"ns_per_op\":%d,\"max_us\":%d}\r\n",
+         name, param, ops, total_us, (int)ns_per_op, max_us );
+}
+
+static task_state bench_sink_task(const char *this_task, struct msg_t *msg, void *arg){
+    if( msg->length == sizeof(int32_t) ){
+        int32_t stamp;
+        memcpy( &stamp, msg->data, sizeof(stamp) );
+        bench_latency_max = MAX( bench_latency_max, tock_us(stamp) );   // <! post to deliver latency
+    }
+    bench_delivered++;
+    return TASK_IDLE;
+}
+
+static void bench_drain(int32_t expected){
+    int32_t guard = expected * 4 + 16;
+    while( (bench_delivered < expected) && (guard-- > 0) ){
+        kernel_task_sheduler();
+    }
+}
+
+static void bench_delete_tasks(int32_t num){
+    for( int32_t i=0; i<num; i++ ){ delete_task( bench_task_names[i] ); }
+    kernel_task_sheduler();                                    // <! deleted task removed in next pass
+}
+
+static void bench_create_tasks(int32_t num, task_state (*callback)(const char *, struct msg_t *, void *)){
+    for( int32_t i=0; i<num; i++ ){
+        snprintf( bench_task_names[i], sizeof(bench_task_names[i]), "bench_%d", (int)i );
+        create_task( bench_task_names[i], callback, NULL, 1 );
+    }
+}
+
+/**
+ *  @brief __new_msg/__post_msg/deliver throughput and latency across queue depths
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+static void bench_post_deliver(void){
+    const int32_t depth_list[] = { 1, 16, 256 };
+
+    bench_create_tasks( 1, bench_sink_task );
+    for( unsigned int d=0; d<sizeof(depth_list)/sizeof(depth_list[0]); d++ ){
+        int32_t depth = depth_list[d], ops = 0, post_us = 0, deliver_us = 0;
+        bench_latency_max = 0;
+
+        while( ops < KERNEL_BENCH_ROUNDS ){
+            bench_delivered = 0;
+
+            int32_t t0 = tick_us();
+            for( int32_t i=0; i<depth; i++ ){
+                int32_t stamp = tick_us();
+                __post_msg( bench_task_names[0], __new_msg("bench", (char *)&stamp, sizeof(stamp)) );
+            }
+            post_us += tock_us( t0 );
+
+            t0 = tick_us();
+            bench_drain( depth );
+            deliver_us += tock_us( t0 );
+            ops += depth;
+        }
+        bench_report( "post", depth, ops, post_us, 0 );
+        bench_report( "post_deliver", depth, ops, post_us + deliver_us, bench_latency_max );
+    }
+    bench_delete_tasks( 1 );
+}
+
+/**
+ *  @brief __new_msg_from_isr claim latency, contention from producer threads on hosted build
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+struct bench_isr_arg_t {
+    int32_t ops;
+    int32_t total_us;
+    int32_t max_us;
+};
+
+static void * bench_isr_producer(void *arg){
+    struct bench_isr_arg_t *a = (struct bench_isr_arg_t *)arg;
+    char payload[16] = "bench_isr";
+
+    for( int32_t i=0; i<KERNEL_BENCH_ROUNDS; i++ ){
+        int32_t t0 = tick_us();
+        xMsgHandler m = __new_msg_from_isr( "bench_isr", payload, sizeof(payload) - 1 );
+        int32_t us = tock_us( t0 );
+        if( m != NULL ){
+            __delete_msg( m );                                   // <! give the box back at once
+            a->ops++;
+            a->total_us += us;
+            a->max_us = MAX( a->max_us, us );
+        }
+    }
+    return NULL;
+}
+
+static void bench_isr_claim(void){
+    create_mailbox( 32, 64 );
+
+    #ifdef PTHREAD_H
+    const int32_t thread_list[] = { 1, 2, 4 };
+    for( unsigned int n=0; n<sizeof(thread_list)/sizeof(thread_list[0]); n++ ){
+        pthread_t th[4];  struct bench_isr_arg_t arg[4];  int32_t threads = thread_list[n];
+        memset( arg, 0x0, sizeof(arg) );
+
+        for( int32_t i=0; i<threads; i++ ){ pthread_create( &th[i], NULL, bench_isr_producer, &arg[i] ); }
+        for( int32_t i=0; i<threads; i++ ){ pthread_join( th[i], NULL ); }
+
+        struct bench_isr_arg_t sum = { 0, 0, 0 };
+        for( int32_t i=0; i<threads; i++ ){
+            sum.ops += arg[i].ops;  sum.total_us += arg[i].total_us;  sum.max_us = MAX( sum.max_us, arg[i].max_us );
+        }
+        bench_report( "isr_claim", threads, sum.ops, sum.total_us, sum.max_us );
+    }
+    #else
+    struct bench_isr_arg_t arg = { 0, 0, 0 };
+    bench_isr_producer( &arg );
+    bench_report( "isr_claim", 1, arg.ops, arg.total_us, arg.max_us );
+    #endif
+}
+
+/**
+ *  @brief scheduler pass cost with every task holding a periodic timer
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+static void bench_timer_scaling(void){
+    const int32_t task_list[] = { 16, 64, 256 };
+
+    for( unsigned int n=0; n<sizeof(task_list)/sizeof(task_list[0]); n++ ){
+        int32_t num = task_list[n];
+        bench_create_tasks( num, bench_sink_task );
+        for( int32_t i=0; i<num; i++ ){
+            __post_msg( bench_task_names[i], msg_set_repeat_timer(__new_notification("bench_timer"), 1, 1) );
+        }
+
+        int32_t passes = KERNEL_BENCH_ROUNDS / 16, max_us = 0;
+        int32_t t0 = tick_us();
+        for( int32_t i=0; i<passes; i++ ){
+            int32_t t1 = tick_us();
+            kernel_task_sheduler();
+            max_us = MAX( max_us, tock_us(t1) );
+        }
+        bench_report( "timer_pass", num, passes, tock_us(t0), max_us );
+
+        for( int32_t i=0; i<num; i++ ){ task_disable_timer( bench_task_names[i] ); }
+        bench_delete_tasks( num );
+    }
+}
+
+/**
+ *  @brief get_task_handler lookup cost versus task count
+ *         same pointer hits the fast path, copied name hits strcmp path
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+static void bench_task_lookup(void){
+    const int32_t task_list[] = { 8, 64, 256 };
+
+    for( unsigned int n=0; n<sizeof(task_list)/sizeof(task_list[0]); n++ ){
+        int32_t num = task_list[n];
+        bench_create_tasks( num, bench_sink_task );
+
+        char copied[16];
+        strcpy( copied, bench_task_names[num - 1] );           // <! worst case: last task of queue
+
+        int32_t t0 = tick_us();
+        for( int32_t i=0; i<KERNEL_BENCH_ROUNDS; i++ ){
+            if( get_task_handler(bench_task_names[num - 1], kernel_task_queue) == NULL ){ break; }
+        }
+        bench_report( "lookup_ptr", num, KERNEL_BENCH_ROUNDS, tock_us(t0), 0 );
+
+        t0 = tick_us();
+        for( int32_t i=0; i<KERNEL_BENCH_ROUNDS; i++ ){
+            if( get_task_handler(copied, kernel_task_queue) == NULL ){ break; }
+        }
+        bench_report( "lookup_str", num, KERNEL_BENCH_ROUNDS, tock_us(t0), 0 );
+
+        bench_delete_tasks( num );
+    }
+}
+
+/**
+ *  @brief try_post_msg_outside / kernel_msg_layer_unpack over loopback tunnel
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+static int32_t bench_tunnel_bytes = 0;
+
+static int32_t bench_loopback_send(layer_proc_func_list *proc, void *arg, uint8_t *data, int32_t length){
+    bench_tunnel_bytes += length;
+    x_free( data );                                            // <! frame is owned by tunnel
+    return length;
+}
+
+static layer_proc_func_list bench_loopback_proc[2] = { { bench_loopback_send }, { NULL } };
+static struct comm_tunnel_t bench_loopback_tunnel;
+
+static void bench_tunnel_codec(void){
+    const int32_t size_list[] = { 8, 64, 512 };
+
+    bench_loopback_tunnel.send_proc = bench_loopback_proc;
+    synchonize_tasklist( "bench_core", 1, &bench_loopback_tunnel );
+
+    struct MCUs_t *peer = is_mcu_exist( "bench_peer" );
+    if( peer == NULL ){ peer = kernel_create_mcu( "bench_peer", &bench_loopback_tunnel, 1 ); }
+    if( peer == NULL ){ return; }
+    kernel_add_task_to_mcu( peer, "bench_echo" );
+
+    bench_create_tasks( 1, bench_sink_task );
+    synchonize_tasklist( "bench_core", 0 );
+
+    for( unsigned int n=0; n<sizeof(size_list)/sizeof(size_list[0]); n++ ){
+        int32_t size = size_list[n];
+        char *payload = (char *)x_malloc( size + 1 );
+        if( payload == NULL ){ break; }
+        memset( payload, 'a', size );  payload[size] = 0;
+
+        // !> encode: local task post to remote task, frame captured by loopback tunnel,
+        //    scheduler pass sends queued frames before the send queue is full
+        bench_tunnel_bytes = 0;
+        int32_t t0 = tick_us();
+        for( int32_t i=0; i<KERNEL_BENCH_ROUNDS; i++ ){
+            __post_msg( "bench_echo", __new_msg("bench", payload, size) );
+            if( (i % KERNEL_TX_BURST) == (KERNEL_TX_BURST - 1) ){ kernel_task_sheduler(); }
+        }
+        kernel_task_sheduler();
+        bench_report( "encode", size, KERNEL_BENCH_ROUNDS, tock_us(t0), 0 );
+        LOG( "BENCH {\"case\":\"encode_bytes\",\"param\":%d,\"bytes_per_op\":%d}\r\n",
+             size, bench_tunnel_bytes / KERNEL_BENCH_ROUNDS );
+
+        // !> decode: frame received from loopback tunnel for local task
+        int32_t frame_len = size + 96;
+        char *frame = (char *)x_malloc( frame_len );
+        char *rx    = (char *)x_malloc( frame_len );
+        if( (frame != NULL) && (rx != NULL) ){
+            frame_len = snprintf( frame, frame_len, "{\"msg\":{\"targ_task\":\"%s\",\"notify\":\"bench\",\"data\":\"%s\"}}",
+                                  bench_task_names[0], payload ) + 1;
+            int32_t decode_us = 0;
+            bench_delivered = 0;
+            for( int32_t i=0; i<KERNEL_BENCH_ROUNDS; i++ ){
+                memcpy( rx, frame, frame_len );                // <! decoder may work in place
+                t0 = tick_us();
+                kernel_msg_layer_unpack( bench_loopback_proc, &bench_loopback_tunnel, (uint8_t *)rx, frame_len );
+                decode_us += tock_us( t0 );
+                if( (i & 0x3F) == 0x3F ){ bench_drain( i + 1 ); }   // <! keep msg queue short
+            }
+            bench_drain( KERNEL_BENCH_ROUNDS );
+            bench_report( "decode", size, KERNEL_BENCH_ROUNDS, decode_us, 0 );
+        }
+        if( frame != NULL ){ x_free( frame ); }
+        if( rx != NULL )   { x_free( rx );    }
+        x_free( payload );
+    }
+    bench_delete_tasks( 1 );
+}
+
+/**
+ *  @brief kernel_hex_encode / kernel_hex_decode against scalar code, same digits and
+ *         bytes are checked first
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+static void bench_hex_codec(void){
+    const int32_t size_list[] = { 64, 1024, 8192 };
+
+    for( unsigned int n=0; n<sizeof(size_list)/sizeof(size_list[0]); n++ ){
+        int32_t size = size_list[n];
+        uint8_t *data = (uint8_t *)x_malloc( size ), *back = (uint8_t *)x_malloc( size );
+        char    *hex  = (char *)x_malloc( 2 * size ),  *ref  = (char *)x_malloc( 2 * size );
+        if( (data == NULL) || (back == NULL) || (hex == NULL) || (ref == NULL) ){
+            if( data != NULL ){ x_free( data ); }
+            if( back != NULL ){ x_free( back ); }
+            if( hex != NULL ) { x_free( hex );  }
+            if( ref != NULL ) { x_free( ref );  }
+            break;
+        }
+        for( int32_t i=0; i<size; i++ ){ data[i] = (uint8_t)( i * 131 + 7 ); }
+
+        // !> same digits as scalar code, round trip, broken digit leaves destination untouched
+        kernel_hex_encode_scalar( data, size, ref );
+        kernel_hex_encode( data, size, hex );
+        bool ok = ( memcmp(hex, ref, 2 * size) == 0 ) && kernel_hex_decode( hex, back, size ) && ( memcmp(back, data, size) == 0 );
+        ok = ok && ( kernel_hex_decode_update(hex, back, size) == 0 );
+        ref[ size ] = 'g';
+        ok = ok && ( kernel_hex_decode_update(ref, back, size) < 0 ) && ( memcmp(back, data, size) == 0 );
+        LOG( "BENCH {\"case\":\"hex_check\",\"param\":%d,\"ok\":%d}\r\n", size, (ok)?(1):(0) );
+
+        int32_t rounds = MAX( KERNEL_BENCH_ROUNDS * 64 / size, 1 );
+        int32_t t0 = tick_us();
+        for( int32_t i=0; i<rounds; i++ ){ kernel_hex_encode( data, size, hex ); }
+        bench_report( "hex_encode", size, rounds, tock_us(t0), 0 );
+
+        t0 = tick_us();
+        for( int32_t i=0; i<rounds; i++ ){ kernel_hex_encode_scalar( data, size, ref ); }
+        bench_report( "hex_encode_scalar", size, rounds, tock_us(t0), 0 );
+
+        t0 = tick_us();
+        for( int32_t i=0; i<rounds; i++ ){ kernel_hex_decode( hex, back, size ); }
+        bench_report( "hex_decode", size, rounds, tock_us(t0), 0 );
+
+        t0 = tick_us();
+        for( int32_t i=0; i<rounds; i++ ){ kernel_hex_decode_scalar( hex, back, size ); }
+        bench_report( "hex_decode_scalar", size, rounds, tock_us(t0), 0 );
+
+        x_free( data );  x_free( back );  x_free( hex );  x_free( ref );
+    }
+}
+
+/**
+ *  @brief run all benchmark cases, results printed as "BENCH {json}" lines
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+void kernel_benchmark_run(void){
+    LOG( "BENCH {\"case\":\"start\",\"rounds\":%d}\r\n", KERNEL_BENCH_ROUNDS );
+    bench_post_deliver();
+    bench_isr_claim();
+    bench_timer_scaling();
+    bench_task_lookup();
+    bench_tunnel_codec();
+    bench_hex_codec();
+    LOG( "BENCH {\"case\":\"end\"}\r\n" );
+}
+
+#if defined (KERNEL_BENCHMARK_MAIN)
+int main(void){
+    kernel_benchmark_run();
+    return 0;
+}
+#endif
+
+#endif
@@ -0,0 +1,235 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#ifndef KERNEL_CALL_TIMEOUT_NOTIFY
+#define KERNEL_CALL_TIMEOUT_NOTIFY      "call_timeout"   // <! notification delivered to caller when call timeout
+#endif
+
+struct kernel_call_t {
+    struct kernel_call_t      *next;
+    uint32_t                  call_id;          // <! correlation id carried by request and reply
+    char                      *caller_task;     // <! reply will be routed back to this task, __strdup__
+    int32_t                   timeout;          // <! remaining time before timeout : unit( ms )
+    bool                      timed_out;        // <! timeout reached, waiting to report to caller
+};
+
+static struct kernel_call_t *kernel_call_queue = NULL;     // <! outstanding calls of local tasks
+static uint32_t kernel_call_seq = 0;
+
+#ifdef PTHREAD_H
+static pthread_mutex_t kernel_call_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/**
+ *  @brief call target task (local or remote), reply will be routed back to src_task
+ *         src_task will receive the reply msg, or KERNEL_CALL_TIMEOUT_NOTIFY after timeout
+ *         both of them carry the call id, use msg_call_id() to match
+ * 
+ *  @param [in] timeout: unit( ms )
+ *  @param [out]
+ *  @return call id, 0 when failed
+ **/
+uint32_t __call_msg_from(const char *target_task, xMsgHandler msg, const char *src_task, int32_t timeout){
+    ASSERT_NULL( target_task );
+    ASSERT_NULL( msg );
+    ASSERT_NULL( src_task );
+    ASSERT_TRUE( timeout > 0 );
+
+    if( msg == NULL ){ return 0; }
+
+    struct kernel_msg_t *p = (struct kernel_msg_t *)msg;
+    if( (target_task == NULL) || (src_task == NULL) || p->mail.mailbox_type || p->timer.enable ){
+        WARNING( "call[%s] should be plain msg with caller, msg Drop!", p->msg.notification );
+        __delete_msg( msg );
+        return 0;
+    }
+
+    struct kernel_call_t *c = (struct kernel_call_t *)x_malloc( sizeof(struct kernel_call_t) );
+    if( c == NULL ){
+        WARNING( "No Memory for call[%s]\r\n", p->msg.notification );
+        __delete_msg( msg );
+        return 0;
+    }
+    memset( c, 0x0, sizeof(struct kernel_call_t) );
+    c->caller_task = __strdup__( src_task );                // <! src_task may be a transient buffer
+    if( c->caller_task == NULL ){
+        WARNING( "No Memory for call[%s]\r\n", p->msg.notification );
+        x_free( c );
+        __delete_msg( msg );
+        return 0;
+    }
+    c->timeout     = timeout;
+
+    #ifdef PTHREAD_H
+    pthread_mutex_lock( &kernel_call_mutex );
+    #endif
+    if( ++kernel_call_seq == 0 ){ kernel_call_seq = 1; }    // <! 0 is reserved for plain msg
+    c->call_id = kernel_call_seq;
+    MOUNT( kernel_call_queue, c );                          // <! record before post, reply may come back at once
+    #ifdef PTHREAD_H
+    pthread_mutex_unlock( &kernel_call_mutex );
+    #endif
+
+    uint32_t call_id = c->call_id;
+    p->call_id    = call_id;
+    p->call_reply = 0;
+
+    if( ! __post_msg_from(target_task, msg, src_task) ){
+        kernel_call_complete( call_id, src_task );          // <! msg already dropped by post
+        return 0;
+    }
+    return call_id;
+}
+
+/**
+ *  @brief reply the request msg which is delivered to this_task
+ *         reply goes back to the caller of request, no matter local or remote
+ * 
+ *  @param [in]
+ *  @param [out]
+ *  @return 
+ **/
+bool __reply_msg(const struct msg_t *request, xMsgHandler reply, const char *this_task){
+    ASSERT_NULL( request );
+    ASSERT_NULL( reply );
+
+    if( reply == NULL ){ return false; }
+
+    struct kernel_msg_t *req = kernel_msg_of( request );
+    if( (req == NULL) || (req->call_id == 0) || req->call_reply || (req->msg.src_task == NULL) ){
+        WARNING( "msg[%s] is not a call, reply Drop!", (request)?(request->notification):("") );
+        __delete_msg( reply );
+        return false;
+    }
+
+    struct kernel_msg_t *p = (struct kernel_msg_t *)reply;
+    p->call_id    = req->call_id;
+    p->call_reply = 1;
+    return __post_msg_from( req->msg.src_task, reply, this_task );
+}
+
+uint32_t msg_call_id(const struct msg_t *msg){
+    struct kernel_msg_t *p = kernel_msg_of( msg );
+    return (p != NULL)?(p->call_id):(0);
+}
+
+bool msg_is_reply(const struct msg_t *msg){
+    struct kernel_msg_t *p = kernel_msg_of( msg );
+    return (p != NULL) && (p->call_id != 0) && p->call_reply;
+}
+
+/**
+ *  @brief complete outstanding call when reply arrived at caller task
+ *         late reply (after timeout reported) finds nothing and should be dropped
+ * 
+ *  @param [in]
+ *  @param [out]
+ *  @return true: call was outstanding
+ **/
+static bool kernel_call_complete(uint32_t call_id, const char *caller_task){
+    bool found = false;
+
+    #ifdef PTHREAD_H
+    pthread_mutex_lock( &kernel_call_mutex );
+    #endif
+    struct kernel_call_t *c = kernel_call_queue;
+    while( c != NULL ){
+        if( (c->call_id == call_id) && (strcmp(c->caller_task, caller_task) == 0x0) ){
+            UNMOUNT( kernel_call_queue, c );
+            x_free( c->caller_task );
+            x_free( c );
+            found = true;
+            break;
+        }
+        c = c->next;
+    }
+    #ifdef PTHREAD_H
+    pthread_mutex_unlock( &kernel_call_mutex );
+    #endif
+    return found;
+}
+
+/**
+ *  @brief count down outstanding calls, report timeout to caller task
+ *         driven by timer engine of kernel_task_sheduler
+ * 
+ *  @param [in]
+ *  @param [out]
+ *  @return 
+ **/
+void kernel_call_check_timeout(int32_t delta_ms){
+    struct kernel_call_t *c = NULL;
+
+    #ifdef PTHREAD_H
+    pthread_mutex_lock( &kernel_call_mutex );
+    #endif
+    for( c = kernel_call_queue; c != NULL; c = c->next ){
+        if( c->timeout > delta_ms ){ c->timeout -= delta_ms; }
+        else{ c->timeout = 0;  c->timed_out = true; }
+    }
+    #ifdef PTHREAD_H
+    pthread_mutex_unlock( &kernel_call_mutex );
+    #endif
+
+    // !> post outside of lock, the timeout reply completes the call through __post_msg_from
+    while( 1 ){
+        uint32_t call_id = 0;  char *caller_task = NULL;
+
+        #ifdef PTHREAD_H
+        pthread_mutex_lock( &kernel_call_mutex );
+        #endif
+        for( c = kernel_call_queue; c != NULL; c = c->next ){
+            if( c->timed_out ){ call_id = c->call_id;  break; }
+        }
+        if( c != NULL ){
+            caller_task = __strdup__( c->caller_task );     // <! call may complete by another thread once unlocked
+            if( caller_task == NULL ){                      // <! can not report, forget the call
+                UNMOUNT( kernel_call_queue, c );
+                x_free( c->caller_task );
+                x_free( c );
+            }
+        }
+        #ifdef PTHREAD_H
+        pthread_mutex_unlock( &kernel_call_mutex );
+        #endif
+
+        if( c == NULL ){ break; }
+        if( caller_task == NULL ){ continue; }
+
+        struct kernel_msg_t *m = __new_msg( KERNEL_CALL_TIMEOUT_NOTIFY, (char *)&call_id, sizeof(call_id) );
+        if( m != NULL ){
+            m->call_id    = call_id;
+            m->call_reply = 1;
+        }
+        if( m != NULL ){
+            __post_msg_from( caller_task, m, NULL );
+        }
+        kernel_call_complete( call_id, caller_task );       // <! forget the call even if caller is gone
+        x_free( caller_task );
+    }
+}
+
+/**
+ *  @brief get the minimal time before next call timeout
+ * 
+ *  @param [in]
+ *  @param [out]
+ *  @return -1: no outstanding call
+ **/
+int32_t kernel_call_min_timeout(void){
+    int32_t min_time = -1;
+
+    #ifdef PTHREAD_H
+    pthread_mutex_lock( &kernel_call_mutex );
+    #endif
+    struct kernel_call_t *c = kernel_call_queue;
+    while( c != NULL ){
+        if( (min_time < 0) || (c->timeout < min_time) ){ min_time = c->timeout; }
+        c = c->next;
+    }
+    #ifdef PTHREAD_H
+    pthread_mutex_unlock( &kernel_call_mutex );
+    #endif
+    return min_time;
+}
@@ -14,6 +14,10 @@
 
 struct kernel_external_task_t {
     struct kernel_external_task_t *next;
+    struct kernel_external_task_t *route_next;            // <! Next in bucket of kernel_route_table
+    struct MCUs_t                 *mcu;                   // <! Owner MCU, route of the task
+    uint32_t                      hash;                   // <! kernel_name_hash of task_name
+    uint16_t                      id;                     // <! Assigned by owner core, 0: not assigned
     bool                          cached;                 // <! Mark as recoverd task, can not use for sync
     #if defined (DISABLE_NON_ZERO_ARRAY)
     char                          task_name[1];           // <! [1] Special for ARMCC which Not support ZeroArray
@@ -22,13 +26,57 @@ struct kernel_external_task_t {
     #endif
 };
 
+// !> capability announced by core, "SupportXxx" in JSON, same bit in WIRE_FLAGS of binary frame
+#define KERNEL_CAP_JSON_EXTRA           0x0001          // <! Hex data outside of JSON
+#define KERNEL_CAP_BIN_FRAME            0x0002          // <! binary frame, see kernel_wire.c
+#define KERNEL_CAP_IDS                  0x0004          // <! numeric ids in binary frame
+#define KERNEL_CAP_BATCH                0x0008          // <! batch frame, see kernel_batch.c
+#define KERNEL_CAP_CREDIT               0x0010          // <! credit flow control, see kernel_tx.c
+#define KERNEL_CAP_LZ                   0x0020          // <! compressed data in binary frame, see kernel_lz.c
+#define KERNEL_CAP_ROUTE_HEAD           0x0040          // <! routed frame, relayed by header only
+#define KERNEL_CAP_LINK_COST            0x0080          // <! answers link probes, see kernel_link.c
+#define KERNEL_CAP_DELTA_SYNC           0x0100          // <! versioned task list delta, see kernel_delta_sync.c
+#define KERNEL_CAP_MMAP_DELTA           0x0200          // <! changed runs of mmap in binary frame
+#define KERNEL_CAP_HEX_TEXT             0x0400          // <! hex data as prefixed text in JSON, see kernel_hex.c
+
+#define KERNEL_CAP_KEPT                 ( KERNEL_CAP_JSON_EXTRA | KERNEL_CAP_BIN_FRAME )  // <! kept as known when not carried
+#define KERNEL_CAP_JSON                 ( KERNEL_CAP_JSON_EXTRA | KERNEL_CAP_HEX_TEXT )   // <! used without binary frame
+
+static const struct kernel_cap_name_t {
+    uint16_t                      cap;
+    const char                    *name;
+} kernel_cap_names[] = {
+    { KERNEL_CAP_JSON_EXTRA,  "SupportJsonExtra" },
+    { KERNEL_CAP_BIN_FRAME,   "SupportBinFrame"  },
+    { KERNEL_CAP_IDS,         "SupportIds"       },
+    { KERNEL_CAP_BATCH,       "SupportBatch"     },
+    { KERNEL_CAP_CREDIT,      "SupportCredit"    },
+    { KERNEL_CAP_LZ,          "SupportLz"        },
+    { KERNEL_CAP_ROUTE_HEAD,  "SupportRouteHead" },
+    { KERNEL_CAP_LINK_COST,   "SupportLinkCost"  },
+    { KERNEL_CAP_DELTA_SYNC,  "SupportDeltaSync" },
+    { KERNEL_CAP_MMAP_DELTA,  "SupportMmapDelta" },
+    { KERNEL_CAP_HEX_TEXT,    "SupportHexText"   },
+};
+
+#define KERNEL_CAP_NUM                  ( (int32_t)(sizeof(kernel_cap_names) / sizeof(kernel_cap_names[0])) )
+
 struct MCUs_t {
     struct MCUs_t                 *next;
     struct kernel_external_task_t *task_queue;            // <! Task queue of MCU
     struct comm_tunnel_t          *tunnel;                // <! Send out Tunnel
     int                           jump;                   // <! Jump point of the MCU
+    int32_t                       cost;                   // <! Cost of route, see kernel_link.c
+    struct kernel_link_path_t     *paths;                 // <! Paths heard from each tunnel
+    uint32_t                      version;                // <! Task list version of owner core, see kernel_delta_sync.c
+    uint8_t                       sync_mark;              // <! KERNEL_SYNC_MARK_xxx, core to be packed
+    uint32_t                      hash;                   // <! kernel_name_hash of core
+    uint16_t                      id;                     // <! Core id assigned by sync, 0: not assigned
+    uint16_t                      task_id_last;           // <! Last task id assigned, local MCU only
+    uint16_t                      task_id_size;
+    struct kernel_external_task_t **task_by_id;           // <! Index of tasks by id - 1
     bool                          is_local;               // <! Local MCU Mark
-    bool                          support_json_extra;     // <! support Hex data outside of JSON
+    uint16_t                      caps;                   // <! KERNEL_CAP_xxx announced by the MCU
     bool                          mmap_req_sent;          // <! mmap req sent marker, only req once
     bool                          task_modified;          // <! Use for backup marker
     #if defined (DISABLE_NON_ZERO_ARRAY)
@@ -39,15 +87,158 @@ struct MCUs_t {
 };
 
 static struct MCUs_t *kernel_mcu_queue = NULL;
-static bool all_support_json_extra = false;
+static uint16_t all_support = 0;                        // <! KERNEL_CAP_xxx of every core, see kernel_recv_cores_end
+
+/**
+ *  @brief "SupportXxx" of every capability
+ * 
+ *  @param [in]
+ *  @param [out]
+ *  @return 
+ **/
+static void kernel_cap_to_json(cJSON *core, uint16_t caps){
+    for( int32_t i=0; i<KERNEL_CAP_NUM; i++ ){
+        cJSON_AddBoolToObject( core, kernel_cap_names[i].name, (caps & kernel_cap_names[i].cap) != 0 );
+    }
+}
+
+/**
+ *  @brief capabilities of "SupportXxx" in core object
+ * 
+ *  @param [in]
+ *  @param [out] known : KERNEL_CAP_xxx carried, true or false, may be NULL
+ *  @return KERNEL_CAP_xxx carried true
+ **/
+static uint16_t kernel_cap_from_json(cJSON *core, uint16_t *known){
+    uint16_t caps = 0, carried = 0;
+    for( int32_t i=0; i<KERNEL_CAP_NUM; i++ ){
+        cJSON *o = cJSON_GetObjectItem( core, kernel_cap_names[i].name );
+        if( o == NULL ){ continue; }
+        carried |= kernel_cap_names[i].cap;
+        if( o->type == cJSON_True ){ caps |= kernel_cap_names[i].cap; }
+    }
+    if( known != NULL ){ *known = carried; }
+    return caps;
+}
+
+#define KERNEL_SYNC_MARK_DIRTY          0x01            // <! changed since last sync
+#define KERNEL_SYNC_MARK_REQ            0x02            // <! requested by peer
 const char *local_core_name = NULL;
 
+// !> per-pass arena for transient JSON, see kernel_pass_arena.c
+bool   kernel_pass_json_enter(void);
+void   kernel_pass_json_leave(bool entered);
+void * kernel_pass_malloc(size_t size);
+void   kernel_pass_free(void *p);
+void * kernel_pass_promote(void *p, size_t size);
+
+// !> compact binary frame, see kernel_wire.c
+#ifndef KERNEL_WIRE_MAGIC
+#define KERNEL_WIRE_MAGIC               0xB5            // <! first byte of binary frame, JSON always starts with '{'
+#endif
+struct kernel_msg_t;
+struct kernel_external_task_t;
+struct kernel_route_t;
+struct kernel_route_core_t;
+struct kernel_route_snap_t;
+static bool      kernel_wire_send_msg(const struct kernel_route_t *target, const struct kernel_route_t *src,
+                                      const struct kernel_msg_t *msg, const char *src_task, const void *data, int32_t length);
+static bool      kernel_wire_send_mmap(const struct kernel_route_snap_t *snap, const struct kernel_route_core_t *route,
+                                       const char *src_core, const char *dst_core, const char *mem_name,
+                                       const void *mem_data, int32_t mem_size, struct comm_tunnel_t *avoid_tunnel);
+static bool      kernel_wire_send_mmap_delta(struct kernel_mmap_t *p, const char *src_core);
+static bool      kernel_wire_apply_runs(uint8_t *mem, int32_t size, const uint8_t *runs, int32_t length, bool *changed);
+static bool      kernel_wire_send_mmap_req(const struct kernel_route_snap_t *snap, const struct kernel_route_core_t *route,
+                                           const char *src_core, const char *dst_core, struct comm_tunnel_t *avoid_tunnel);
+static uint8_t * kernel_wire_pack_cores(int32_t *length, uint8_t mark);
+static int32_t   kernel_wire_unpack(struct comm_tunnel_t *tunnel, uint8_t *data, int32_t length);
+static int32_t   kernel_frame_unpack(struct comm_tunnel_t *tunnel, uint8_t *data, int32_t length);
+static bool      kernel_wire_relay(struct comm_tunnel_t *tunnel, uint8_t *data, int32_t length, bool *taken);
+
+// !> link cost and least cost route, see kernel_link.c
+static int32_t   kernel_link_announced(int32_t cost, int32_t jump, int32_t via);
+static bool      kernel_link_path_update(struct MCUs_t *mcu, struct comm_tunnel_t *tunnel, int32_t cost, int32_t jump);
+static void      kernel_link_path_free(struct MCUs_t *mcu);
+static bool      kernel_link_select(struct MCUs_t *mcu);
+static void      kernel_link_peer(struct comm_tunnel_t *tunnel, int32_t core_id);
+static uint16_t  kernel_link_via(const struct MCUs_t *mcu);
+static void      kernel_link_rx(struct comm_tunnel_t *tunnel);
+
+// !> hex digits of JSON payload, see kernel_hex.c
+#ifndef KERNEL_HEX_JSON
+#define KERNEL_HEX_JSON                 1               // <! 1: announce "SupportHexText", 0: always cJSON_HexString
+#endif
+static int32_t   kernel_hex_decode_update(const char *src, uint8_t *dst, int32_t length);
+static cJSON *   kernel_hex_json(const uint8_t *data, int32_t length);
+static uint8_t * kernel_hex_json_bytes(const cJSON *item, int32_t *length);
+static bool      kernel_hex_prefixed(const char *str, int32_t length);
+
+// !> versioned task list delta, see kernel_delta_sync.c
+static void      kernel_delta_log(const char *task_name, uint16_t task_id, bool removed, uint32_t version);
+static bool      kernel_delta_synchonize(struct MCUs_t *local);
+static void      kernel_delta_mark_all(void);
+static void      kernel_delta_clear_marks(const struct MCUs_t *local);
+static void      kernel_delta_rebase(struct MCUs_t *local, uint32_t version);
+
+// !> outbound frame batching, see kernel_batch.c
+#ifndef KERNEL_BATCH_SIZE
+#define KERNEL_BATCH_SIZE               256             // <! bytes of physical frame, 0 to disable
+#endif
+static bool      kernel_batch_send(struct comm_tunnel_t *tunnel, uint8_t *frame, int32_t length);
+
+// !> payload compression, see kernel_lz.c
+#ifndef KERNEL_LZ_MIN_SIZE
+#define KERNEL_LZ_MIN_SIZE              64              // <! 0 to disable compression
+#endif
+
+// !> asynchronous send queue of tunnel, see kernel_tx.c
+static void      kernel_tx_control(struct comm_tunnel_t *tunnel, uint8_t *frame, int32_t length);
+static void      kernel_tx_consumed(struct comm_tunnel_t *tunnel, const uint8_t *frame, int32_t length);
+static void      kernel_tx_rx_hold(struct comm_tunnel_t *tunnel);
+
+// !> allocation-free JSON scanner, see kernel_json_scan.c
+#ifndef KERNEL_JSON_SCAN
+#define KERNEL_JSON_SCAN                1               // <! 0: parse JSON frame by cJSON DOM
+#endif
+static int32_t   kernel_json_scan_unpack(struct comm_tunnel_t *tunnel, const uint8_t *data, int32_t length);
+static int32_t   kernel_json_dom_unpack(struct comm_tunnel_t *tunnel, uint8_t *data, int32_t length);
+
+// !> task name to external task (and its MCU), see kernel_route_find
+#ifndef KERNEL_ROUTE_BUCKETS
+#define KERNEL_ROUTE_BUCKETS            32              // <! must be power of 2
+#endif
+static struct kernel_external_task_t *kernel_route_table[ KERNEL_ROUTE_BUCKETS ] = { NULL };
+
+static void kernel_route_remove(struct kernel_external_task_t *t);
+
+static uint32_t kernel_name_hash(const char *name){     // <! FNV-1a
+    uint32_t h = 2166136261u;
+    while( *name != '\0' ){ h = (h ^ (uint8_t)*name++) * 16777619u; }
+    return h;
+}
+
+// !> dense core ids handed out by task list sync, see kernel_mcu_id_assign
+static struct MCUs_t **kernel_mcu_by_id = NULL;         // <! Index of cores by id - 1
+static uint16_t kernel_mcu_id_size = 0;
+static uint16_t kernel_mcu_id_last = 0;                 // <! Highest core id assigned or heard
+
+static struct MCUs_t * kernel_id_mcu(uint16_t id){
+    if( (id == 0) || (id > kernel_mcu_id_size) ){ return NULL; }
+    return kernel_mcu_by_id[ id - 1 ];
+}
+
+static struct kernel_external_task_t * kernel_id_task(uint16_t core_id, uint16_t task_id){
+    struct MCUs_t *mcu = kernel_id_mcu( core_id );
+    if( (mcu == NULL) || (task_id == 0) || (task_id > mcu->task_id_size) ){ return NULL; }
+    return mcu->task_by_id[ task_id - 1 ];
+}
 
 static struct MCUs_t * is_mcu_exist(const char *core_name){
     ASSERT_NULL( core_name );
+    uint32_t hash = kernel_name_hash( core_name );
     struct MCUs_t *p = kernel_mcu_queue;
     while( p != NULL ){
-        if( strcmp(p->core, core_name) == 0x0 ){ break; }
+        if( (p->hash == hash) && (strcmp(p->core, core_name) == 0x0) ){ break; }
         p = p->next;
     }
     return p;
@@ -62,6 +253,218 @@ static const char * get_my_core_name(void){
     return NULL;
 }
 
+/*************************************************************************
+
+           -------------------------------------------------
+          |                                                 |
+          |        Route Snapshot for Lock-free Senders     |
+          |                                                 |
+           -------------------------------------------------
+
+ Note:
+ 1.kernel_mcu_queue / kernel_route_table are only changed by receive path
+   and task list sync (writer), senders (try_post_msg_outside, mmap, raw
+   frames relayed or passed on) read an immutable copy of them, published
+   when topology changed
+ 2.reader: kernel_route_read_lock / kernel_route_read_unlock around the
+   use of snapshot, no lock, only counter of current epoch
+ 3.writer: kernel_route_changed marks table dirty, kernel_route_publish
+   builds new snapshot, swaps it in and flips epoch, old snapshot is freed
+   after readers of old epoch left (one retired snapshot at a time)
+ 4.writer never waits for readers: while retired snapshot is still in use,
+   the table stays dirty and is published by next kernel_route_pass_end
+
+*************************************************************************/
+
+struct kernel_route_core_t {
+    const char                    *core;
+    uint32_t                      hash;
+    struct comm_tunnel_t          *tunnel;              // <! tunnel to the core, NULL for local core
+    int32_t                       jump;
+    uint16_t                      id;
+    bool                          is_local;
+};
+
+struct kernel_route_t {
+    const struct kernel_route_t   *next;                // <! Next in bucket, same order as kernel_route_table
+    const struct kernel_route_core_t *mcu;
+    const char                    *task_name;
+    uint32_t                      hash;
+    uint16_t                      id;
+};
+
+struct kernel_route_snap_t {
+    const struct kernel_route_t   *bucket[ KERNEL_ROUTE_BUCKETS ];
+    const struct kernel_route_core_t *cores;
+    const struct kernel_route_core_t **core_by_id;      // <! same index as kernel_mcu_by_id
+    int32_t                       core_num;
+    int32_t                       route_num;
+    uint16_t                      core_id_size;
+};
+
+static struct kernel_route_snap_t *kernel_route_snap = NULL;
+static struct kernel_route_snap_t *kernel_route_retired = NULL;     // <! waiting for readers of retired epoch
+static uint32_t kernel_route_epoch = 0;
+static uint32_t kernel_route_readers[2] = { 0 };
+static bool kernel_route_dirty = false;
+
+static void kernel_route_changed(void){
+    kernel_route_dirty = true;
+}
+
+const struct kernel_route_snap_t * kernel_route_read_lock(uint32_t *epoch){
+    while( true ){
+        uint32_t e = kernel_atomic_load32( &kernel_route_epoch );
+        kernel_atomic_add32( (int32_t *)&kernel_route_readers[e & 1], 1 );
+        kernel_atomic_fence();
+        if( kernel_atomic_load32(&kernel_route_epoch) == e ){
+            *epoch = e;
+            return (const struct kernel_route_snap_t *)kernel_atomic_load_ptr( (void **)&kernel_route_snap );
+        }
+        kernel_atomic_add32( (int32_t *)&kernel_route_readers[e & 1], -1 );   // <! epoch flipped, retry
+    }
+}
+
+void kernel_route_read_unlock(uint32_t epoch){
+    kernel_atomic_fence();
+    kernel_atomic_add32( (int32_t *)&kernel_route_readers[epoch & 1], -1 );
+}
+
+static const struct kernel_route_t * kernel_route_snap_find(const struct kernel_route_snap_t *snap, const char *task_name){
+    if( (snap == NULL) || (task_name == NULL) ){ return NULL; }
+
+    uint32_t hash = kernel_name_hash( task_name );
+    const struct kernel_route_t *r = snap->bucket[ hash & (KERNEL_ROUTE_BUCKETS - 1) ];
+    while( r != NULL ){
+        if( (r->hash == hash) && (strcmp(r->task_name, task_name) == 0x0) ){ break; }
+        r = r->next;
+    }
+    return r;
+}
+
+static const struct kernel_route_core_t * kernel_route_snap_core(const struct kernel_route_snap_t *snap, const char *core_name){
+    if( (snap == NULL) || (core_name == NULL) ){ return NULL; }
+
+    uint32_t hash = kernel_name_hash( core_name );
+    for( int32_t i = 0; i < snap->core_num; i++ ){
+        if( (snap->cores[i].hash == hash) && (strcmp(snap->cores[i].core, core_name) == 0x0) ){ return &snap->cores[i]; }
+    }
+    return NULL;
+}
+
+static const struct kernel_route_core_t * kernel_route_snap_core_id(const struct kernel_route_snap_t *snap, uint16_t id){
+    if( (snap == NULL) || (id == 0) || (id > snap->core_id_size) ){ return NULL; }
+    return snap->core_by_id[ id - 1 ];
+}
+
+static bool kernel_route_reclaim(void){
+    if( kernel_route_retired == NULL ){ return true; }
+
+    uint32_t e = kernel_atomic_load32( &kernel_route_epoch ) - 1;       // <! epoch of retired snapshot
+    kernel_atomic_fence();
+    if( kernel_atomic_load32(&kernel_route_readers[e & 1]) != 0 ){ return false; }
+
+    x_free( kernel_route_retired );
+    kernel_route_retired = NULL;
+    return true;
+}
+
+/**
+ *  @brief build snapshot from kernel_mcu_queue / kernel_route_table, in one block
+ * 
+ *  @param [in] 
+ *  @param [out]
+ *  @return NULL if no memory
+ **/
+static struct kernel_route_snap_t * kernel_route_build(void){
+    int32_t core_num = 0, route_num = 0, name_size = 0;
+    for( struct MCUs_t *mcu = kernel_mcu_queue; mcu != NULL; mcu = mcu->next ){
+        core_num++;  name_size += strlen( mcu->core ) + 1;
+        for( struct kernel_external_task_t *t = mcu->task_queue; t != NULL; t = t->next ){
+            route_num++;  name_size += strlen( t->task_name ) + 1;
+        }
+    }
+
+    int32_t size = sizeof(struct kernel_route_snap_t) + core_num * sizeof(struct kernel_route_core_t)
+                 + kernel_mcu_id_size * sizeof(struct kernel_route_core_t *)
+                 + route_num * sizeof(struct kernel_route_t) + name_size;
+    struct kernel_route_snap_t *snap = (struct kernel_route_snap_t *)x_malloc( size );
+    if( snap == NULL ){ return NULL; }
+    memset( snap, 0x0, sizeof(struct kernel_route_snap_t) );
+    snap->core_num     = core_num;
+    snap->route_num    = route_num;
+    snap->core_id_size = kernel_mcu_id_size;
+
+    struct kernel_route_core_t *cores = (struct kernel_route_core_t *)&snap[1];
+    const struct kernel_route_core_t **core_by_id = (const struct kernel_route_core_t **)&cores[core_num];
+    struct kernel_route_t *routes = (struct kernel_route_t *)&core_by_id[kernel_mcu_id_size];
+    char *names = (char *)&routes[route_num];
+    snap->cores      = cores;
+    snap->core_by_id = core_by_id;
+    memset( core_by_id, 0x0, kernel_mcu_id_size * sizeof(struct kernel_route_core_t *) );
+
+    int32_t i = 0;
+    for( struct MCUs_t *mcu = kernel_mcu_queue; mcu != NULL; mcu = mcu->next, i++ ){
+        cores[i].core     = strcpy( names, mcu->core );    names += strlen( mcu->core ) + 1;
+        cores[i].hash     = mcu->hash;
+        cores[i].tunnel   = (mcu->is_local)?(NULL):(mcu->tunnel);
+        cores[i].jump     = mcu->jump;
+        cores[i].id       = mcu->id;
+        cores[i].is_local = mcu->is_local;
+        if( kernel_id_mcu(mcu->id) == mcu ){ core_by_id[ mcu->id - 1 ] = &cores[i]; }
+    }
+
+    int32_t n = 0;
+    for( int32_t b = 0; b < KERNEL_ROUTE_BUCKETS; b++ ){
+        const struct kernel_route_t **tail = &snap->bucket[ b ];
+        for( struct kernel_external_task_t *t = kernel_route_table[b]; t != NULL; t = t->route_next ){
+            int32_t c = 0;                              // <! core record of t->mcu, same order as kernel_mcu_queue
+            for( struct MCUs_t *mcu = kernel_mcu_queue; (mcu != NULL) && (mcu != t->mcu); mcu = mcu->next ){ c++; }
+            if( (c >= core_num) || (n >= route_num) ){ continue; }
+
+            struct kernel_route_t *r = &routes[ n++ ];
+            r->next      = NULL;
+            r->mcu       = &cores[ c ];
+            r->task_name = strcpy( names, t->task_name );  names += strlen( t->task_name ) + 1;
+            r->hash      = t->hash;
+            r->id        = t->id;
+            *tail = r;  tail = &r->next;
+        }
+    }
+    return snap;
+}
+
+/**
+ *  @brief publish snapshot if routing changed, writer side only
+ * 
+ *  @param [in] 
+ *  @param [out]
+ *  @return 
+ **/
+static void kernel_route_publish(void){
+    if( ! kernel_route_reclaim() ){ return; }           // <! readers of retired epoch still inside, keep dirty and
+    if( ! kernel_route_dirty ){ return; }               // <! retry at next kernel_route_pass_end, never spin
+
+    struct kernel_route_snap_t *snap = kernel_route_build();
+    if( snap == NULL ){ return; }                       // <! keep dirty, retry later
+    kernel_route_dirty = false;
+
+    kernel_route_retired = (struct kernel_route_snap_t *)kernel_atomic_xchg_ptr( (void **)&kernel_route_snap, snap );
+    kernel_atomic_xchg32( &kernel_route_epoch, kernel_route_epoch + 1 );
+    kernel_route_reclaim();
+}
+
+/**
+ *  @brief called at the end of scheduler pass
+ * 
+ *  @param [in] 
+ *  @param [out]
+ *  @return 
+ **/
+void kernel_route_pass_end(void){
+    kernel_route_publish();
+}
+
 /*************************************************************************
 
            -------------------------------------------------
@@ -69,9 +472,27 @@ static const char * get_my_core_name(void){
           |     Kernel Memory Mapping Between Other MCUs    | 
           |                                                 |
            -------------------------------------------------
+
+ Note:
+ 1.changed region is found by comparing KERNEL_MMAP_BLOCK bytes at a
+   time against prev_sync_mem, when every core announced
+   "SupportMmapDelta" only changed runs are sent (WIRE_MEM_RUNS, see
+   kernel_wire_send_mmap_delta), whole region otherwise or when runs take
+   more than half of it
+ 2.whole region is still sent every KERNEL_MMAP_FULL_EVERY deltas and on
+   sync request, receiver without synced region requests it instead of
+   patching
            
 *************************************************************************/
 
+#ifndef KERNEL_MMAP_BLOCK
+#define KERNEL_MMAP_BLOCK               32              // <! bytes compared at a time for changed runs
+#endif
+
+#ifndef KERNEL_MMAP_FULL_EVERY
+#define KERNEL_MMAP_FULL_EVERY          16              // <! deltas sent before whole region again, 0 to disable delta
+#endif
+
 #pragma anon_unions
 struct kernel_mmap_t {
     struct kernel_mmap_t  *next;
@@ -80,10 +501,12 @@ struct kernel_mmap_t {
         char                *to_core;
     };
     char                  *mem_name;
+    uint16_t              mem_id;                       // <! id assigned by receiving core, 0: names in binary frame
     void                  *prev_sync_mem;
     void                  *mem;
     int32_t               mem_size;
     bool                  sync_already;
+    uint16_t              delta_count;                  // <! deltas sent since whole region
 
     mmap_update_notify    update_callback;
     void                  *arg;
@@ -91,6 +514,46 @@ struct kernel_mmap_t {
 
 static struct kernel_mmap_t *kernel_mmap_from_queue = NULL, *kernel_mmap_to_queue = NULL;
 
+// !> receiving spaces by id, ids go to the sending core in mmap_sync_req, see kernel_wire_send_mmap_req
+static struct kernel_mmap_t **kernel_mmap_by_id = NULL;
+static uint16_t kernel_mmap_id_size = 0;
+static uint16_t kernel_mmap_id_last = 0;
+
+static const char * kernel_mmap_id_name(const char *src_core, uint16_t mem_id){
+    if( (mem_id == 0) || (mem_id > kernel_mmap_id_last) ){ return NULL; }
+    struct kernel_mmap_t *p = kernel_mmap_by_id[ mem_id - 1 ];
+    return (strcmp(p->from_core, src_core) == 0x0)?(p->mem_name):(NULL);
+}
+
+/**
+ *  @brief id of local sending space, bound when receiving core asked for sync
+ * 
+ *  @param [in]
+ *  @param [out]
+ *  @return 0 if not bound
+ **/
+static uint16_t kernel_mmap_to_id(const char *src_core, const char *dst_core, const char *mem_name){
+    const char *local_core = get_my_core_name();
+    if( (local_core == NULL) || (strcmp(src_core, local_core) != 0x0) ){ return 0; }    // <! passed on for other core
+    struct kernel_mmap_t *p = kernel_mmap_to_queue;
+    while( p != NULL ){
+        if( (strcmp(p->to_core, dst_core) == 0x0) && (strcmp(p->mem_name, mem_name) == 0x0) ){ return p->mem_id; }
+        p = p->next;
+    }
+    return 0;
+}
+
+static void kernel_mmap_to_bind(const char *src_core, const char *dst_core, const char *mem_name, uint16_t mem_id){
+    const char *local_core = get_my_core_name();
+    if( (local_core == NULL) || (strcmp(src_core, local_core) != 0x0) ){ return; }
+
+    struct kernel_mmap_t *p = kernel_mmap_to_queue;
+    while( p != NULL ){
+        if( (strcmp(p->to_core, dst_core) == 0x0) && (strcmp(p->mem_name, mem_name) == 0x0) ){ p->mem_id = mem_id; }
+        p = p->next;
+    }
+}
+
 struct kernel_mmap_t *create_kernel_mmap(const char mem_name[], void *mem, int32_t mem_size){
     ASSERT_NULL( mem );
     ASSERT_NULL( mem_name );
@@ -131,6 +594,23 @@ xMmapHandler kernel_mmap_from(const char core_name[], const char mem_name[], voi
     struct kernel_mmap_t *p = create_kernel_mmap( mem_name, mem, mem_size );
     if( p != NULL ){
         p->from_core = __strdup__( core_name );
+
+        if( (kernel_mmap_id_last == kernel_mmap_id_size) && (kernel_mmap_id_size < 0x8000) ){   // <! ids are dense, index grows by 2x
+            uint16_t size = (kernel_mmap_id_size != 0)?(kernel_mmap_id_size * 2):(8);
+            struct kernel_mmap_t **index = (struct kernel_mmap_t **)x_malloc( size * sizeof(struct kernel_mmap_t *) );
+            if( index != NULL ){
+                if( kernel_mmap_by_id != NULL ){
+                    memcpy( index, kernel_mmap_by_id, kernel_mmap_id_size * sizeof(struct kernel_mmap_t *) );
+                    x_free( kernel_mmap_by_id );
+                }
+                kernel_mmap_by_id   = index;
+                kernel_mmap_id_size = size;
+            }
+        }
+        if( kernel_mmap_id_last < kernel_mmap_id_size ){            // <! no id: names in binary frame
+            kernel_mmap_by_id[ kernel_mmap_id_last++ ] = p;
+            p->mem_id = kernel_mmap_id_last;
+        }
         MOUNT( kernel_mmap_from_queue, p );
     }
     return p;
@@ -198,35 +678,37 @@ static int32_t get_kernel_mmap_unsync_timeout(void){
  *  @param [out]
  *  @return 
  **/
-static bool kernel_router_raw(const char *dst_core, void *msg, int32_t len, struct comm_tunnel_t *avoid_tunnel){
-    if( dst_core == NULL ){ return false; }
+static bool kernel_router_raw_tunnel(struct comm_tunnel_t *tunnel, void *msg, int32_t len, struct comm_tunnel_t *avoid_tunnel){
     if( msg == NULL )     { return false; }           // <! the msg will be freed by internal
-    if( len == 0x00 )     { return true;  }
+    if( len == 0x00 )     { kernel_pass_free( msg );  return true;  }
+    if( (tunnel == NULL) || (tunnel == avoid_tunnel) ){                           // <! avoid same channel
+        kernel_pass_free( msg );
+        return false;
+    }
 
-    #ifdef PTHREAD_H
-    static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
-    pthread_mutex_lock( &mutex );
-    #endif
+    msg = kernel_pass_promote( msg, len );            // <! msg escapes the pass, move out of arena
+    if( msg == NULL )     { return false; }
 
-    struct MCUs_t *mcu = kernel_mcu_queue;
-    while( mcu != NULL ){
-        if( strcmp(mcu->core, dst_core) == 0x0 ){
-        
-            if( mcu->tunnel == avoid_tunnel ){ break; }                           // <! avoid same channel
-        
-            layer_proc_func_list *proc = mcu->tunnel->send_proc;
-            int32_t sent_length = proc[0].func( &proc[1], mcu->tunnel, (uint8_t *)msg, len );
-            #ifdef PTHREAD_H
-            pthread_mutex_unlock( &mutex );
-            #endif
-            return true;
-        }
-        mcu = mcu->next;
-    }
-    #ifdef PTHREAD_H
-    pthread_mutex_unlock( &mutex );
-    #endif
-    return false;
+    return kernel_batch_send( tunnel, (uint8_t *)msg, len );          // <! false when data lane is full, batch locks its tunnel
+}
+
+static bool kernel_router_raw_to(const struct kernel_route_core_t *core, void *msg, int32_t len, struct comm_tunnel_t *avoid_tunnel){
+    return kernel_router_raw_tunnel( (core != NULL)?(core->tunnel):(NULL), msg, len, avoid_tunnel );
+}
+
+/**
+ *  @brief send out msg to core found in route snapshot
+ * 
+ *  @param [in]
+ *  @param [out]
+ *  @return 
+ **/
+static bool kernel_router_raw(const char *dst_core, void *msg, int32_t len, struct comm_tunnel_t *avoid_tunnel){
+    uint32_t epoch;
+    const struct kernel_route_snap_t *snap = kernel_route_read_lock( &epoch );
+    bool ret = kernel_router_raw_to( kernel_route_snap_core(snap, dst_core), msg, len, avoid_tunnel );
+    kernel_route_read_unlock( epoch );
+    return ret;
 }
 
 /**
@@ -236,13 +718,13 @@ static bool kernel_router_raw(const char *dst_core, void *msg, int32_t len, stru
  *  @param [out]
  *  @return 
  **/
-static bool kernel_router_json(const char *dst_core, cJSON *js, void *extra_data, uint16_t length, struct comm_tunnel_t *avoid_tunnel){
-    if( dst_core == NULL ){ return false; }
+static bool kernel_router_json(struct comm_tunnel_t *tunnel, cJSON *js, void *extra_data, uint16_t length, struct comm_tunnel_t *avoid_tunnel){
+    if( tunnel == NULL )  { return false; }
     if( js == NULL )      { return false; }
 
     char *jsString = cJSON_PrintUnformatted( js );
     if( jsString != NULL ){
-        LOG( "%s\r\n", jsString );
+        //LOG( "%s\r\n", jsString );
 
         // !> padding data to Json
         if( (extra_data != NULL) && (length > 0) ){
@@ -256,15 +738,15 @@ static bool kernel_router_json(const char *dst_core, cJSON *js, void *extra_data
                 p->data_type = cJSON_HexString;
                 p->length = length;
                 memcpy( p->data, extra_data, length );
-                x_free( jsString );
-                return kernel_router_raw( dst_core, s, with_extra_length, avoid_tunnel );
+                kernel_pass_free( jsString );
+                return kernel_router_raw_tunnel( tunnel, s, with_extra_length, avoid_tunnel );
             }else{
-                x_free( jsString );
+                kernel_pass_free( jsString );
                 return false;
             }
         }
 
-        return kernel_router_raw( dst_core, jsString, strlen(jsString) + 1, avoid_tunnel );
+        return kernel_router_raw_tunnel( tunnel, jsString, strlen(jsString) + 1, avoid_tunnel );
     }
     return false;
 }
@@ -281,55 +763,63 @@ static bool kernel_mmap_request(const char *src_core, const char *dst_core,
     if( src_core == NULL ){ return false; }
     if( dst_core == NULL ){ return false; }
 
-    struct MCUs_t *mcu = kernel_mcu_queue;
-    while( mcu != NULL ){
-        if( strcmp(mcu->core, src_core) == 0x0 ){               // <! Specially match the "src_core"
-            
-            if( mcu->tunnel == avoid_tunnel ){ break; }           // <! avoid same channel
-            
-            if( mcu->tunnel->passive_tunnel ){                                    // <! Passive Tunnel
-                if( ! mcu->tunnel->tunnel_enabled ){                                // <! Tunnel Disabled
-                    return false;                                                     // <! We don't send anything outside
-                }
-            }
+    uint32_t epoch;  bool ret = false;
+    const struct kernel_route_snap_t *snap = kernel_route_read_lock( &epoch );   // <! no lock against receive path
+    const struct kernel_route_core_t *mcu = kernel_route_snap_core( snap, src_core );   // <! Specially match the "src_core"
+    if( (mcu == NULL) || (mcu->tunnel == NULL) ){
+        WARNING( "src_core [%s] not found", src_core );
+    }else{
+        if( mcu->tunnel == avoid_tunnel ){ goto UNLOCK; }     // <! avoid same channel
         
-        /*************************************************************************
-         *                                                                        *
-         *          -------------------------------------------------             *
-         *         |                                                 |            *
-         *         |        Process mmap request  From JSON          |            *
-         *         |                                                 |            *
-         *          -------------------------------------------------             *
-         * mmap_sync_req                                                          *
-         * {                                                                      *
-         *     "src_core": "nRF52840",                                            *
-         *     "dst_core": "PSoc6_M0",                                            *
-         * }                                                                      *
-         *                                                                        *
-         *************************************************************************/
-        
-            cJSON *js = cJSON_CreateObject();
-            if( js != NULL ){
-                cJSON *mmap_js = cJSON_CreateObject();
-                if( mmap_js != NULL ){
-                    cJSON_AddItemToObject( js, "mmap_sync_req", mmap_js );
-                    
-                    cJSON_AddStringToObject( mmap_js, "src_core", src_core );      // <! source from
-                    cJSON_AddStringToObject( mmap_js, "dst_core", dst_core );      // <! source from
-                    
-                    bool ret = kernel_router_json( mcu->core, js, NULL, 0, avoid_tunnel );
-                    cJSON_Delete( js );
-                    return ret;
-                }
+        if( mcu->tunnel->passive_tunnel ){                                    // <! Passive Tunnel
+            if( ! mcu->tunnel->tunnel_enabled ){                                // <! Tunnel Disabled
+                goto UNLOCK;                                                      // <! We don't send anything outside
+            }
+        }
+    
+        if( all_support & KERNEL_CAP_BIN_FRAME ){
+            ret = kernel_wire_send_mmap_req( snap, mcu, src_core, dst_core, avoid_tunnel );
+            goto UNLOCK;
+        }
 
-                cJSON_Delete(js); 
-                return false;
+    /*************************************************************************
+     *                                                                        *
+     *          -------------------------------------------------             *
+     *         |                                                 |            *
+     *         |        Process mmap request  From JSON          |            *
+     *         |                                                 |            *
+     *          -------------------------------------------------             *
+     * mmap_sync_req                                                          *
+     * {                                                                      *
+     *     "src_core": "nRF52840",                                            *
+     *     "dst_core": "PSoc6_M0",                                            *
+     * }                                                                      *
+     *                                                                        *
+     *************************************************************************/
+    
+        bool arena = kernel_pass_json_enter();
+        cJSON *js = cJSON_CreateObject();
+        if( js != NULL ){
+            cJSON *mmap_js = cJSON_CreateObject();
+            if( mmap_js != NULL ){
+                cJSON_AddItemToObject( js, "mmap_sync_req", mmap_js );
+                
+                cJSON_AddStringToObject( mmap_js, "src_core", src_core );      // <! source from
+                cJSON_AddStringToObject( mmap_js, "dst_core", dst_core );      // <! source from
+                
+                ret = kernel_router_json( mcu->tunnel, js, NULL, 0, avoid_tunnel );
             }
+
+            cJSON_Delete( js );
+            kernel_pass_json_leave( arena );
+            goto UNLOCK;
         }
-        mcu = mcu->next;
+        kernel_pass_json_leave( arena );
     }
-    WARNING( "src_core [%s] not found", src_core );
-    return false;
+
+    UNLOCK:
+    kernel_route_read_unlock( epoch );
+    return ret;
 }
 
 /**
@@ -379,6 +869,31 @@ static bool kernel_mmap_check_unsync_core(int32_t timeout_set){
     return true;
 }
 
+/**
+ *  @brief next run of changed bytes against prev_sync_mem, compared by KERNEL_MMAP_BLOCK
+ * 
+ *  @param [in] offset : search from, end of previous run
+ *  @param [out] offset : start of run
+ *  @return length of run, 0 if nothing changed after offset
+ **/
+static int32_t kernel_mmap_dirty_run(const struct kernel_mmap_t *p, int32_t *offset){
+    const uint8_t *cur = (const uint8_t *)p->mem, *prev = (const uint8_t *)p->prev_sync_mem;
+    int32_t size = p->mem_size;
+    int32_t pos  = (*offset + KERNEL_MMAP_BLOCK - 1) / KERNEL_MMAP_BLOCK * KERNEL_MMAP_BLOCK;   // <! rest of block of previous run is clean
+
+    while( (pos < size) && (memcmp(&cur[pos], &prev[pos], MIN(KERNEL_MMAP_BLOCK, size - pos)) == 0x0) ){ pos += KERNEL_MMAP_BLOCK; }
+    if( pos >= size ){ return 0; }
+
+    int32_t start = pos, end = pos;
+    while( cur[start] == prev[start] ){ start++; }
+    while( (end < size) && (memcmp(&cur[end], &prev[end], MIN(KERNEL_MMAP_BLOCK, size - end)) != 0x0) ){ end += KERNEL_MMAP_BLOCK; }
+    end = MIN( end, size );
+    while( cur[end - 1] == prev[end - 1] ){ end--; }
+
+    *offset = start;
+    return end - start;
+}
+
 /**
  *  @brief sync shared memory message of peer core to local when it has changed
  * 
@@ -416,6 +931,60 @@ static void kernel_mmap_update_from(const char core_name[], const char mem_name[
     }
 }
 
+/**
+ *  @brief kernel_mmap_update_from for changed runs only, whole region is requested
+ *         when there is no synced region to patch or runs do not fit
+ * 
+ *  @param [in] runs : value of WIRE_MEM_RUNS
+ *  @param [out]
+ *  @return 
+ **/
+static void kernel_mmap_patch_from(const char core_name[], const char mem_name[], const uint8_t *runs, int32_t length){
+    struct kernel_mmap_t *p = kernel_mmap_from_queue;
+    while( p != NULL ){
+        if( (strcmp(p->from_core, core_name) == 0x0) && (strcmp(p->mem_name, mem_name) == 0x0) &&
+            (is_mcu_exist(p->from_core) != NULL) ){
+            bool changed = false;
+            if( (! p->sync_already) || (! kernel_wire_apply_runs((uint8_t *)p->mem, p->mem_size, runs, length, &changed)) ){
+                WARNING( "mmap [%s] delta not applied, request whole region", mem_name );
+                kernel_mmap_request( p->from_core, get_my_core_name(), NULL );
+                return;
+            }
+            if( changed && (p->update_callback != NULL) ){
+                p->update_callback( p->arg, p->mem, p->mem_size );
+            }
+            return;
+        }
+        p = p->next;
+    }
+}
+
+/**
+ *  @brief kernel_mmap_update_from for hex digits of JSON frame, decoded straight into receiving space
+ * 
+ *  @param [in] hex : 2 * mem_size digits
+ *  @param [out]
+ *  @return false if no receiving space matched or digits broken
+ **/
+static bool kernel_mmap_update_from_hex(const char core_name[], const char mem_name[], const char *hex, int32_t mem_size){
+    struct kernel_mmap_t *p = kernel_mmap_from_queue;
+    while( p != NULL ){
+        if( (strcmp(p->from_core, core_name) == 0x0) && (strcmp(p->mem_name, mem_name) == 0x0) &&
+            (p->mem_size == mem_size) && (is_mcu_exist(p->from_core) != NULL) ){
+            int32_t ret = kernel_hex_decode_update( hex, (uint8_t *)p->mem, mem_size );
+            if( ret < 0 ){ return false; }
+
+            p->sync_already = true;
+            if( (ret > 0) && (p->update_callback != NULL) ){
+                p->update_callback( p->arg, p->mem, p->mem_size );
+            }
+            return true;
+        }
+        p = p->next;
+    }
+    return false;
+}
+
 /**
  *  @brief pack shared memory message of local core and send it out
  * 
@@ -432,80 +1001,89 @@ static bool kernel_mmap_outside(const char *src_core, const char *dst_core, cons
     if( mem_data == NULL ){ return false; }
     if( mem_size == 0x00 ){ return false; }
 
-    struct MCUs_t *mcu = kernel_mcu_queue;
-    while( mcu != NULL ){
-        if( strcmp(mcu->core, dst_core) == 0x0 ){
-            if( mcu->tunnel == avoid_tunnel ){ break; }                           // <! avoid same channel
-        
-            if( mcu->tunnel->passive_tunnel ){                                    // <! Passive Tunnel
-                if( ! mcu->tunnel->tunnel_enabled ){                                // <! Tunnel Disabled
-                    return false;                                                     // <! We don't send anything outside
-                }
+    uint32_t epoch;  bool ret = false;
+    const struct kernel_route_snap_t *snap = kernel_route_read_lock( &epoch );   // <! no lock against receive path
+    const struct kernel_route_core_t *mcu = kernel_route_snap_core( snap, dst_core );
+    if( (mcu != NULL) && (mcu->tunnel != NULL) ){
+        if( mcu->tunnel == avoid_tunnel ){ goto UNLOCK; }                         // <! avoid same channel
+    
+        if( mcu->tunnel->passive_tunnel ){                                    // <! Passive Tunnel
+            if( ! mcu->tunnel->tunnel_enabled ){                                // <! Tunnel Disabled
+                goto UNLOCK;                                                      // <! We don't send anything outside
             }
-      
-      /*************************************************************************
-      *                                                                        *
-      *          -------------------------------------------------             *
-      *         |                                                 |            *
-      *         |    Try to Sync kernel memory mapping  To JSON   |            *
-      *         |                                                 |            *
-      *          -------------------------------------------------             *
-      *                                                                        *
-      * {                                                                      *
-      *   "mmap": { "mmap_array": [ "BatteryStatus", "LockBody" ] },           *
-      *   "BatteryStatus": {                                                   *
-      *     "src_core": "nRF52840",                                            *
-      *     "dst_core": "PSoc6_M0",                                            *
-      *     "mem_size": 12,                                                    *
-      *     "mem_data": "hello world"                                          *
-      *   },                                                                   *
-      *   "LockBody": {                                                        *
-      *     "src_core": "nRF52840",                                            *
-      *     "dst_core": "PSoc6_M0",                                            *
-      *     "mem_size": 8,                                                     *
-      *     "mem_data": "hello world"                                          *
-      *   }                                                                    *
-      * }                                                                      *
-      *                                                                        *
-      *************************************************************************/
-      
-            cJSON *js = cJSON_CreateObject();
-            if( js != NULL ){
-                cJSON *mmap_js = cJSON_CreateObject();
-                if( mmap_js != NULL ){
-                    cJSON_AddItemToObject( js, "mmap", mmap_js );
-                
-                    cJSON *mmap_array = cJSON_CreateArray();
-                    if( mmap_array == NULL ){ goto DELETE_JSON; }
+        }
+  
+        if( all_support & KERNEL_CAP_BIN_FRAME ){
+            ret = kernel_wire_send_mmap( snap, mcu, src_core, dst_core, mem_name, mem_data, mem_size, avoid_tunnel );
+            goto UNLOCK;
+        }
+  
+  /*************************************************************************
+  *                                                                        *
+  *          -------------------------------------------------             *
+  *         |                                                 |            *
+  *         |    Try to Sync kernel memory mapping  To JSON   |            *
+  *         |                                                 |            *
+  *          -------------------------------------------------             *
+  *                                                                        *
+  * {                                                                      *
+  *   "mmap": { "mmap_array": [ "BatteryStatus", "LockBody" ] },           *
+  *   "BatteryStatus": {                                                   *
+  *     "src_core": "nRF52840",                                            *
+  *     "dst_core": "PSoc6_M0",                                            *
+  *     "mem_size": 12,                                                    *
+  *     "mem_data": "hello world"                                          *
+  *   },                                                                   *
+  *   "LockBody": {                                                        *
+  *     "src_core": "nRF52840",                                            *
+  *     "dst_core": "PSoc6_M0",                                            *
+  *     "mem_size": 8,                                                     *
+  *     "mem_data": "hello world"                                          *
+  *   }                                                                    *
+  * }                                                                      *
+  *                                                                        *
+  *************************************************************************/
+  
+        bool arena = kernel_pass_json_enter();
+        cJSON *js = cJSON_CreateObject();
+        if( js != NULL ){
+            cJSON *mmap_js = cJSON_CreateObject();
+            if( mmap_js != NULL ){
+                cJSON_AddItemToObject( js, "mmap", mmap_js );
+            
+                cJSON *mmap_array = cJSON_CreateArray();
+                if( mmap_array == NULL ){ goto DELETE_JSON; }
 
-                    cJSON_AddItemToObject( mmap_js, "mmap_array", mmap_array );
-                    cJSON_AddItemToArray( mmap_array, cJSON_CreateString(mem_name) );
-                
-                    cJSON *mem_obj = cJSON_CreateObject();
-                    if( mem_obj != NULL ){
-                        cJSON_AddItemToObject( mmap_js, mem_name, mem_obj );
+                cJSON_AddItemToObject( mmap_js, "mmap_array", mmap_array );
+                cJSON_AddItemToArray( mmap_array, cJSON_CreateString(mem_name) );
+            
+                cJSON *mem_obj = cJSON_CreateObject();
+                if( mem_obj != NULL ){
+                    cJSON_AddItemToObject( mmap_js, mem_name, mem_obj );
 
-                        cJSON_AddStringToObject( mem_obj, "src_core", src_core );      // <! source from
-                        cJSON_AddStringToObject( mem_obj, "dst_core", dst_core );      // <! source from
-                        cJSON_AddNumberToObject( mem_obj, "mem_size", mem_size );      // <! source from
-                
-                        cJSON_AddItemToObject( mem_obj, (const char *)"mem_data", 
-                        cJSON_CreateHexString((uint8_t *)mem_data, mem_size) );
-                
-                        bool ret = kernel_router_json( mcu->core, js, NULL, 0, avoid_tunnel );
-                        cJSON_Delete( js );
-                        return ret;
-                    }
+                    cJSON_AddStringToObject( mem_obj, "src_core", src_core );      // <! source from
+                    cJSON_AddStringToObject( mem_obj, "dst_core", dst_core );      // <! source from
+                    cJSON_AddNumberToObject( mem_obj, "mem_size", mem_size );      // <! source from
+            
+                    cJSON_AddItemToObject( mem_obj, (const char *)"mem_data", 
+                    kernel_hex_json((uint8_t *)mem_data, mem_size) );
+            
+                    ret = kernel_router_json( mcu->tunnel, js, NULL, 0, avoid_tunnel );
+                    cJSON_Delete( js );
+                    kernel_pass_json_leave( arena );
+                    goto UNLOCK;
                 }
-
-                DELETE_JSON:
-                cJSON_Delete(js); 
-                return false;
             }
+
+            DELETE_JSON:
+            cJSON_Delete(js); 
         }
-        mcu = mcu->next;
+        kernel_pass_json_leave( arena );
     }
-    return false;
+
+    UNLOCK:
+    kernel_route_read_unlock( epoch );
+    return ret;
 }
 
 /**
@@ -528,7 +1106,15 @@ static bool kernel_mmap_update_to(const char target_core[], bool diff_sync){
         }
 
         if( diff_sync ){
-            if( memcmp(p->mem, p->prev_sync_mem, p->mem_size) == 0x0 ){
+            int32_t offset = 0;
+            if( kernel_mmap_dirty_run(p, &offset) == 0 ){
+                p = p->next;
+                continue;
+            }
+            if( (all_support & KERNEL_CAP_MMAP_DELTA) && (p->delta_count < KERNEL_MMAP_FULL_EVERY) &&
+                kernel_wire_send_mmap_delta(p, get_my_core_name()) ){          // <! prev_sync_mem patched by runs sent
+                p->delta_count++;
+                ret = true;
                 p = p->next;
                 continue;
             }
@@ -539,6 +1125,7 @@ static bool kernel_mmap_update_to(const char target_core[], bool diff_sync){
 
         if( ! ret ){ break; }
         memcpy( p->prev_sync_mem, p->mem, p->mem_size );
+        p->delta_count = 0;
 
         p = p->next;
     }
@@ -559,8 +1146,12 @@ static void kernel_delete_mcu(const char *core_name){
     if( p != NULL ){
         struct kernel_external_task_t *t = NULL;
 
-        while( NULL != (t = p->task_queue) ){ UNMOUNT(p->task_queue, t); x_free(t); }
+        while( NULL != (t = p->task_queue) ){ kernel_route_remove(t); UNMOUNT(p->task_queue, t); x_free(t); }
+        if( p->task_by_id != NULL ){ x_free( p->task_by_id ); }
+        if( kernel_id_mcu(p->id) == p ){ kernel_mcu_by_id[ p->id - 1 ] = NULL; }
+        kernel_link_path_free( p );
         UNMOUNT( kernel_mcu_queue, p );     x_free(p);
+        kernel_route_changed();
     }
 }
 
@@ -571,8 +1162,11 @@ static struct MCUs_t * kernel_create_mcu(const char *core_name, struct comm_tunn
         memset( p, 0x0, sizeof(struct MCUs_t) + strlen(core_name) + 1 );
         p->tunnel = tunnel;
         p->jump   = jump;
+        p->hash   = kernel_name_hash( core_name );
+        p->sync_mark = KERNEL_SYNC_MARK_DIRTY;
         strcpy( p->core, core_name );
         MOUNT( kernel_mcu_queue, p );
+        kernel_route_changed();
     }
     return p;
 }
@@ -583,6 +1177,8 @@ bool kernel_change_mcu_tunnel(struct MCUs_t *mcu, struct comm_tunnel_t *tunnel,
 
     mcu->tunnel = tunnel;
     mcu->jump   = jump;
+    mcu->sync_mark |= KERNEL_SYNC_MARK_DIRTY;
+    kernel_route_changed();
     return true;
 }
 
@@ -591,14 +1187,159 @@ static struct kernel_external_task_t * kernel_is_task_on_mcu(struct MCUs_t *mcu,
     ASSERT_NULL( mcu );
     ASSERT_NULL( task_name );
 
+    uint32_t hash = kernel_name_hash( task_name );
     struct kernel_external_task_t *t = mcu->task_queue;
     while( t != NULL ){
-        if( strcmp(t->task_name, task_name) == 0x0 ){ break; }
+        if( (t->hash == hash) && (strcmp(t->task_name, task_name) == 0x0) ){ break; }
         t = t->next;
     }
     return t;
 }
 
+/**
+ *  @brief find aimed task on any mcu, instead of walking every task list
+ * 
+ *  @param [in] 
+ *  @param [out]
+ *  @return external task, its mcu is the route
+ **/
+static struct kernel_external_task_t * kernel_route_find(const char *task_name){
+    if( task_name == NULL ){ return NULL; }
+
+    uint32_t hash = kernel_name_hash( task_name );
+    struct kernel_external_task_t *t = kernel_route_table[ hash & (KERNEL_ROUTE_BUCKETS - 1) ];
+    while( t != NULL ){
+        if( (t->hash == hash) && (strcmp(t->task_name, task_name) == 0x0) ){ break; }
+        t = t->route_next;
+    }
+    return t;
+}
+
+static void kernel_route_insert(struct MCUs_t *mcu, struct kernel_external_task_t *t){
+    struct kernel_external_task_t **b = &kernel_route_table[ t->hash & (KERNEL_ROUTE_BUCKETS - 1) ];
+    while( *b != NULL ){ b = &(*b)->route_next; }       // <! keep first added on top, same as walking MCUs
+    t->mcu        = mcu;
+    t->route_next = NULL;
+    *b            = t;
+    kernel_route_changed();
+}
+
+static void kernel_route_remove(struct kernel_external_task_t *t){
+    struct kernel_external_task_t **b = &kernel_route_table[ t->hash & (KERNEL_ROUTE_BUCKETS - 1) ];
+    while( *b != NULL ){
+        if( *b == t ){ *b = t->route_next;  break; }
+        b = &(*b)->route_next;
+    }
+    t->route_next = NULL;
+    kernel_route_changed();
+
+    struct MCUs_t *mcu = t->mcu;                        // <! drop id index as well
+    if( (mcu != NULL) && (t->id != 0) && (t->id <= mcu->task_id_size) && (mcu->task_by_id[t->id - 1] == t) ){
+        mcu->task_by_id[ t->id - 1 ] = NULL;
+    }
+}
+
+/**
+ *  @brief give task the id assigned by its owner core
+ * 
+ *  @param [in] 
+ *  @param [out]
+ *  @return 
+ **/
+static bool kernel_task_id_bind(struct MCUs_t *mcu, struct kernel_external_task_t *t, uint16_t id){
+    if( id == 0 ){ return false; }
+    if( id > mcu->task_id_size ){
+        uint16_t size = (mcu->task_id_size != 0)?(mcu->task_id_size):(8);
+        while( size < id ){ size *= 2; }
+
+        struct kernel_external_task_t **index = (struct kernel_external_task_t **)x_malloc( size * sizeof(struct kernel_external_task_t *) );
+        if( index == NULL ){ return false; }
+        memset( index, 0x0, size * sizeof(struct kernel_external_task_t *) );
+        if( mcu->task_by_id != NULL ){
+            memcpy( index, mcu->task_by_id, mcu->task_id_size * sizeof(struct kernel_external_task_t *) );
+            x_free( mcu->task_by_id );
+        }
+        mcu->task_by_id   = index;
+        mcu->task_id_size = size;
+    }
+
+    if( (t->id != 0) && (t->id <= mcu->task_id_size) && (mcu->task_by_id[t->id - 1] == t) ){
+        mcu->task_by_id[ t->id - 1 ] = NULL;            // <! owner renumbered the task
+    }
+    t->id = id;
+    mcu->task_by_id[ id - 1 ] = t;
+    kernel_route_changed();
+    return true;
+}
+
+/**
+ *  @brief give core the id heard from task list sync, core holding the id before
+ *         loses it and waits for a new one
+ * 
+ *  @param [in] 
+ *  @param [out]
+ *  @return 
+ **/
+static bool kernel_mcu_id_bind(struct MCUs_t *mcu, uint16_t id){
+    if( id == 0 ){ return false; }
+    if( id > kernel_mcu_id_size ){
+        uint16_t size = (kernel_mcu_id_size != 0)?(kernel_mcu_id_size):(8);
+        while( size < id ){ size = (size < 0x8000)?(size * 2):(0xFFFF); }
+
+        struct MCUs_t **index = (struct MCUs_t **)x_malloc( size * sizeof(struct MCUs_t *) );
+        if( index == NULL ){ return false; }
+        memset( index, 0x0, size * sizeof(struct MCUs_t *) );
+        if( kernel_mcu_by_id != NULL ){
+            memcpy( index, kernel_mcu_by_id, kernel_mcu_id_size * sizeof(struct MCUs_t *) );
+            x_free( kernel_mcu_by_id );
+        }
+        kernel_mcu_by_id   = index;
+        kernel_mcu_id_size = size;
+    }
+
+    struct MCUs_t *o = kernel_mcu_by_id[ id - 1 ];
+    if( (o != NULL) && (o != mcu) ){ o->id = 0; }                  // <! id moved, owner core renumbers it
+    if( kernel_id_mcu(mcu->id) == mcu ){ kernel_mcu_by_id[ mcu->id - 1 ] = NULL; }
+
+    mcu->id = id;
+    mcu->sync_mark |= KERNEL_SYNC_MARK_DIRTY;                        // <! announce the new id
+    kernel_mcu_by_id[ id - 1 ] = mcu;
+    if( id > kernel_mcu_id_last ){ kernel_mcu_id_last = id; }
+    kernel_route_changed();
+    return true;
+}
+
+/**
+ *  @brief core of the smallest name owns core ids, it hands them out and never takes
+ *         "CoreId" from others, the others take them from task list sync
+ * 
+ *  @param [in] 
+ *  @param [out]
+ *  @return 
+ **/
+static bool kernel_mcu_id_owner(void){
+    struct MCUs_t *owner = NULL;
+    for( struct MCUs_t *p = kernel_mcu_queue; p != NULL; p = p->next ){
+        if( (owner == NULL) || (strcmp(p->core, owner->core) < 0) ){ owner = p; }
+    }
+    return (owner != NULL) && owner->is_local;
+}
+
+/**
+ *  @brief owner of core ids gives cores without one the next id, ids are never reused
+ * 
+ *  @param [in] 
+ *  @param [out]
+ *  @return 
+ **/
+static void kernel_mcu_id_assign(void){
+    if( ! kernel_mcu_id_owner() ){ return; }
+
+    for( struct MCUs_t *p = kernel_mcu_queue; p != NULL; p = p->next ){
+        if( (p->id == 0) && (kernel_mcu_id_last < 0xFFFF) ){ kernel_mcu_id_bind( p, kernel_mcu_id_last + 1 ); }
+    }
+}
+
 static struct kernel_external_task_t * kernel_add_task_to_mcu(struct MCUs_t *mcu, const char *task_name){
     ASSERT_NULL( mcu );
     ASSERT_NULL( task_name );
@@ -606,14 +1347,26 @@ static struct kernel_external_task_t * kernel_add_task_to_mcu(struct MCUs_t *mcu
     struct kernel_external_task_t *t = kernel_is_task_on_mcu( mcu, task_name );
     if( t == NULL ){
         t = (struct kernel_external_task_t *)x_malloc( sizeof(struct kernel_external_task_t) + strlen(task_name) + 1 );
+        if( t == NULL ){ return NULL; }
         memset( t, 0x0, sizeof(struct kernel_external_task_t) + strlen(task_name) + 1 );
         strcpy( t->task_name, task_name );
+        t->hash = kernel_name_hash( task_name );
 
         MOUNT( mcu->task_queue, t );
+        kernel_route_insert( mcu, t );
+        mcu->sync_mark |= KERNEL_SYNC_MARK_DIRTY;
     }
     return t;
 }
 
+static void kernel_remove_task_from_mcu(struct MCUs_t *mcu, struct kernel_external_task_t *t){
+    kernel_route_remove( t );
+    UNMOUNT( mcu->task_queue, t );
+    x_free( t );
+    mcu->task_modified = true;
+    mcu->sync_mark |= KERNEL_SYNC_MARK_DIRTY;
+}
+
 /**
  *  @brief update task list
  * 
@@ -639,13 +1392,7 @@ bool kernel_recover_external_task_on_tunnel(struct comm_tunnel_t *tunnel, char *
                     cJSON *js_jump = cJSON_GetObjectItem( core, "Jump" );
                     if( NULL != (mcu = kernel_create_mcu(core_name, tunnel,  (js_jump)?(js_jump->valueint):(1) )) ){
                         mcu->tunnel = tunnel;
-                        cJSON *js_extra_support = cJSON_GetObjectItem( core, "SupportJsonExtra" );
-                        if( (js_extra_support != NULL) && (mcu != NULL) ){
-                            switch( js_extra_support->type ){
-                                case cJSON_True : mcu->support_json_extra = true;   break;
-                                default         : mcu->support_json_extra = false;  break;
-                            }
-                        }
+                        mcu->caps = kernel_cap_from_json( core, NULL );
 
                         cJSON *task_array = cJSON_GetObjectItem( core, "TaskArray" );
                         if( task_array == NULL ){ continue; }
@@ -668,6 +1415,7 @@ bool kernel_recover_external_task_on_tunnel(struct comm_tunnel_t *tunnel, char *
             }
         }
         cJSON_Delete( js );
+        kernel_route_publish();
         return true;
     }
     return false;
@@ -679,10 +1427,9 @@ static bool kernel_clear_cache_task_on_mcu(struct MCUs_t *mcu){
     struct kernel_external_task_t *t = mcu->task_queue;
     while( t != NULL ){
         if( t->cached ){                                      // <! Remove the Old cache
-            mcu->task_modified = true;
             struct kernel_external_task_t *n = t->next;
-            UNMOUNT( mcu->task_queue, t );
-            x_free( t );  t = n;  continue;
+            kernel_remove_task_from_mcu( mcu, t );
+            t = n;  continue;
         }
         t = t->next;
     }
@@ -765,7 +1512,7 @@ CREATE_BACKUP_FILE :
             cJSON_AddItemToObject( js, mcu->core, core );
             
             cJSON_AddNumberToObject( core , "Jump" , mcu->jump );     // <! Better to backup Jump point
-            cJSON_AddBoolToObject( core , "SupportJsonExtra" , mcu->support_json_extra );
+            kernel_cap_to_json( core, mcu->caps );
             
             cJSON *task_array = cJSON_CreateArray();
             if( task_array == NULL ){ goto ERR; }
@@ -800,6 +1547,33 @@ CREATE_BACKUP_FILE :
     cJSON_Delete( js );     return NULL;
 }
 
+/**
+ *  @brief send a copy of frame out of every enabled tunnel of local core
+ * 
+ *  @param [in] avoid_tunnel : frame came from, NULL for none
+ *  @param [out]
+ *  @return 
+ **/
+static void kernel_send_to_local_tunnels(const uint8_t *frame, int32_t length, struct comm_tunnel_t *avoid_tunnel){
+    struct MCUs_t *mcu = kernel_mcu_queue;
+    while( mcu != NULL ){
+        if( mcu->is_local ){
+            struct comm_tunnel_t *tunnel = mcu->tunnel;
+            while( tunnel != NULL ){
+                if( (tunnel != avoid_tunnel) && ((!tunnel->passive_tunnel) || (tunnel->passive_tunnel & tunnel->tunnel_enabled)) ){
+                    uint8_t *dup = (uint8_t *)x_malloc( length );        // <! freed by tunnel
+                    if( dup != NULL ){
+                        memcpy( dup, frame, length );
+                        kernel_tx_control( tunnel, dup, length );
+                    }
+                }
+                tunnel = tunnel->next;
+            } break;
+        }
+        mcu = mcu->next;
+    }
+}
+
 /**
  *  @brief sync tasks and tunnels of cores
  * 
@@ -834,18 +1608,50 @@ void synchonize_tasklist(const char local_core[], int tunnel_num, ...){
                 va_end( args );
         
                 mcu->is_local = true;
-                mcu->support_json_extra = true;
+                mcu->caps = KERNEL_CAP_JSON_EXTRA | KERNEL_CAP_BIN_FRAME | KERNEL_CAP_CREDIT |
+                            KERNEL_CAP_ROUTE_HEAD | KERNEL_CAP_LINK_COST | KERNEL_CAP_DELTA_SYNC |
+                            (( KERNEL_BATCH_SIZE > 0 )?(KERNEL_CAP_BATCH):(0)) |
+                            (( KERNEL_LZ_MIN_SIZE > 0 )?(KERNEL_CAP_LZ):(0)) |
+                            (( KERNEL_MMAP_FULL_EVERY > 0 )?(KERNEL_CAP_MMAP_DELTA):(0)) |
+                            (( KERNEL_HEX_JSON > 0 )?(KERNEL_CAP_HEX_TEXT):(0)) |
+                            KERNEL_CAP_IDS;
             }
         }
 
         if( mcu != NULL ){
+            bool changed = false;
             struct kernel_task_t *t = kernel_task_queue;
             while( t != NULL ){
-                kernel_add_task_to_mcu( mcu, t->task_name );
+                struct kernel_external_task_t *task = kernel_add_task_to_mcu( mcu, t->task_name );
+                if( (task != NULL) && (task->id == 0) ){
+                    kernel_task_id_bind( mcu, task, mcu->task_id_last + 1 );      // <! ids are never reused
+                    mcu->task_id_last = task->id;
+                    kernel_delta_log( task->task_name, task->id, false, mcu->version + 1 );
+                    changed = true;
+                }
                 t = t->next;
             }
+
+            struct kernel_external_task_t *task = mcu->task_queue;
+            while( task != NULL ){                                              // <! tasks deleted since last sync
+                struct kernel_external_task_t *n = task->next;
+                t = kernel_task_queue;
+                while( (t != NULL) && (strcmp(t->task_name, task->task_name) != 0) ){ t = t->next; }
+                if( t == NULL ){
+                    kernel_delta_log( task->task_name, task->id, true, mcu->version + 1 );
+                    kernel_remove_task_from_mcu( mcu, task );
+                    changed = true;
+                }
+                task = n;
+            }
+            if( changed ){ mcu->version++; }
         }
     }
+
+    struct MCUs_t *local = kernel_mcu_queue;
+    while( (local != NULL) && (! local->is_local) ){ local = local->next; }
+    kernel_mcu_id_assign();                             // <! packed below as "CoreId"
+    kernel_route_publish();                             // <! senders see local ids from now on
   
   /*************************************************************************
   *                                                                        *
@@ -879,8 +1685,23 @@ void synchonize_tasklist(const char local_core[], int tunnel_num, ...){
   *                                                                        *
   *************************************************************************/
 
+    if( (all_support & KERNEL_CAP_DELTA_SYNC) && kernel_delta_synchonize(local) ){ return; }
+
+    kernel_delta_clear_marks( local );                  // <! every core is sent
+
+    if( all_support & KERNEL_CAP_BIN_FRAME ){
+        int32_t frame_length = 0;
+        uint8_t *frame = kernel_wire_pack_cores( &frame_length, 0 );
+        if( frame != NULL ){
+            kernel_send_to_local_tunnels( frame, frame_length, NULL );
+            kernel_pass_free( frame );
+            return;
+        }
+    }
+
+    bool arena = kernel_pass_json_enter();
     cJSON *js = cJSON_CreateObject();
-    if( js == NULL ){ return; }
+    if( js == NULL ){ kernel_pass_json_leave( arena );  return; }
 
     cJSON *cores_array = cJSON_CreateArray();
     if( cores_array == NULL ){ goto ERR; }
@@ -904,8 +1725,20 @@ void synchonize_tasklist(const char local_core[], int tunnel_num, ...){
         cJSON_AddItemToObject( js, mcu->core, core );
 
         cJSON_AddNumberToObject( core , "Jump" , mcu->jump + 1 );
+        cJSON_AddNumberToObject( core , "Cost" , (mcu->is_local)?(0):(mcu->cost) );
+        if( kernel_link_via(mcu) != 0 ){
+            cJSON_AddNumberToObject( core , "Via" , kernel_link_via(mcu) );
+        }
+
+        kernel_cap_to_json( core, mcu->caps );
+        if( mcu->id != 0 ){
+            cJSON_AddNumberToObject( core , "CoreId" , mcu->id );
+        }
+        cJSON_AddNumberToObject( core , "Version" , mcu->version );
 
-        cJSON_AddBoolToObject( core , "SupportJsonExtra" , mcu->support_json_extra );
+        cJSON *task_ids = cJSON_CreateArray();                          // <! TaskIds[n] is id of TaskArray[n]
+        if( task_ids == NULL ){ goto ERR; }
+        cJSON_AddItemToObject( core, "TaskIds", task_ids );
 
         cJSON *task_array = cJSON_CreateArray();
         if( task_array == NULL ){ goto ERR; }
@@ -916,6 +1749,7 @@ void synchonize_tasklist(const char local_core[], int tunnel_num, ...){
             cJSON *task_item = cJSON_CreateString( task->task_name );
             if( task_item == NULL ){ goto ERR; }
             cJSON_AddItemToArray( task_array, task_item );
+            cJSON_AddItemToArray( task_ids, cJSON_CreateNumber(task->id) );
             task = task->next;
         }
         mcu = mcu->next;
@@ -936,31 +1770,17 @@ void synchonize_tasklist(const char local_core[], int tunnel_num, ...){
     if( jsString != NULL ){
         cJSON_Delete( js );    //LOG( "%s\r\n", jsString );
 
-        mcu = kernel_mcu_queue;
-        while( mcu != NULL ){
-            if( mcu->is_local ){
-                struct comm_tunnel_t *tunnel = mcu->tunnel;
-                while( tunnel != NULL ){
-                    if( (!tunnel->passive_tunnel) || (tunnel->passive_tunnel & tunnel->tunnel_enabled) ){
-                        layer_proc_func_list *proc = tunnel->send_proc;
-                
-                        char *dup_jsString = __strdup__( jsString );
-                        if( dup_jsString != NULL ){
-                            int32_t sent_length = proc[0].func( &proc[1], tunnel, (uint8_t *)dup_jsString, strlen(jsString) + 1 );
-                        }
-                    }
-                    tunnel = tunnel->next;
-                } break;
-            }
-            mcu = mcu->next;
-        }
-        x_free( jsString );
+        kernel_send_to_local_tunnels( (uint8_t *)jsString, strlen(jsString) + 1, NULL );
+        kernel_pass_free( jsString );
+        kernel_pass_json_leave( arena );
         return;
     }
 
 ERR:
     WARNING( "Synchonize Task Failed" );
-    cJSON_Delete( js );     return;
+    cJSON_Delete( js );
+    kernel_pass_json_leave( arena );
+    return;
 }
 
 /**
@@ -993,61 +1813,79 @@ static bool try_post_msg_outside(const char *target_task, struct kernel_msg_t *m
   *   }                                                                    *
   *                                                                        *
   *************************************************************************/
-    struct MCUs_t *mcu = kernel_mcu_queue;
-    while( mcu != NULL ){
-        struct kernel_external_task_t *t = kernel_is_task_on_mcu( mcu, target_task );
-        if( t != NULL ){
-            LOG( "Found [%s] on core[%s], try post msg\r\n", t->task_name, mcu->core );
-        
-            bool support_json_extra = all_support_json_extra;
-        
-            kernel_mmap_update_to( mcu->core, true );                                     // <! update mmap before post msg
+    uint32_t epoch;
+    const struct kernel_route_snap_t *snap = kernel_route_read_lock( &epoch );  // <! no lock against receive path
+    const struct kernel_route_t *t = kernel_route_snap_find( snap, target_task );
+    if( (t != NULL) && (! t->mcu->is_local) ){
+        const struct kernel_route_core_t *mcu = t->mcu;
+        LOG( "Found [%s] on core[%s], try post msg\r\n", t->task_name, mcu->core );
+    
+        bool support_json_extra = ( (all_support & KERNEL_CAP_JSON_EXTRA) != 0 );
+        int32_t length = 0;
+        char *data = (char *)msg_payload( &msg->msg, &length );                       // <! driver buffer of reference msg
+    
+        kernel_mmap_update_to( mcu->core, true );                                     // <! update mmap before post msg
+
+        if( all_support & KERNEL_CAP_BIN_FRAME ){
+            bool ret = kernel_wire_send_msg( t, kernel_route_snap_find(snap, src_task), msg, src_task, data, length );
+            kernel_route_read_unlock( epoch );
+            return ret;
+        }
 
-            cJSON *js = cJSON_CreateObject();
-            if( js != NULL ){
-                cJSON *msg_js = cJSON_CreateObject();
-                if( msg_js != NULL ){
-                    cJSON_AddItemToObject( js, "msg", msg_js );
+        bool arena = kernel_pass_json_enter();
+        cJSON *js = cJSON_CreateObject();
+        if( js != NULL ){
+            cJSON *msg_js = cJSON_CreateObject();
+            if( msg_js != NULL ){
+                cJSON_AddItemToObject( js, "msg", msg_js );
 
-                    cJSON_AddStringToObject( msg_js, "targ_task", t->task_name );             // <! target task name
-                    if( msg->msg.notification != NULL ){
-                        cJSON_AddStringToObject( msg_js, "notify", msg->msg.notification );     // <! notification
-                    }
-                    if( msg->msg.length > 0 ){
-                        if( str_verify(msg->msg.data, msg->msg.length) == msg->msg.length ){    // <! this is string
-                            cJSON_AddStringToObject( msg_js, "data", msg->msg.data );     
-                        }else{                                                                  // <! this is hex data
-                            if( support_json_extra ){
-                                cJSON_AddItemToObject( msg_js, (const char *)"data", cJSON_CreateHexString(NULL, 0) );
-                            }else{
-                                cJSON_AddItemToObject( msg_js, (const char *)"data", cJSON_CreateHexString((uint8_t *)msg->msg.data, msg->msg.length) );
-                            }
+                cJSON_AddStringToObject( msg_js, "targ_task", t->task_name );             // <! target task name
+                if( msg->msg.notification != NULL ){
+                    cJSON_AddStringToObject( msg_js, "notify", msg->msg.notification );     // <! notification
+                }
+                if( length > 0 ){
+                    if( (! msg->msg_ref) && (str_verify(data, length) == length) &&
+                        (! ((all_support & KERNEL_CAP_HEX_TEXT) && kernel_hex_prefixed(data, length))) ){   // <! this is string, not mistaken for hex text
+                        cJSON_AddStringToObject( msg_js, "data", data );     
+                    }else{                                                                  // <! this is hex data
+                        if( support_json_extra ){
+                            cJSON_AddItemToObject( msg_js, (const char *)"data", kernel_hex_json(NULL, 0) );
+                        }else{
+                            cJSON_AddItemToObject( msg_js, (const char *)"data", kernel_hex_json((uint8_t *)data, length) );
                         }
                     }
-                    if( src_task != NULL ){
-                        cJSON_AddStringToObject( msg_js, "src_task", src_task );                // <! source task name
-                    }
-            
-                    if( msg->timer.enable ){
-                        cJSON_AddStringToObject( msg_js, "timer", "enable" );                   // <! timer
-            
-                        cJSON_AddNumberToObject( msg_js, "delay", msg->timer.delay );           // <! timer delay time
-                        cJSON_AddNumberToObject( msg_js, "preodic", msg->timer.preodic );       // <! timer preodic call time
-                        cJSON_AddNumberToObject( msg_js, "cnt", msg->timer.cnt );               // <! timer preodic call count
+                }
+                if( src_task != NULL ){
+                    cJSON_AddStringToObject( msg_js, "src_task", src_task );                // <! source task name
+                }
+                if( msg->call_id != 0 ){
+                    cJSON_AddNumberToObject( msg_js, "call_id", msg->call_id );             // <! correlation id of call
+                    if( msg->call_reply ){
+                        cJSON_AddBoolToObject( msg_js, "call_reply", true );                // <! reply of call
                     }
                 }
         
-                bool ret = false;
-                if( support_json_extra ){ ret = kernel_router_json( mcu->core, js, msg->msg.data, msg->msg.length, NULL ); }
-                else                    { ret = kernel_router_json( mcu->core, js, NULL,          0,               NULL ); }
+                if( msg->timer.enable ){
+                    cJSON_AddStringToObject( msg_js, "timer", "enable" );                   // <! timer
         
-                cJSON_Delete( js );
-                return ret;
+                    cJSON_AddNumberToObject( msg_js, "delay", msg->timer.delay );           // <! timer delay time
+                    cJSON_AddNumberToObject( msg_js, "preodic", msg->timer.preodic );       // <! timer preodic call time
+                    cJSON_AddNumberToObject( msg_js, "cnt", msg->timer.cnt );               // <! timer preodic call count
+                }
             }
-            break;
+    
+            bool ret = false;
+            if( support_json_extra ){ ret = kernel_router_json( mcu->tunnel, js, data,        length,          NULL ); }
+            else                    { ret = kernel_router_json( mcu->tunnel, js, NULL,        0,               NULL ); }
+    
+            cJSON_Delete( js );
+            kernel_pass_json_leave( arena );
+            kernel_route_read_unlock( epoch );
+            return ret;
         }
-        mcu = mcu->next;
+        kernel_pass_json_leave( arena );
     }
+    kernel_route_read_unlock( epoch );
 
     /*************************************************************************
     *                                                                        *
@@ -1064,14 +1902,291 @@ static bool try_post_msg_outside(const char *target_task, struct kernel_msg_t *m
     return false;
 }
 
-int32_t kernel_msg_layer_unpack(layer_proc_func_list *proc, void *arg, uint8_t *data, int32_t length){
+/*************************************************************************
 
-    if( data == NULL ){ return length; }
-    if( length == 0 ) { return length; }
-    if( proc == NULL ){ return length; }
-    struct comm_tunnel_t *tunnel = (struct comm_tunnel_t *)arg;
+           -------------------------------------------------
+          |                                                 |
+          |    Receive Handlers shared by JSON and Binary   |
+          |                                                 |
+           -------------------------------------------------
+
+*************************************************************************/
+
+struct kernel_recv_msg_t {
+    struct kernel_external_task_t *target;              // <! resolved by id, NULL: resolve target_task by name
+    const char                    *target_task;
+    const char                    *src_task;
+    const char                    *notification;
+    const char                    *data;                // <! NULL: no data
+    int32_t                       length;               // <! 0: string data, > 0: binary data, < 0: broken data, drop msg
+    bool                          timer;
+    int32_t                       delay;
+    int32_t                       preodic;
+    int32_t                       cnt;
+    uint32_t                      call_id;
+    bool                          call_reply;
+};
+
+struct kernel_recv_cores_t {
+    struct comm_tunnel_t          *tunnel;
+    uint32_t                      peer_sum;
+    bool                          list_changed;
+};
+
+struct kernel_recv_core_t {                             // <! -1 when not carried
+    const char                    *core_name;
+    int32_t                       jump;
+    uint16_t                      caps;                   // <! KERNEL_CAP_xxx carried true
+    uint16_t                      caps_known;             // <! KERNEL_CAP_xxx carried, 0 when not carried
+    int32_t                       core_id;
+    int32_t                       cost;
+    int32_t                       via;
+    int64_t                       version;
+};
+
+/**
+ *  @brief post msg locally, or router raw frame to core of target task
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+static void kernel_recv_msg(struct comm_tunnel_t *tunnel, const struct kernel_recv_msg_t *m, const uint8_t *raw_data, int32_t raw_length){
+    if( m->target_task == NULL ){ return; }
+
+    struct kernel_external_task_t *t = (m->target != NULL)?(m->target):(kernel_route_find(m->target_task));
+    if( t == NULL ){ return; }
+    struct MCUs_t *dst_mcu = t->mcu;
+
+    if( dst_mcu->is_local ){                            // <! local mcu, post locally
+        xMsgHandler kmsg = NULL;
+        if( m->data == NULL ){
+            kmsg = new_msg( m->notification );
+        }else if( m->length == 0 ){
+            kmsg = new_msg( m->notification, (char *)m->data );
+        }else if( m->length > 0 ){
+            kmsg = new_msg( m->notification, (char *)m->data, m->length );
+        }
+        if( kmsg == NULL ){ return; }
+
+        if( m->timer ){
+            kmsg = msg_set_timer( kmsg, m->delay, m->preodic, m->cnt );
+        }
+        if( (kmsg != NULL) && (m->call_id != 0) ){
+            ((struct kernel_msg_t *)kmsg)->call_id    = m->call_id;
+            ((struct kernel_msg_t *)kmsg)->call_reply = m->call_reply;
+        }
+        if( (kmsg != NULL) && (! m->timer) ){           // <! periodic timer msg never leaves task, not held
+            ((struct kernel_msg_t *)kmsg)->rx_tunnel  = tunnel;
+            kernel_tx_rx_hold( tunnel );
+        }
+        if( kmsg != NULL ){
+            post_msg( m->target_task, kmsg, m->src_task );
+        }
+    }else{                                              // <! non local task, router outside
+        if( is_tunnel_available(kernel_aquire_tunnel_by_core(dst_mcu->core), dst_mcu->core, m->target_task, m->notification) ){
+            uint8_t *router_data = (uint8_t *)x_malloc( raw_length );
+            if( router_data != NULL ){
+                memcpy( router_data, raw_data, raw_length );
+                kernel_router_raw( dst_mcu->core, router_data, raw_length, tunnel );     // <! Router Total Msg
+            }
+        }
+    }
+}
+
+static void kernel_recv_mmap(struct comm_tunnel_t *tunnel, const char *src_core, const char *dst_core,
+                             const char *mem_name, void *mem_data, int32_t mem_size){
+    const char *local_core = get_my_core_name();
+    if( (local_core == NULL) || (src_core == NULL) || (dst_core == NULL) ){ return; }
+
+    if( strcmp(dst_core, local_core) == 0x0 ){          // <! destination is me
+        kernel_mmap_update_from( src_core, mem_name, mem_data, mem_size );
+        LOG( "mmap update from (%s), %s[%d]\r\n", src_core, mem_name, mem_size );
+    }else{                                              // <! Destination is not me, pass it on
+        kernel_mmap_outside( src_core, dst_core, mem_name, mem_data, mem_size, tunnel );
+    }
+}
+
+static void kernel_recv_mmap_sync_req(struct comm_tunnel_t *tunnel, const char *src_core, const char *dst_core){
+    const char *local_core = get_my_core_name();
+    if( (local_core == NULL) || (src_core == NULL) || (dst_core == NULL) ){ return; }
+
+    if( strcmp(src_core, local_core) == 0x0 ){
+        kernel_mmap_update_to( dst_core, false );
+    }else{
+        kernel_mmap_request( src_core, dst_core, tunnel );
+    }
+}
+
+static void kernel_recv_cores_begin(struct kernel_recv_cores_t *ctx, struct comm_tunnel_t *tunnel){
+    ctx->tunnel       = tunnel;
+    ctx->peer_sum     = 0;
+    ctx->list_changed = false;
+}
+
+static void kernel_recv_core_init(struct kernel_recv_core_t *c, const char *core_name){
+    c->core_name   = core_name;
+    c->jump        = -1;
+    c->caps        = 0;
+    c->caps_known  = 0;
+    c->core_id     = -1;
+    c->cost        = -1;
+    c->via         = -1;
+    c->version     = -1;
+}
+
+/**
+ *  @brief version of task list carried with core
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return false: carried list is not newer than known one, tasks are skipped
+ **/
+static bool kernel_recv_core_version(struct kernel_recv_cores_t *ctx, struct MCUs_t *mcu, const struct kernel_recv_core_t *c, bool created){
+    if( (mcu == NULL) || (c->version < 0) ){ return true; }
+
+    uint32_t version = (uint32_t)c->version;
+    if( mcu->is_local ){
+        if( (int32_t)(version - mcu->version) > 0 ){        // <! rebooted, peers hold newer version of me
+            kernel_delta_rebase( mcu, version + 1 );
+            ctx->list_changed = true;
+        }
+        return true;
+    }
+    if( (all_support & KERNEL_CAP_DELTA_SYNC) && (! created) ){
+        if( (int32_t)(version - mcu->version) <= 0 ){ return false; }     // <! stale or known already
+        for( struct kernel_external_task_t *t = mcu->task_queue; t != NULL; t = t->next ){
+            t->cached = true;                               // <! list of owner version replaces the old one
+        }
+    }
+    mcu->version = version;
+    return true;
+}
+
+/**
+ *  @brief create or re-route core from peer task list
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return mcu, NULL if failed or task list is to be skipped
+ **/
+static struct MCUs_t * kernel_recv_core(struct kernel_recv_cores_t *ctx, const struct kernel_recv_core_t *c){
+    const char *core_name = c->core_name;  int32_t jump = (c->jump >= 0)?(c->jump):(1);
+    int32_t cost = kernel_link_announced( c->cost, jump, c->via );
+    str_chksum( &ctx->peer_sum, core_name );
+    if( jump == 1 ){ kernel_link_peer( ctx->tunnel, c->core_id ); }
+
+    bool created = false;
+    struct MCUs_t *mcu = is_mcu_exist( core_name );
+    if( mcu == NULL ){
+        if( NULL != (mcu = kernel_create_mcu(core_name, ctx->tunnel, jump)) ){
+            kernel_link_path_update( mcu, ctx->tunnel, cost, jump );
+            kernel_link_select( mcu );
+            kernel_mmap_update_to( core_name, false );          // <! update mmap when core created
+            mcu->task_modified = true;
+            ctx->list_changed  = true;
+            created = true;
+            if( jump == 1 ){ kernel_delta_mark_all(); }         // <! new neighbour gets every core
+        }
+    }else if( kernel_link_path_update(mcu, ctx->tunnel, cost, jump) && kernel_link_select(mcu) ){
+        kernel_mmap_update_to( core_name, false );              // <! update mmap when tunnel changed
+        mcu->task_modified = true;
+        ctx->list_changed  = true;
+    }
+
+    if( (mcu != NULL) && (! mcu->is_local) ){
+        uint16_t kept = KERNEL_CAP_KEPT & ~c->caps_known;
+        mcu->caps = (mcu->caps & kept) | (c->caps & ~kept);
+    }
+    if( (mcu != NULL) && (c->core_id > 0) && (c->core_id <= 0xFFFF) && (mcu->id != c->core_id) && (! kernel_mcu_id_owner()) ){
+        kernel_mcu_id_bind( mcu, (uint16_t)c->core_id );             // <! local core takes its id as well
+        ctx->list_changed = true;                                   // <! pass the id on
+    }
+    return kernel_recv_core_version( ctx, mcu, c, created )?(mcu):(NULL);
+}
+
+/**
+ *  @brief add task of peer core
+ *
+ *  @param [in] task_id : id assigned by owner core, -1 when not carried
+ *  @param [out]
+ *  @return
+ **/
+static void kernel_recv_core_task(struct kernel_recv_cores_t *ctx, struct MCUs_t *mcu, const char *task_name, int32_t task_id){
+    if( mcu == NULL ){ return; }
+
+    struct kernel_external_task_t *task = NULL;
+    if( NULL == (task = kernel_is_task_on_mcu(mcu, task_name)) ){
+        task = kernel_add_task_to_mcu( mcu, task_name );
+        mcu->task_modified = true;
+        ctx->list_changed  = true;
+    }
+    if( task != NULL ){ task->cached = false; }       // <! if Task Existed or Newly created, Mark as non-cached
+    if( (task != NULL) && (! mcu->is_local) && (task_id > 0) && (task_id <= 0xFFFF) && (task->id != task_id) ){
+        kernel_task_id_bind( mcu, task, (uint16_t)task_id );
+    }
+    str_chksum( &ctx->peer_sum, task_name );
+}
+
+static void kernel_recv_core_end(struct kernel_recv_cores_t *ctx, struct MCUs_t *mcu){
+    if( mcu != NULL ){ kernel_clear_cache_task_on_mcu( mcu ); }
+}
+
+static void kernel_recv_cores_end(struct kernel_recv_cores_t *ctx){
+    if( (! (all_support & KERNEL_CAP_DELTA_SYNC)) && (ctx->peer_sum != get_local_sync_list_chksum()) ){   // <! partial list in delta mode
+        ctx->list_changed = true;
+    }
+
+    if( ctx->list_changed ){
+        LOG( "list %s\r\n", (ctx->list_changed)?"changed":"unchange" );
+        synchonize_tasklist( NULL, 0 );
+        kernel_mmap_check_unsync_core( 300 );                 // <! when list_changed, check unsync after 300ms
+    }
+
+    uint16_t caps = 0xFFFF;
+    struct MCUs_t *p = kernel_mcu_queue;                      // <! Check what ALL cores support
+    while( p != NULL ){
+        caps &= p->caps;
+        p = p->next;
+    }
+    if( ! (caps & KERNEL_CAP_IDS) ){ caps &= ~KERNEL_CAP_ROUTE_HEAD; }             // <! routing header carries core id
+    if( ! (caps & KERNEL_CAP_BIN_FRAME) ){ caps &= KERNEL_CAP_JSON; }               // <! the others live in binary frame
+    all_support = caps;
+
+    draw_topo_layer( kernel_mcu_queue, 0 );
+}
+
+/**
+ *  @brief locate hex data carried outside of JSON (see kernel_router_json)
+ *
+ *  @param [in]
+ *  @param [out] extra_length
+ *  @return NULL if not carried or broken
+ **/
+static const uint8_t * kernel_json_extra_data(const uint8_t *raw_data, int32_t length, int32_t *extra_length){
+    int extra_len = length - ( strlen((const char *)raw_data) + 1 );                // <! Measure extra length
+    if( extra_len < (int)sizeof(struct json_extra_data_t) ){ return NULL; }        // <! Length Validation
+
+    struct json_extra_data_t *ex = (struct json_extra_data_t *)&raw_data[ strlen((const char *)raw_data) + 1 ];
+    if( ex->data_type != cJSON_HexString ){ return NULL; }                         // <! Data Type Confirmation
+    if( ex->length > extra_len - (sizeof(struct json_extra_data_t) - sizeof(((struct json_extra_data_t *)0)->data)) ){ return NULL; }
+    if( ex->length <= 0 ){ return NULL; }
+
+    *extra_length = ex->length;
+    return (const uint8_t *)ex->data;                                               // <! Data Extration
+}
 
+/**
+ *  @brief unpack JSON frame by cJSON DOM, used when KERNEL_JSON_SCAN is disabled
+ *         or the scanner leaves frame to cJSON
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+static int32_t kernel_json_dom_unpack(struct comm_tunnel_t *tunnel, uint8_t *data, int32_t length){
     uint8_t *raw_data = data;
+    bool arena = kernel_pass_json_enter();
     cJSON *js = cJSON_Parse( (char *)data );
     if( js != NULL ){
 
@@ -1094,89 +2209,45 @@ int32_t kernel_msg_layer_unpack(layer_proc_func_list *proc, void *arg, uint8_t *
     *************************************************************************/
         cJSON *msg_js = cJSON_GetObjectItem( js, "msg" );
         if( msg_js != NULL ){
-            xMsgHandler kmsg = NULL;
-            char *target_task = NULL, *notification = NULL, *data = NULL, *src_task = NULL;   cJSON *o = NULL;
-
-            if( NULL != (o = cJSON_GetObjectItem(msg_js, "targ_task")) ){ target_task = o->valuestring;  }
-            if( NULL != (o = cJSON_GetObjectItem(msg_js, "src_task")) ) { src_task = o->valuestring;     }
-            if( NULL != (o = cJSON_GetObjectItem(msg_js, "notify")) )   { notification = o->valuestring; }
-            if( NULL != (o = cJSON_GetObjectItem(msg_js, "data")) )     { data = o->valuestring;         }
-      
-            struct MCUs_t *dst_mcu = kernel_mcu_queue;
-            while( dst_mcu != NULL ){
-                struct kernel_external_task_t *t = kernel_is_task_on_mcu( dst_mcu, target_task );
-                if( t != NULL ){ break; }
-                dst_mcu = dst_mcu->next;
-            }
-            if( dst_mcu != NULL ){
-                if( dst_mcu->is_local ){                // <! local mcu, post locally
-                    if( o == NULL ){
-                        kmsg = new_msg(notification);
-                        //post_msg( target_task, new_msg(notification) );
-                        //LOG( "post_msg(%s, new_msg(%s));\r\n", target_task, notification );
-                    }else{
-                        switch( o->type ){
-                            case cJSON_String    :  
-                                if( data != NULL ){
-                                    kmsg = new_msg(notification, data);
-                                        //post_msg( target_task, new_msg(notification, data) );
-                                        //LOG( "post_msg(%s, new_msg(%s, %s));\r\n", target_task, notification, data );
-                                    } break;
-              
-                            case cJSON_HexString :  ;
-                                int32_t len  = o->valueint;
-                                if( len == 0 ){                                             // <! Extra data carry ouside of JSON.
-                                    int extra_len = length - ( strlen((char *)raw_data) + 1 );        // <! Measure extra length
-                                    if( extra_len >= (int)sizeof(struct json_extra_data_t) ){       // <! Length Validation
-                                        struct json_extra_data_t *ex = (struct json_extra_data_t *)&raw_data[ strlen((char *)raw_data) + 1 ];
-                                        if( ex->data_type == cJSON_HexString ){                 // <! Data Type Confirmation
-                                            if( ex->length <= extra_len - (sizeof(struct json_extra_data_t) - sizeof(((struct json_extra_data_t *)0)->data)) ){
-                                                data = (char *)ex->data;                                    // <! Data Extration
-                                                len  = ex->length;
-                                            }
-                                        }
-                                    }
-                                }else{
-                                    data = (char *)cJSON_hexassemble( o->valuestring );       // <! Hex Converted Data Method
-                                }
-                                if( (data != NULL) && (len > 0) ){
-                                    kmsg = new_msg(notification, data, len);
-                                    //LOG( "post_msg(%s, new_msg(%s, %s, %d));\r\n", target_task, notification, data, len );
-                                    if( o->valueint > 0 ){                                    // <! Hex Converted Data Method
-                                        x_free( data );
-                                    }
-                                } break;
-                        }
-                    }
-          
-                    if( NULL != (o = cJSON_GetObjectItem(msg_js, "timer")) ){
-                        int32_t delay = 0, preodic = -1, cnt = -1;
-                        if( NULL != (o = cJSON_GetObjectItem(msg_js, "delay")) )  { delay = o->valueint;   }
-                        if( NULL != (o = cJSON_GetObjectItem(msg_js, "preodic")) ){ preodic = o->valueint; }
-                        if( NULL != (o = cJSON_GetObjectItem(msg_js, "cnt")) )    { cnt = o->valueint;     }
-            
-                        if( kmsg != NULL ){
-                            kmsg = msg_set_timer( kmsg, delay, preodic, cnt );
-                        }
-                    }
-                    if( kmsg != NULL ){
-                        post_msg( target_task, kmsg, src_task );
-                    }
-                }else{                                      // <! non local task, router outside
-                    if( is_tunnel_available(kernel_aquire_tunnel_by_core(dst_mcu->core), dst_mcu->core, target_task, notification) ){
-                        uint8_t *router_data = (uint8_t *)x_malloc( length );
-                        if( router_data != NULL ){
-                            memcpy( router_data, raw_data, length );
-                            kernel_router_raw( dst_mcu->core, router_data, length, tunnel );     // <! Router Total Msg
-                        }
-                    }
+            struct kernel_recv_msg_t m;   cJSON *o = NULL;
+            memset( &m, 0x0, sizeof(struct kernel_recv_msg_t) );
+            char *hex_data = NULL;
+
+            if( NULL != (o = cJSON_GetObjectItem(msg_js, "targ_task")) ){ m.target_task = o->valuestring;  }
+            if( NULL != (o = cJSON_GetObjectItem(msg_js, "src_task")) ) { m.src_task = o->valuestring;     }
+            if( NULL != (o = cJSON_GetObjectItem(msg_js, "notify")) )   { m.notification = o->valuestring; }
+            if( NULL != (o = cJSON_GetObjectItem(msg_js, "data")) ){
+                int32_t len = 0;
+                m.data = "";  m.length = -1;                                        // <! drop msg unless data extracted
+                if( NULL != (hex_data = (char *)kernel_hex_json_bytes(o, &len)) ){   // <! hex text or cJSON_HexString, see kernel_hex.c
+                    m.data = hex_data;  m.length = len;
+                }else if( len == 0 ){                                               // <! Extra data carry ouside of JSON.
+                    const uint8_t *ex = kernel_json_extra_data( raw_data, length, &len );
+                    if( ex != NULL ){ m.data = (const char *)ex;  m.length = len; }
+                }else if( (o->type == cJSON_String) && (o->valuestring != NULL) ){
+                    m.data = o->valuestring;  m.length = 0;
                 }
-            } 
+            }
+
+            if( NULL != (o = cJSON_GetObjectItem(msg_js, "timer")) ){
+                m.timer = true;   m.delay = 0;   m.preodic = -1;   m.cnt = -1;
+                if( NULL != (o = cJSON_GetObjectItem(msg_js, "delay")) )  { m.delay = o->valueint;   }
+                if( NULL != (o = cJSON_GetObjectItem(msg_js, "preodic")) ){ m.preodic = o->valueint; }
+                if( NULL != (o = cJSON_GetObjectItem(msg_js, "cnt")) )    { m.cnt = o->valueint;     }
+            }
+            if( NULL != (o = cJSON_GetObjectItem(msg_js, "call_id")) ){
+                m.call_id = (uint32_t)o->valuedouble;
+                o = cJSON_GetObjectItem( msg_js, "call_reply" );
+                m.call_reply = (o != NULL) && (o->type == cJSON_True);
+            }
+
+            kernel_recv_msg( tunnel, &m, raw_data, length );
+            if( hex_data != NULL ){ kernel_pass_free( hex_data ); }
         }
-    
+
         const char *local_core = get_my_core_name();
         if( local_core != NULL ){
-      
+
       /*************************************************************************
       *                                                                        *
       *          -------------------------------------------------             *
@@ -1202,52 +2273,40 @@ int32_t kernel_msg_layer_unpack(layer_proc_func_list *proc, void *arg, uint8_t *
       * }                                                                      *
       *                                                                        *
       *************************************************************************/
-      
+
             cJSON *mmap_js = cJSON_GetObjectItem( js, "mmap" );
             if( mmap_js ){
                 cJSON *mmap_array = cJSON_GetObjectItem( mmap_js, "mmap_array" );
                 if( mmap_array != NULL ){
                     int mmap_num = cJSON_GetArraySize( mmap_array );
-            
+
                     for( int i=0; i<mmap_num; i++ ){
                         char *mem_name = cJSON_GetArrayItem(mmap_array, i)->valuestring;
                         cJSON *mem_obj = cJSON_GetObjectItem( mmap_js, mem_name );
                         if( mem_obj == NULL ){ continue; }
-                
+
                         char *src_core = NULL, *dst_core = NULL;    cJSON *o = NULL;
                         int mem_size = 0;
-                
+
                         if( NULL != (o = cJSON_GetObjectItem(mem_obj, "src_core")) ){ src_core = o->valuestring; }
                         if( NULL != (o = cJSON_GetObjectItem(mem_obj, "dst_core")) ){ dst_core = o->valuestring; }
                         if( NULL != (o = cJSON_GetObjectItem(mem_obj, "mem_size")) ){ mem_size = o->valueint;    }
-                
-                        char *mem_data = NULL;
-                        if( NULL != (o = cJSON_GetObjectItem(mem_obj, "mem_data")) ){ mem_data = o->valuestring; }
-                        switch( o->type ){
-                            case cJSON_HexString :  
-                                mem_data = (char *)cJSON_hexassemble( o->valuestring );
-                                int32_t len  = o->valueint;
-                                if( (mem_data == NULL) || (len <= 0) ){
-                                    WARNING( "mem_data NULL or length <= 0" );  continue;
-                                }
-                                if( len != mem_size ){
-                                    WARNING( "mmap size not match" );  continue;
-                                } break;
-                            default :  
-                                WARNING( "mmap type Error!!!" );   continue;
+
+                        char *mem_data = NULL;  int32_t len = 0;
+                        if( NULL == (o = cJSON_GetObjectItem(mem_obj, "mem_data")) ){ continue; }
+                        if( NULL == (mem_data = (char *)kernel_hex_json_bytes(o, &len)) ){     // <! hex text or cJSON_HexString
+                            WARNING( "mmap type Error!!!" );   continue;
                         }
-                
-                        if( strcmp(dst_core, local_core) == 0x0 ){      // <! destination is me
-                            kernel_mmap_update_from( src_core, mem_name, mem_data, mem_size );
-                            LOG( "mmap update from (%s), %s[%d]\r\n", src_core, mem_name, mem_size );
-                        }else{                                        // <! Destination is not me, pass it on
-                            kernel_mmap_outside( src_core, dst_core, mem_name, mem_data, mem_size, tunnel );
+                        if( len != mem_size ){
+                            WARNING( "mmap size not match" );  kernel_pass_free( mem_data );  continue;
                         }
-                        x_free( mem_data );
+
+                        kernel_recv_mmap( tunnel, src_core, dst_core, mem_name, mem_data, mem_size );
+                        kernel_pass_free( mem_data );
                     }
                 }
             }
-        
+
         /*************************************************************************
          *                                                                        *
         *          -------------------------------------------------             *
@@ -1262,23 +2321,17 @@ int32_t kernel_msg_layer_unpack(layer_proc_func_list *proc, void *arg, uint8_t *
         * }                                                                      *
         *                                                                        *
         *************************************************************************/
-        
+
             cJSON *mmap_req = cJSON_GetObjectItem( js, "mmap_sync_req" );
             if( mmap_req ){
                 char *src_core = NULL, *dst_core = NULL;    cJSON *o = NULL;
-            
+
                 if( NULL != (o = cJSON_GetObjectItem(mmap_req, "src_core")) ){ src_core = o->valuestring; }
                 if( NULL != (o = cJSON_GetObjectItem(mmap_req, "dst_core")) ){ dst_core = o->valuestring; }
-            
-                if( (dst_core != NULL) && (src_core != NULL) ){
-                    if( strcmp(src_core, get_my_core_name()) == 0x0 ){
-                        kernel_mmap_update_to( dst_core, false );
-                    }else{
-                        kernel_mmap_request( src_core, dst_core, tunnel );
-                    }
-                }
+
+                kernel_recv_mmap_sync_req( tunnel, src_core, dst_core );
             }
-        
+
         /*************************************************************************
          *                                                                        *
         *          -------------------------------------------------             *
@@ -1310,99 +2363,101 @@ int32_t kernel_msg_layer_unpack(layer_proc_func_list *proc, void *arg, uint8_t *
         *   }                                                                    *
         *                                                                        *
         *************************************************************************/
-        
-            bool list_changed = false;
-            uint32_t peer_sum = 0;
-        
+
             cJSON *cores_array = cJSON_GetObjectItem( js, "Cores" );
             if( cores_array != NULL ){
+                struct kernel_recv_cores_t ctx;
+                kernel_recv_cores_begin( &ctx, tunnel );
+
                 int core_num = cJSON_GetArraySize( cores_array );
                 for( int i=0; i<core_num; i++ ){
-            
+
                     char *core_name = cJSON_GetArrayItem(cores_array, i)->valuestring;
                     cJSON *core = cJSON_GetObjectItem( js, core_name );
                     if( core == NULL ){ continue; }
-                    str_chksum( &peer_sum, core_name );
 
                     cJSON *task_array = cJSON_GetObjectItem( core, "TaskArray" );
-                    if( task_array == NULL ){ continue; }
+                    if( task_array == NULL ){ str_chksum( &ctx.peer_sum, core_name );  continue; }
                     int task_num = cJSON_GetArraySize( task_array );
-            
-                    cJSON *js_jump = cJSON_GetObjectItem( core, "Jump" );
-            
-                    struct MCUs_t *mcu = is_mcu_exist( core_name );
-                    if( mcu == NULL ){
-                        if( NULL != (mcu = kernel_create_mcu(core_name, tunnel,  (js_jump)?(js_jump->valueint):(1) )) ){
-                            kernel_mmap_update_to( core_name, false );       // <! update mmap when core created
-                            mcu->task_modified = true;
-                            list_changed = true;
-                        }
-                    }else{
-                        if( js_jump != NULL ){
-                            int jump = js_jump->valueint;
-                            if( jump < mcu->jump ){
-                                if( kernel_change_mcu_tunnel(mcu, tunnel, jump) ){
-                                    kernel_mmap_update_to( core_name, false );   // <! update mmap when tunnel changed
-                                    mcu->task_modified = true;
-                                    list_changed = true;
-                                }
-                            }
-                        }
-                    }
-            
-                    cJSON *js_extra_support = cJSON_GetObjectItem( core, "SupportJsonExtra" );
-                    if( (js_extra_support != NULL) && (mcu != NULL) ){
-                        switch( js_extra_support->type ){
-                            case cJSON_True : mcu->support_json_extra = true;   break;
-                            default         : mcu->support_json_extra = false;  break;
-                        }
-                    }
 
-                    if( mcu != NULL ){
-                        for( int n=0; n<task_num; n++ ){
-                            char *task_name = cJSON_GetArrayItem(task_array, n)->valuestring;
-                            struct kernel_external_task_t *task = NULL;
-                            if( NULL == (task = kernel_is_task_on_mcu(mcu, task_name)) ){
-                                task = kernel_add_task_to_mcu( mcu, task_name );
-                                mcu->task_modified = true;
-                                list_changed = true;
-                            }
-                            if( task != NULL ){ task->cached = false; }       // <! if Task Existed or Newly created, Mark as non-cached
-                            str_chksum( &peer_sum, task_name );
-                        }
-                        kernel_clear_cache_task_on_mcu( mcu );
+                    struct kernel_recv_core_t c;    cJSON *o = NULL;
+                    kernel_recv_core_init( &c, core_name );
+                    if( NULL != (o = cJSON_GetObjectItem(core, "Jump")) )            { c.jump = o->valueint;                             }
+                    c.caps = kernel_cap_from_json( core, &c.caps_known );
+                    if( NULL != (o = cJSON_GetObjectItem(core, "CoreId")) )          { c.core_id = o->valueint;                          }
+                    if( NULL != (o = cJSON_GetObjectItem(core, "Cost")) )            { c.cost = o->valueint;                             }
+                    if( NULL != (o = cJSON_GetObjectItem(core, "Via")) )             { c.via = o->valueint;                              }
+                    if( NULL != (o = cJSON_GetObjectItem(core, "Version")) )         { c.version = (int64_t)o->valuedouble;              }
+                    cJSON *task_ids = cJSON_GetObjectItem( core, "TaskIds" );
+
+                    struct MCUs_t *mcu = kernel_recv_core( &ctx, &c );
+                    for( int n=0; (mcu != NULL) && (n<task_num); n++ ){
+                        cJSON *id = (task_ids != NULL)?(cJSON_GetArrayItem(task_ids, n)):(NULL);
+                        kernel_recv_core_task( &ctx, mcu, cJSON_GetArrayItem(task_array, n)->valuestring, (id != NULL)?(id->valueint):(-1) );
                     }
+                    kernel_recv_core_end( &ctx, mcu );
                 }
-            
-                if( peer_sum != get_local_sync_list_chksum() ){
-                    list_changed = true;
-                }
-            
-                if( list_changed ){
-                    LOG( "list %s\r\n", (list_changed)?"changed":"unchange" );
-                    synchonize_tasklist( NULL, 0 );
-                    kernel_mmap_check_unsync_core( 300 );                 // <! when list_changed, check unsync after 300ms
-                }
-            
-                {
-                bool is_all_support = true;
-                struct MCUs_t *p = kernel_mcu_queue;                  // <! Check if ALL support json extra_data
-                while( p != NULL ){
-                    if( ! p->support_json_extra ){
-                        is_all_support = false;
-                    } p = p->next;
-                }
-                all_support_json_extra = is_all_support;
-                }
-            
-                draw_topo_layer( kernel_mcu_queue, 0 );
+                kernel_recv_cores_end( &ctx );
             }
-
-            cJSON_Delete( js );
         }
+        cJSON_Delete( js );
     }
+    kernel_pass_json_leave( arena );
     return 0;
 }
 
+/**
+ *  @brief unpack one frame, JSON or binary, also called for each part of batch frame
+ * 
+ *  @param [in] 
+ *  @param [out]
+ *  @return 
+ **/
+static int32_t kernel_frame_unpack(struct comm_tunnel_t *tunnel, uint8_t *data, int32_t length){
+    if( data[0] == KERNEL_WIRE_MAGIC ){                 // <! binary frame, see kernel_wire.c
+        return kernel_wire_unpack( tunnel, data, length );
+    }
+    #if ( KERNEL_JSON_SCAN > 0 )
+    if( kernel_json_scan_unpack(tunnel, data, length) >= 0 ){ return 0; }
+    #endif
+    return kernel_json_dom_unpack( tunnel, data, length );          // <! hex data of unknown print, see kernel_json_scan.c
+}
+
+int32_t kernel_msg_layer_unpack(layer_proc_func_list *proc, void *arg, uint8_t *data, int32_t length){
+
+    if( data == NULL ){ return length; }
+    if( length == 0 ) { return length; }
+    if( proc == NULL ){ return length; }
+    struct comm_tunnel_t *tunnel = (struct comm_tunnel_t *)arg;
+
+    kernel_tx_consumed( tunnel, data, length );        // <! credit returned at the end of pass
+    kernel_link_rx( tunnel );
+    int32_t ret = kernel_frame_unpack( tunnel, data, length );
+    kernel_route_publish();                             // <! topology may be changed by frame
+    return ret;
+}
+
+/**
+ *  @brief same as kernel_msg_layer_unpack, but data (x_malloc) is owned by kernel from now on,
+ *         so routed frame for other core is passed on in the same buffer
+ * 
+ *  @param [in] 
+ *  @param [out]
+ *  @return 
+ **/
+int32_t kernel_msg_layer_take(layer_proc_func_list *proc, void *arg, uint8_t *data, int32_t length){
 
+    if( data == NULL ){ return length; }
+    if( (length == 0) || (proc == NULL) ){ x_free( data );  return length; }
+    struct comm_tunnel_t *tunnel = (struct comm_tunnel_t *)arg;
 
+    bool taken = false;  int32_t ret = 0;
+    kernel_tx_consumed( tunnel, data, length );
+    kernel_link_rx( tunnel );
+    if( ! kernel_wire_relay(tunnel, data, length, &taken) ){
+        ret = kernel_frame_unpack( tunnel, data, length );
+    }
+    kernel_route_publish();
+    if( ! taken ){ x_free( data ); }
+    return ret;
+}
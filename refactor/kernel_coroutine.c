@@ -0,0 +1,189 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/*************************************************************************
+
+           -------------------------------------------------
+          |                                                 |
+          |       Stackless Coroutine Task (protothread)    | 
+          |                                                 |
+           -------------------------------------------------
+
+  task_state audio_body(struct kernel_co_t *co, struct msg_t *msg, void *frame){
+      struct audio_frame_t *f = frame;              // <! locals don't survive await, keep in frame
+      CO_BEGIN( co );
+          CO_AWAIT_MSG( co, "audio_play" );
+          f->retry = 3;
+          CO_AWAIT_CALL( co, "codec_task", new_msg("codec_on"), 100 );
+          if( CO_CALL_FAILED(co) || CO_CALL_TIMEOUT(msg) ){ CO_EXIT( co ); }
+          CO_AWAIT_DELAY( co, 20 );
+          ...
+      CO_END( co );
+  }
+  create_co_task( "audio_task", audio_body, NULL, sizeof(struct audio_frame_t), 3 );
+
+ Note:
+ 1.msg not awaited while coroutine is waiting will be dropped, counted and
+   reported once per scheduler pass
+ 2.CO_AWAIT_DELAY use the timer of task, only one timer msg is allowed per task
+ 3.msg is valid until next await
+ 4.CO_AWAIT_CALL does not wait when call is not sent, check CO_CALL_FAILED
+   before msg, msg is still the one resumed previous await then
+
+*************************************************************************/
+
+#ifndef KERNEL_CO_TIMER_NOTIFY
+#define KERNEL_CO_TIMER_NOTIFY          "co_timer"      // <! notification used by CO_AWAIT_DELAY
+#endif
+
+enum {
+    CO_WAIT_NONE = 0,                   // <! not started or finished, any msg starts the body
+    CO_WAIT_ANY,
+    CO_WAIT_MSG,
+    CO_WAIT_TIMER,
+    CO_WAIT_CALL,
+};
+
+struct kernel_co_t {
+    int32_t                       lc;                     // <! local continuation, line to resume
+    int32_t                       wait;                   // <! awaited event
+    const char                    *await_notify;          // <! awaited notification of CO_WAIT_MSG
+    uint32_t                      await_call;             // <! awaited call id of CO_WAIT_CALL
+    const char                    *this_task;
+    task_state (*body)(struct kernel_co_t *co, struct msg_t *msg, void *frame);
+    void                          *arg;
+    #if defined (DISABLE_NON_ZERO_ARRAY)
+    uint64_t                      frame[1];               // <! [1] Special for ARMCC which Not support ZeroArray
+    #else
+    uint64_t                      frame[0];               // <! per-task frame, alloc in same ram space
+    #endif
+};
+
+static uint32_t kernel_co_drop = 0;                     // <! msg not awaited, reported by kernel_co_maintain
+static uint32_t kernel_co_drop_reported = 0;
+
+typedef task_state (*co_task_body)(struct kernel_co_t *co, struct msg_t *msg, void *frame);
+
+#define CO_BEGIN(co)                    switch( (co)->lc ){ case 0:
+#define CO_END(co)                      } (co)->lc = 0;  (co)->wait = CO_WAIT_NONE;  return TASK_IDLE
+#define CO_EXIT(co)                     do{ (co)->lc = 0;  (co)->wait = CO_WAIT_NONE;  return TASK_IDLE; }while(0)
+
+#define __CO_WAIT(co, w)                (co)->wait = (w);  (co)->lc = __LINE__;  return TASK_IDLE;  case __LINE__:
+
+#define CO_AWAIT_ANY(co)                do{ __CO_WAIT(co, CO_WAIT_ANY) ; }while(0)
+#define CO_AWAIT_MSG(co, notify)        do{ (co)->await_notify = (notify);  __CO_WAIT(co, CO_WAIT_MSG) ; }while(0)
+#define CO_AWAIT_DELAY(co, ms)          do{ if( kernel_co_sleep(co, ms) ){ __CO_WAIT(co, CO_WAIT_TIMER) ; } }while(0)
+#define CO_AWAIT_CALL(co, target, m, timeout)                                             \
+        do{ (co)->await_call = __call_msg_from( target, m, (co)->this_task, timeout );    \
+            if( (co)->await_call != 0 ){ __CO_WAIT(co, CO_WAIT_CALL) ; } }while(0)
+#define CO_CALL_FAILED(co)              ( (co)->await_call == 0 )      // <! call not sent, nothing awaited
+#define CO_CALL_TIMEOUT(msg)            ( strcmp((msg)->notification, KERNEL_CALL_TIMEOUT_NOTIFY) == 0x0 )
+
+/**
+ *  @brief arm task timer to resume coroutine after ms
+ * 
+ *  @param [in]
+ *  @param [out]
+ *  @return 
+ **/
+static bool kernel_co_sleep(struct kernel_co_t *co, int32_t ms){
+    xMsgHandler m = __new_notification( KERNEL_CO_TIMER_NOTIFY );
+    if( m == NULL ){ return false; }
+    return __post_msg_from( co->this_task, msg_set_delay_timer(m, ms), NULL );
+}
+
+/**
+ *  @brief check whether msg is the event coroutine waiting for
+ * 
+ *  @param [in]
+ *  @param [out]
+ *  @return 
+ **/
+static bool kernel_co_is_awaited(const struct kernel_co_t *co, const struct msg_t *msg){
+    bool is_timer = (strcmp(msg->notification, KERNEL_CO_TIMER_NOTIFY) == 0x0);
+
+    switch( co->wait ){
+        case CO_WAIT_NONE  :
+        case CO_WAIT_ANY   : return ! is_timer;                       // <! stale timer won't resume body
+        case CO_WAIT_MSG   : return strcmp(msg->notification, co->await_notify) == 0x0;
+        case CO_WAIT_TIMER : return is_timer;
+        case CO_WAIT_CALL  : return msg_is_reply(msg) && (msg_call_id(msg) == co->await_call);
+        default            : return false;
+    }
+}
+
+static task_state kernel_co_entry(const char *this_task, struct msg_t *msg, void *arg){
+    struct kernel_co_t *co = (struct kernel_co_t *)arg;
+    (void)this_task;
+
+    if( ! kernel_co_is_awaited(co, msg) ){
+        kernel_co_drop++;                               // <! a burst would flood the log, count only
+        return TASK_IGNORE;
+    }
+    co->wait = CO_WAIT_NONE;
+    return co->body( co, msg, co->frame );
+}
+
+/**
+ *  @brief create coroutine task, body resumes at the awaited point when event arrived
+ * 
+ *  @param [in] frame_size: size of per-task frame which keep state between awaits
+ *  @param [out]
+ *  @return 
+ **/
+bool create_co_task( const char *task_name,
+                     co_task_body body,
+                     void *arg,
+                     int32_t frame_size,
+                     int32_t prio
+                     ){
+    ASSERT_NULL( task_name );
+    ASSERT_NULL( body );
+    ASSERT_TRUE( frame_size >= 0 );
+
+    struct kernel_co_t *co = (struct kernel_co_t *)x_malloc( sizeof(struct kernel_co_t) + frame_size );
+    if( co == NULL ){
+        WARNING( "No memory for co task[ %s ], create failed", task_name );
+        return false;
+    }
+    memset( co, 0x0, sizeof(struct kernel_co_t) + frame_size );
+    co->this_task = task_name;
+    co->body      = body;
+    co->arg       = arg;
+
+    if( ! create_task(task_name, kernel_co_entry, co, prio) ){
+        x_free( co );
+        return false;
+    }
+    return true;
+}
+
+/**
+ *  @brief report msg dropped by coroutine tasks, run in scheduler once per pass
+ * 
+ *  @param [in]
+ *  @param [out]
+ *  @return 
+ **/
+void kernel_co_maintain(void){
+    uint32_t drop = kernel_co_drop;
+    if( drop != kernel_co_drop_reported ){
+        LOG( "co task not waiting, %u msg Drop!\r\n", drop - kernel_co_drop_reported );
+        kernel_co_drop_reported = drop;
+    }
+}
+
+/**
+ *  @brief release coroutine frame when task deleted
+ * 
+ *  @param [in]
+ *  @param [out]
+ *  @return 
+ **/
+void kernel_co_task_release(struct kernel_task_t *t){
+    if( (t != NULL) && (t->callback == kernel_co_entry) ){
+        x_free( t->arg );
+        t->arg = NULL;
+    }
+}
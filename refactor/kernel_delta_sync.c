@@ -0,0 +1,425 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/*************************************************************************
+
+           -------------------------------------------------
+          |                                                 |
+          |        Versioned Delta Sync of Task Lists       |
+          |                                                 |
+           -------------------------------------------------
+
+ Note:
+ 1.each core owns "Version" of its task list, bumped once by every
+   synchonize_tasklist that added or removed local tasks, changes are kept
+   in a ring of KERNEL_DELTA_LOG_NUM entries
+ 2.when every core announced "SupportDeltaSync", synchonize_tasklist sends
+        KERNEL_WIRE_DELTA    : [core][WIRE_BASE][WIRE_VERSION] then
+                               [WIRE_TASK_ID][WIRE_TASK] for task added,
+                               [WIRE_TASK_DEL] for task removed
+   of local core, and task list of cores marked KERNEL_SYNC_MARK_DIRTY
+   (new core, new route, list changed) as KERNEL_WIRE_CORES, instead of
+   task list of every core
+ 3.delta is applied when its base is the version known here, then passed
+   on to other tunnels as it is; known version is dropped, so floods end.
+   base mismatch or unknown core is answered by KERNEL_WIRE_SYNC_REQ to
+   the tunnel it came from, peer replies delta from the base when its ring
+   still covers it, otherwise the whole task list
+ 4.KERNEL_WIRE_DIGEST of (core, version) is sent every
+   KERNEL_DELTA_DIGEST_MS, cores behind are requested the same way, so lost
+   deltas are repaired
+ 5.rebooted core starts from version 0: a newer version of itself heard
+   from peers moves it past that version and its whole list is sent
+
+*************************************************************************/
+
+#ifndef KERNEL_DELTA_LOG_NUM
+#define KERNEL_DELTA_LOG_NUM            32              // <! changes of local task list kept for peers behind
+#endif
+
+#ifndef KERNEL_DELTA_DIGEST_MS
+#define KERNEL_DELTA_DIGEST_MS          5000            // <! 0 to disable digest
+#endif
+
+struct kernel_delta_entry_t {
+    uint32_t                      version;              // <! local version the change belongs to
+    uint16_t                      task_id;
+    bool                          removed;
+    char                          *task_name;           // <! __strdup__
+};
+
+static struct kernel_delta_entry_t kernel_delta_ring[ KERNEL_DELTA_LOG_NUM ];
+static int32_t  kernel_delta_head  = 0;                 // <! oldest entry
+static int32_t  kernel_delta_count = 0;
+static uint32_t kernel_delta_floor = 0;                 // <! oldest base the ring can serve
+static uint32_t kernel_delta_sent  = 0;                 // <! local version sent last
+static int32_t  kernel_delta_digest_age = 0;
+
+  /**********************************************************************
+  |                                                                     |
+  |                               log                                   |
+  |                                                                     |
+  **********************************************************************/
+
+static void kernel_delta_log(const char *task_name, uint16_t task_id, bool removed, uint32_t version){
+    char *name = __strdup__( task_name );
+    if( name == NULL ){ kernel_delta_floor = version;  return; }       // <! change lost, serve newer base only
+
+    if( kernel_delta_count == KERNEL_DELTA_LOG_NUM ){   // <! drop oldest
+        struct kernel_delta_entry_t *e = &kernel_delta_ring[ kernel_delta_head ];
+        kernel_delta_floor = e->version;
+        x_free( e->task_name );
+        kernel_delta_head = (kernel_delta_head + 1) % KERNEL_DELTA_LOG_NUM;
+        kernel_delta_count--;
+    }
+
+    struct kernel_delta_entry_t *e = &kernel_delta_ring[ (kernel_delta_head + kernel_delta_count) % KERNEL_DELTA_LOG_NUM ];
+    e->version   = version;
+    e->task_id   = task_id;
+    e->removed   = removed;
+    e->task_name = name;
+    kernel_delta_count++;
+}
+
+// !> local core moves past version heard from peers, changes before it can not be served
+static void kernel_delta_rebase(struct MCUs_t *local, uint32_t version){
+    LOG( "task list version %u -> %u\r\n", (unsigned)local->version, (unsigned)version );
+    local->version     = version;
+    local->sync_mark  |= KERNEL_SYNC_MARK_DIRTY;        // <! whole list goes out instead
+    kernel_delta_floor = version;
+    kernel_delta_sent  = version;
+}
+
+static void kernel_delta_mark_all(void){
+    for( struct MCUs_t *p = kernel_mcu_queue; p != NULL; p = p->next ){ p->sync_mark |= KERNEL_SYNC_MARK_DIRTY; }
+}
+
+// !> task list of every core was sent
+static void kernel_delta_clear_marks(const struct MCUs_t *local){
+    for( struct MCUs_t *p = kernel_mcu_queue; p != NULL; p = p->next ){ p->sync_mark = 0; }
+    if( local != NULL ){ kernel_delta_sent = local->version; }
+}
+
+  /**********************************************************************
+  |                                                                     |
+  |                               pack                                  |
+  |                                                                     |
+  **********************************************************************/
+
+static void kernel_delta_put_core(struct kernel_wire_t *w, const char *core_name, int32_t core_id){
+    if( (core_id > 0) && ((all_support & KERNEL_CAP_IDS) || (core_name == NULL)) ){ kernel_wire_put_uint( w, WIRE_CORE_ID, core_id ); }
+    else                                                            { kernel_wire_put_str( w, WIRE_CORE, core_name ); }
+}
+
+// !> frame is copied for tunnel, w is freed
+static void kernel_delta_send(struct comm_tunnel_t *tunnel, struct kernel_wire_t *w){
+    if( (! w->err) && (tunnel != NULL) ){
+        uint8_t *frame = (uint8_t *)x_malloc( w->len );          // <! freed by tunnel
+        if( frame != NULL ){
+            memcpy( frame, w->buf, w->len );
+            kernel_tx_control( tunnel, frame, w->len );
+        }
+    }
+    if( w->buf != NULL ){ kernel_pass_free( w->buf ); }
+}
+
+/**
+ *  @brief pack changes of local task list after base
+ *
+ *  @param [in]
+ *  @param [out] w : frame in pass arena
+ *  @return false if ring does not cover base or failed
+ **/
+static bool kernel_delta_pack(struct kernel_wire_t *w, const struct MCUs_t *local, uint32_t base){
+    if( (int32_t)(base - kernel_delta_floor) < 0 ){ return false; }
+    if( ! kernel_wire_begin(w, KERNEL_WIRE_DELTA) ){ return false; }
+
+    kernel_delta_put_core( w, local->core, local->id );
+    kernel_wire_put_uint( w, WIRE_BASE, base );
+    kernel_wire_put_uint( w, WIRE_VERSION, local->version );
+    for( int32_t i=0; i<kernel_delta_count; i++ ){
+        const struct kernel_delta_entry_t *e = &kernel_delta_ring[ (kernel_delta_head + i) % KERNEL_DELTA_LOG_NUM ];
+        if( (int32_t)(e->version - base) <= 0 ){ continue; }
+        if( e->removed ){
+            kernel_wire_put_str( w, WIRE_TASK_DEL, e->task_name );
+        }else{
+            if( e->task_id != 0 ){ kernel_wire_put_uint( w, WIRE_TASK_ID, e->task_id ); }
+            kernel_wire_put_str( w, WIRE_TASK, e->task_name );
+        }
+    }
+
+    if( w->err ){
+        if( w->buf != NULL ){ kernel_pass_free( w->buf ); }
+        return false;
+    }
+    return true;
+}
+
+/**
+ *  @brief send delta of local core and task list of dirty cores, called by synchonize_tasklist
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return false: not sent, task list of every core is to be sent
+ **/
+static bool kernel_delta_synchonize(struct MCUs_t *local){
+    if( local == NULL ){ return false; }
+
+    struct kernel_wire_t w;
+    if( local->version != kernel_delta_sent ){
+        if( kernel_delta_pack(&w, local, kernel_delta_sent) ){
+            kernel_send_to_local_tunnels( w.buf, w.len, NULL );
+            kernel_pass_free( w.buf );
+            local->sync_mark &= ~KERNEL_SYNC_MARK_DIRTY;
+        }else{
+            local->sync_mark |= KERNEL_SYNC_MARK_DIRTY;  // <! not in ring, whole list
+        }
+        kernel_delta_sent = local->version;
+    }
+
+    bool dirty = false;
+    for( struct MCUs_t *p = kernel_mcu_queue; p != NULL; p = p->next ){
+        if( p->sync_mark & KERNEL_SYNC_MARK_DIRTY ){ dirty = true;  break; }
+    }
+    if( dirty ){
+        int32_t length = 0;
+        uint8_t *frame = kernel_wire_pack_cores( &length, KERNEL_SYNC_MARK_DIRTY );
+        if( frame == NULL ){ return false; }
+        kernel_send_to_local_tunnels( frame, length, NULL );
+        kernel_pass_free( frame );
+    }
+    for( struct MCUs_t *p = kernel_mcu_queue; p != NULL; p = p->next ){ p->sync_mark &= ~KERNEL_SYNC_MARK_DIRTY; }
+    return true;
+}
+
+static void kernel_delta_send_digest(void){
+    struct kernel_wire_t w;
+    if( ! kernel_wire_begin(&w, KERNEL_WIRE_DIGEST) ){ return; }
+
+    for( struct MCUs_t *p = kernel_mcu_queue; p != NULL; p = p->next ){
+        kernel_delta_put_core( &w, p->core, p->id );
+        kernel_wire_put_uint( &w, WIRE_VERSION, p->version );
+    }
+    if( ! w.err ){ kernel_send_to_local_tunnels( w.buf, w.len, NULL ); }
+    if( w.buf != NULL ){ kernel_pass_free( w.buf ); }
+}
+
+  /**********************************************************************
+  |                                                                     |
+  |                              unpack                                 |
+  |                                                                     |
+  **********************************************************************/
+
+// !> ask peer for task list of core newer than base
+static void kernel_delta_request(struct kernel_wire_t *w, const char *core_name, int32_t core_id, uint32_t base){
+    if( (w->buf == NULL) && (! kernel_wire_begin(w, KERNEL_WIRE_SYNC_REQ)) ){ return; }
+    kernel_delta_put_core( w, core_name, core_id );
+    kernel_wire_put_uint( w, WIRE_BASE, base );
+}
+
+/**
+ *  @brief check head of delta against version known here
+ *
+ *  @param [in]
+ *  @param [out] req : KERNEL_WIRE_SYNC_REQ when delta can not be applied
+ *  @return true if delta is to be applied
+ **/
+static bool kernel_delta_accept(struct kernel_wire_t *req, struct MCUs_t *mcu, const char *core_name, int32_t core_id,
+                                uint32_t base, uint32_t version){
+    if( mcu == NULL ){
+        kernel_delta_request( req, core_name, core_id, 0 );
+        return false;
+    }
+    if( mcu->is_local ){
+        if( (int32_t)(version - mcu->version) > 0 ){
+            kernel_delta_rebase( mcu, version + 1 );
+            synchonize_tasklist( NULL, 0 );
+        }
+        return false;
+    }
+    if( (int32_t)(version - mcu->version) <= 0 ){ return false; }     // <! known already
+    if( base != mcu->version ){
+        kernel_delta_request( req, mcu->core, mcu->id, mcu->version );
+        return false;
+    }
+    return true;
+}
+
+/**
+ *  @brief delta of task list received, called by kernel_wire_unpack
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+static void kernel_delta_unpack(struct comm_tunnel_t *tunnel, struct kernel_wire_reader_t *r,
+                                const uint8_t *raw_data, int32_t raw_length){
+    struct MCUs_t *mcu = NULL;  const char *core_name = NULL;  int32_t core_id = -1;
+    uint32_t base = 0, version = 0;  int32_t task_id = -1;
+    bool head_done = false, accepted = false;
+    struct kernel_wire_t req;
+    uint8_t tag;  const uint8_t *v;  int32_t len;
+
+    memset( &req, 0x0, sizeof(struct kernel_wire_t) );
+    for( bool more = true; more; ){
+        more = kernel_wire_next( r, &tag, &v, &len );
+        if( (! head_done) && ((! more) || (tag == WIRE_TASK) || (tag == WIRE_TASK_ID) || (tag == WIRE_TASK_DEL)) ){
+            head_done = true;
+            accepted  = kernel_delta_accept( &req, mcu, core_name, core_id, base, version );
+            if( ! accepted ){ break; }
+        }
+        if( ! more ){ break; }
+
+        switch( tag ){
+            case WIRE_CORE     :
+                if( NULL != (core_name = kernel_wire_str(v, len)) ){ mcu = is_mcu_exist( core_name ); }
+                break;
+            case WIRE_CORE_ID  : core_id = (int32_t)kernel_wire_uint( v, len );  mcu = kernel_wire_core( v, len );  break;
+            case WIRE_BASE     : base    = kernel_wire_uint( v, len );  break;
+            case WIRE_VERSION  : version = kernel_wire_uint( v, len );  break;
+            case WIRE_TASK_ID  : task_id = (int32_t)kernel_wire_uint( v, len );  break;
+            case WIRE_TASK     : {
+                const char *task_name = kernel_wire_str( v, len );
+                struct kernel_external_task_t *task = NULL;
+                if( (task_name != NULL) && (NULL == (task = kernel_is_task_on_mcu(mcu, task_name))) ){
+                    task = kernel_add_task_to_mcu( mcu, task_name );
+                }
+                if( (task != NULL) && (task_id > 0) && (task_id <= 0xFFFF) && (task->id != task_id) ){
+                    kernel_task_id_bind( mcu, task, (uint16_t)task_id );
+                }
+                task_id = -1;
+            } break;
+            case WIRE_TASK_DEL : {
+                const char *task_name = kernel_wire_str( v, len );
+                struct kernel_external_task_t *task = (task_name != NULL)?(kernel_is_task_on_mcu(mcu, task_name)):(NULL);
+                if( task != NULL ){ kernel_remove_task_from_mcu( mcu, task ); }
+            } break;
+            default : break;
+        }
+    }
+
+    if( accepted ){
+        mcu->version        = version;
+        mcu->task_modified  = true;
+        mcu->sync_mark     &= ~KERNEL_SYNC_MARK_DIRTY;   // <! delta is passed on instead of its list
+        kernel_send_to_local_tunnels( raw_data, raw_length, tunnel );
+    }
+    if( req.buf != NULL ){ kernel_delta_send( tunnel, &req ); }
+}
+
+/**
+ *  @brief versions of peer, request cores this core is behind on
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+static void kernel_delta_unpack_digest(struct comm_tunnel_t *tunnel, struct kernel_wire_reader_t *r){
+    struct MCUs_t *mcu = NULL;  const char *core_name = NULL;  int32_t core_id = -1;
+    bool rebased = false;
+    struct kernel_wire_t req;
+    uint8_t tag;  const uint8_t *v;  int32_t len;
+
+    memset( &req, 0x0, sizeof(struct kernel_wire_t) );
+    while( kernel_wire_next(r, &tag, &v, &len) ){
+        switch( tag ){
+            case WIRE_CORE    :
+                core_id = -1;
+                if( NULL != (core_name = kernel_wire_str(v, len)) ){ mcu = is_mcu_exist( core_name ); }
+                break;
+            case WIRE_CORE_ID : core_name = NULL;  core_id = (int32_t)kernel_wire_uint( v, len );  mcu = kernel_wire_core( v, len );  break;
+            case WIRE_VERSION : {
+                uint32_t version = kernel_wire_uint( v, len );
+                if( mcu == NULL ){
+                    kernel_delta_request( &req, core_name, core_id, 0 );
+                }else if( (int32_t)(version - mcu->version) > 0 ){
+                    if( mcu->is_local ){ kernel_delta_rebase( mcu, version + 1 );  rebased = true; }
+                    else               { kernel_delta_request( &req, mcu->core, mcu->id, mcu->version ); }
+                }
+                mcu = NULL;  core_name = NULL;  core_id = -1;
+            } break;
+            default : break;
+        }
+    }
+    if( req.buf != NULL ){ kernel_delta_send( tunnel, &req ); }
+    if( rebased ){ synchonize_tasklist( NULL, 0 ); }
+}
+
+/**
+ *  @brief peer asks for task list of cores: delta of local core when ring covers its base,
+ *         whole list otherwise, base 0 is asked by peer not knowing the core and always
+ *         gets whole list, its delta would be rejected again
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+static void kernel_delta_unpack_req(struct comm_tunnel_t *tunnel, struct kernel_wire_reader_t *r){
+    struct MCUs_t *mcu = NULL;  bool full = false;
+    uint8_t tag;  const uint8_t *v;  int32_t len;
+
+    while( kernel_wire_next(r, &tag, &v, &len) ){
+        switch( tag ){
+            case WIRE_CORE    : {
+                const char *core_name = kernel_wire_str( v, len );
+                mcu = (core_name != NULL)?(is_mcu_exist(core_name)):(NULL);
+            } break;
+            case WIRE_CORE_ID : mcu = kernel_wire_core( v, len );  break;
+            case WIRE_BASE    : {
+                uint32_t base = kernel_wire_uint( v, len );
+                struct kernel_wire_t w;
+                if( mcu == NULL ){ break; }                 // <! unknown here too
+                if( mcu->is_local && (base != 0) && (base != mcu->version) && kernel_delta_pack(&w, mcu, base) ){
+                    kernel_delta_send( tunnel, &w );
+                }else{
+                    mcu->sync_mark |= KERNEL_SYNC_MARK_REQ;
+                    full = true;
+                }
+                mcu = NULL;
+            } break;
+            default : break;
+        }
+    }
+    if( ! full ){ return; }
+
+    int32_t length = 0;
+    uint8_t *frame = kernel_wire_pack_cores( &length, KERNEL_SYNC_MARK_REQ );
+    if( frame != NULL ){
+        struct kernel_wire_t w = { frame, length, length, false };
+        kernel_delta_send( tunnel, &w );
+    }
+    for( struct MCUs_t *p = kernel_mcu_queue; p != NULL; p = p->next ){ p->sync_mark &= ~KERNEL_SYNC_MARK_REQ; }
+}
+
+/**
+ *  @brief called at the end of scheduler pass, sends digest of versions
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+void kernel_delta_pass_end(int32_t delta_ms){
+    #if ( KERNEL_DELTA_DIGEST_MS > 0 )
+    if( ! (all_support & KERNEL_CAP_DELTA_SYNC) ){ kernel_delta_digest_age = 0;  return; }
+
+    kernel_delta_digest_age += delta_ms;
+    if( kernel_delta_digest_age < KERNEL_DELTA_DIGEST_MS ){ return; }
+    kernel_delta_digest_age = 0;
+    kernel_delta_send_digest();
+    #endif
+}
+
+/**
+ *  @brief time before next digest, used by kernel_idle_time
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return -1 if no digest
+ **/
+int32_t kernel_delta_next_time(void){
+    #if ( KERNEL_DELTA_DIGEST_MS > 0 )
+    if( all_support & KERNEL_CAP_DELTA_SYNC ){ return MAX( KERNEL_DELTA_DIGEST_MS - kernel_delta_digest_age, 0 ); }
+    #endif
+    return -1;
+}
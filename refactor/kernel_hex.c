@@ -0,0 +1,304 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/*************************************************************************
+
+           -------------------------------------------------
+          |                                                 |
+          |       Hex Encode / Decode of JSON Payloads      |
+          |                                                 |
+           -------------------------------------------------
+
+ Note:
+ 1.binary msg data and mmap regions travel as hex digits in JSON frame
+   when "SupportJsonExtra" is not available, as plain string when every
+   core announced "SupportHexText" (KERNEL_HEX_JSON, on by default)
+        "KERNEL_JSON_HEX_PREFIX" + 2 digits per byte, high nibble first
+   and string msg starting with KERNEL_JSON_HEX_PREFIX goes as hex too,
+   so prefixed text is always hex data, cJSON_CreateHexString otherwise
+   (network with older cores)
+ 4.JSON scanner and cJSON DOM both decode here, digits of cJSON_HexString
+   included, cJSON_hexassemble is only left for a print it can't match
+ 2.16 bytes are done per step with SSE2 or NEON when the compiler targets
+   it, scalar code does the tail and other targets
+ 3.decoder accepts both digit cases, broken digit fails the whole data,
+   kernel_hex_decode_update leaves destination untouched then and writes
+   only when data differs, so mmap is decoded straight into its space
+
+*************************************************************************/
+
+#ifndef KERNEL_JSON_HEX_PREFIX
+#define KERNEL_JSON_HEX_PREFIX          "0x"            // <! prefix of hex text, same on every core
+#endif
+
+#ifndef KERNEL_HEX_UPPER
+#define KERNEL_HEX_UPPER                1               // <! digit case printed, decoder takes both
+#endif
+
+#ifndef KERNEL_HEX_SIMD
+#define KERNEL_HEX_SIMD                 1               // <! 0 to force scalar code
+#endif
+
+#if ( KERNEL_HEX_SIMD > 0 ) && defined (__SSE2__)
+#include <emmintrin.h>
+#define KERNEL_HEX_SSE2
+#elif ( KERNEL_HEX_SIMD > 0 ) && ( defined (__ARM_NEON) || defined (__ARM_NEON__) )
+#include <arm_neon.h>
+#define KERNEL_HEX_NEON
+#endif
+
+#define KERNEL_HEX_BLOCK                16              // <! bytes per step
+#define KERNEL_HEX_ALPHA                ( (KERNEL_HEX_UPPER)?('A' - 10):('a' - 10) )
+
+  /**********************************************************************
+  |                                                                     |
+  |                              scalar                                 |
+  |                                                                     |
+  **********************************************************************/
+
+static char kernel_hex_digit(uint8_t n){
+    return (char)( (n < 10)?('0' + n):(KERNEL_HEX_ALPHA + n) );
+}
+
+static int32_t kernel_hex_nibble(uint8_t c){
+    if( (uint8_t)(c - '0') < 10 ){ return c - '0'; }
+    c |= 0x20;                                          // <! lower case
+    if( (uint8_t)(c - 'a') < 6 ){ return c - 'a' + 10; }
+    return -1;
+}
+
+static void kernel_hex_encode_scalar(const uint8_t *src, int32_t length, char *dst){
+    for( int32_t i=0; i<length; i++ ){
+        dst[2*i]     = kernel_hex_digit( src[i] >> 4 );
+        dst[2*i + 1] = kernel_hex_digit( src[i] & 0x0F );
+    }
+}
+
+static bool kernel_hex_decode_scalar(const char *src, uint8_t *dst, int32_t length){
+    for( int32_t i=0; i<length; i++ ){
+        int32_t h = kernel_hex_nibble( (uint8_t)src[2*i] ), l = kernel_hex_nibble( (uint8_t)src[2*i + 1] );
+        if( (h | l) < 0 ){ return false; }
+        dst[i] = (uint8_t)( (h << 4) | l );
+    }
+    return true;
+}
+
+  /**********************************************************************
+  |                                                                     |
+  |                         block of 16 bytes                           |
+  |                                                                     |
+  **********************************************************************/
+
+#if defined (KERNEL_HEX_SSE2)
+
+static __m128i kernel_hex_sse2_digits(__m128i n){
+    __m128i alpha = _mm_and_si128( _mm_cmpgt_epi8(n, _mm_set1_epi8(9)), _mm_set1_epi8(KERNEL_HEX_ALPHA - '0') );
+    return _mm_add_epi8( _mm_add_epi8(n, _mm_set1_epi8('0')), alpha );
+}
+
+// !> digits to nibbles, bytes >= 0x80 are negative and fail both ranges
+static bool kernel_hex_sse2_nibbles(__m128i c, __m128i *n){
+    __m128i l     = _mm_or_si128( c, _mm_set1_epi8(0x20) );
+    __m128i digit = _mm_and_si128( _mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)) );
+    __m128i alpha = _mm_and_si128( _mm_cmpgt_epi8(l, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(l, _mm_set1_epi8('f' + 1)) );
+    *n = _mm_or_si128( _mm_and_si128(digit, _mm_sub_epi8(c, _mm_set1_epi8('0'))),
+                       _mm_and_si128(alpha, _mm_sub_epi8(l, _mm_set1_epi8('a' - 10))) );
+    return _mm_movemask_epi8( _mm_or_si128(digit, alpha) ) == 0xFFFF;
+}
+
+// !> [h0 l0 h1 l1 ...] to byte in low half of each 16 bits lane
+static __m128i kernel_hex_sse2_pair(__m128i n){
+    return _mm_or_si128( _mm_slli_epi16(_mm_and_si128(n, _mm_set1_epi16(0x00FF)), 4), _mm_srli_epi16(n, 8) );
+}
+
+static void kernel_hex_encode_block(const uint8_t *src, char *dst){
+    __m128i x  = _mm_loadu_si128( (const __m128i *)src );
+    __m128i hi = kernel_hex_sse2_digits( _mm_and_si128(_mm_srli_epi16(x, 4), _mm_set1_epi8(0x0F)) );
+    __m128i lo = kernel_hex_sse2_digits( _mm_and_si128(x, _mm_set1_epi8(0x0F)) );
+    _mm_storeu_si128( (__m128i *)dst,        _mm_unpacklo_epi8(hi, lo) );
+    _mm_storeu_si128( (__m128i *)&dst[16],   _mm_unpackhi_epi8(hi, lo) );
+}
+
+static bool kernel_hex_decode_block(const char *src, uint8_t *dst){
+    __m128i a, b;
+    if( ! kernel_hex_sse2_nibbles(_mm_loadu_si128((const __m128i *)src), &a) ){ return false; }
+    if( ! kernel_hex_sse2_nibbles(_mm_loadu_si128((const __m128i *)&src[16]), &b) ){ return false; }
+    _mm_storeu_si128( (__m128i *)dst, _mm_packus_epi16(kernel_hex_sse2_pair(a), kernel_hex_sse2_pair(b)) );
+    return true;
+}
+
+#elif defined (KERNEL_HEX_NEON)
+
+static uint8x16_t kernel_hex_neon_digits(uint8x16_t n){
+    uint8x16_t alpha = vandq_u8( vcgtq_u8(n, vdupq_n_u8(9)), vdupq_n_u8(KERNEL_HEX_ALPHA - '0') );
+    return vaddq_u8( vaddq_u8(n, vdupq_n_u8('0')), alpha );
+}
+
+static bool kernel_hex_neon_nibbles(uint8x16_t c, uint8x16_t *n){
+    uint8x16_t d     = vsubq_u8( c, vdupq_n_u8('0') );
+    uint8x16_t a     = vsubq_u8( vorrq_u8(c, vdupq_n_u8(0x20)), vdupq_n_u8('a') );
+    uint8x16_t digit = vcltq_u8( d, vdupq_n_u8(10) );
+    uint8x16_t ok    = vorrq_u8( digit, vcltq_u8(a, vdupq_n_u8(6)) );
+    *n = vbslq_u8( digit, d, vaddq_u8(a, vdupq_n_u8(10)) );
+    #if defined (__aarch64__)
+    return vminvq_u8( ok ) == 0xFF;
+    #else
+    uint8x8_t m = vmin_u8( vget_low_u8(ok), vget_high_u8(ok) );
+    m = vpmin_u8( m, m );  m = vpmin_u8( m, m );  m = vpmin_u8( m, m );
+    return vget_lane_u8( m, 0 ) == 0xFF;
+    #endif
+}
+
+static void kernel_hex_encode_block(const uint8_t *src, char *dst){
+    uint8x16_t x = vld1q_u8( src );
+    uint8x16x2_t d;
+    d.val[0] = kernel_hex_neon_digits( vshrq_n_u8(x, 4) );
+    d.val[1] = kernel_hex_neon_digits( vandq_u8(x, vdupq_n_u8(0x0F)) );
+    vst2q_u8( (uint8_t *)dst, d );                      // <! interleaved high, low
+}
+
+static bool kernel_hex_decode_block(const char *src, uint8_t *dst){
+    uint8x16x2_t c = vld2q_u8( (const uint8_t *)src );  // <! high digits, low digits
+    uint8x16_t h, l;
+    if( (! kernel_hex_neon_nibbles(c.val[0], &h)) || (! kernel_hex_neon_nibbles(c.val[1], &l)) ){ return false; }
+    vst1q_u8( dst, vorrq_u8(vshlq_n_u8(h, 4), l) );
+    return true;
+}
+
+#else
+
+static void kernel_hex_encode_block(const uint8_t *src, char *dst){
+    kernel_hex_encode_scalar( src, KERNEL_HEX_BLOCK, dst );
+}
+
+static bool kernel_hex_decode_block(const char *src, uint8_t *dst){
+    return kernel_hex_decode_scalar( src, dst, KERNEL_HEX_BLOCK );
+}
+
+#endif
+
+  /**********************************************************************
+  |                                                                     |
+  |                               api                                   |
+  |                                                                     |
+  **********************************************************************/
+
+/**
+ *  @brief encode length bytes to 2 * length digits, no '\0' appended
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+static void kernel_hex_encode(const uint8_t *src, int32_t length, char *dst){
+    int32_t i = 0;
+    for( ; i + KERNEL_HEX_BLOCK <= length; i += KERNEL_HEX_BLOCK ){ kernel_hex_encode_block( &src[i], &dst[2*i] ); }
+    kernel_hex_encode_scalar( &src[i], length - i, &dst[2*i] );
+}
+
+/**
+ *  @brief decode 2 * length digits to length bytes
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return false if digit broken, dst is partly written then
+ **/
+static bool kernel_hex_decode(const char *src, uint8_t *dst, int32_t length){
+    int32_t i = 0;
+    for( ; i + KERNEL_HEX_BLOCK <= length; i += KERNEL_HEX_BLOCK ){
+        if( ! kernel_hex_decode_block(&src[2*i], &dst[i]) ){ return false; }
+    }
+    return kernel_hex_decode_scalar( &src[2*i], &dst[i], length - i );
+}
+
+/**
+ *  @brief decode 2 * length digits straight into dst when they differ from it
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return -1: digit broken, dst untouched  0: same as dst  1: dst updated
+ **/
+static int32_t kernel_hex_decode_update(const char *src, uint8_t *dst, int32_t length){
+    uint8_t block[ KERNEL_HEX_BLOCK ];
+    bool changed = false;
+
+    for( int32_t i=0; i<length; i+=KERNEL_HEX_BLOCK ){  // <! check every digit before first write
+        int32_t n = MIN( KERNEL_HEX_BLOCK, length - i );
+        bool ok = (n == KERNEL_HEX_BLOCK)?(kernel_hex_decode_block(&src[2*i], block)):(kernel_hex_decode_scalar(&src[2*i], block, n));
+        if( ! ok ){ return -1; }
+        if( (! changed) && (memcmp(block, &dst[i], n) != 0x0) ){ changed = true; }
+    }
+    if( ! changed ){ return 0; }
+
+    kernel_hex_decode( src, dst, length );
+    return 1;
+}
+
+/**
+ *  @brief text starts with KERNEL_JSON_HEX_PREFIX
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+static bool kernel_hex_prefixed(const char *str, int32_t length){
+    int32_t prefix = (int32_t)strlen( KERNEL_JSON_HEX_PREFIX );
+    return ( length >= prefix ) && ( memcmp(str, KERNEL_JSON_HEX_PREFIX, prefix) == 0 );
+}
+
+/**
+ *  @brief JSON item of binary data, hex text when every core announced "SupportHexText",
+ *         cJSON_HexString otherwise
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return NULL if no memory
+ **/
+static cJSON * kernel_hex_json(const uint8_t *data, int32_t length){
+    int32_t prefix = (int32_t)strlen( KERNEL_JSON_HEX_PREFIX );
+    char *str = (all_support & KERNEL_CAP_HEX_TEXT)?((char *)kernel_pass_malloc( prefix + 2 * length + 1 )):(NULL);
+    if( str != NULL ){
+        memcpy( str, KERNEL_JSON_HEX_PREFIX, prefix );
+        kernel_hex_encode( data, length, &str[prefix] );
+        str[ prefix + 2 * length ] = '\0';
+        cJSON *item = cJSON_CreateString( str );
+        kernel_pass_free( str );
+        return item;
+    }
+    return cJSON_CreateHexString( (uint8_t *)data, length );
+}
+
+/**
+ *  @brief bytes of binary data item in cJSON DOM: hex text, or digits of cJSON_HexString
+ *
+ *  @param [in]
+ *  @param [out] length : byte length, 0 when data carried outside of JSON
+ *  @return pass arena buffer (kernel_pass_free), NULL if not binary data, length 0, broken or no memory
+ **/
+static uint8_t * kernel_hex_json_bytes(const cJSON *item, int32_t *length){
+    const char *digits = NULL;  uint8_t *out = NULL;
+    *length = -1;
+    if( (item == NULL) || (item->valuestring == NULL) ){ return NULL; }
+
+    int32_t len = (int32_t)strlen( item->valuestring );
+    if( item->type == cJSON_HexString ){
+        *length = item->valueint;
+        if( *length <= 0 ){ return NULL; }
+        if( len != 2 * (*length) ){ return cJSON_hexassemble( item->valuestring ); }     // <! not plain digits, cJSON knows
+        digits = item->valuestring;
+    }else if( (item->type == cJSON_String) && (all_support & KERNEL_CAP_HEX_TEXT) && kernel_hex_prefixed(item->valuestring, len) ){
+        int32_t prefix = (int32_t)strlen( KERNEL_JSON_HEX_PREFIX );
+        if( (len - prefix) & 1 ){ return NULL; }
+        *length = (len - prefix) / 2;
+        if( *length == 0 ){ return NULL; }
+        digits = &item->valuestring[ prefix ];
+    }else{
+        return NULL;
+    }
+
+    if( NULL != (out = (uint8_t *)kernel_pass_malloc( *length )) ){
+        if( ! kernel_hex_decode(digits, out, *length) ){ kernel_pass_free( out );  out = NULL; }
+    }
+    return out;
+}
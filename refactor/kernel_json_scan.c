@@ -0,0 +1,588 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/*************************************************************************
+
+           -------------------------------------------------
+          |                                                 |
+          |     Allocation-Free JSON Scanner of Kernel      |
+          |                                                 |
+           -------------------------------------------------
+
+ Note:
+ 1.single pass over the raw frame, no DOM, frame is not modified
+ 2.dispatch on top-level key: "msg", "mmap", "mmap_sync_req", "Cores"
+   and the core objects listed in "Cores"
+ 3.strings and hex data are decoded into a scratch buffer on stack,
+   pass arena (kernel_pass_malloc) only when scratch is too small
+ 4.same kernel_recv_* handlers as JSON DOM and binary frame
+ 5."TaskArray" is expected as the last member of a core object, as
+   synchonize_tasklist packs it
+ 6.members before a broken token are already handled, the rest of the
+   frame is dropped
+ 7.hex data is read only as "SupportHexText" text, cJSON_HexString is
+   printed the way cJSON knows, so "msg" / "mmap" frames are left to cJSON
+   DOM unless every core announced "SupportHexText", decided at the first
+   key before anything is scanned or dispatched (one kind per frame)
+
+*************************************************************************/
+
+#if ( KERNEL_JSON_SCAN > 0 )
+
+#ifndef KERNEL_JSON_SCAN_SCRATCH
+#define KERNEL_JSON_SCAN_SCRATCH        256             // <! stack scratch of strings / hex data
+#endif
+
+#define KERNEL_JSON_SCAN_DEPTH          16              // <! nesting limit of skipped values
+#define KERNEL_JSON_SCAN_HEAP           4               // <! pass arena / heap fallbacks alive at the same time
+
+struct kernel_json_scan_t {
+    const char                    *p;
+    const char                    *end;
+    bool                          err;
+
+    uint8_t                       *scratch;
+    int32_t                       used;
+    int32_t                       size;
+    void                          *heap[ KERNEL_JSON_SCAN_HEAP ];
+    int32_t                       heap_num;
+};
+
+struct kernel_json_mark_t {
+    int32_t                       used;
+    int32_t                       heap_num;
+};
+
+struct kernel_json_str_t {                              // <! raw token between quotes, escapes not decoded
+    const char                    *s;
+    int32_t                       len;
+    bool                          escaped;
+};
+
+  /**********************************************************************
+  |                                                                     |
+  |                              scratch                                |
+  |                                                                     |
+  **********************************************************************/
+
+static void * kernel_json_scratch_alloc(struct kernel_json_scan_t *s, int32_t size){
+    if( s->used + size <= s->size ){
+        void *p = &s->scratch[ s->used ];
+        s->used += size;
+        return p;
+    }
+    if( s->heap_num >= KERNEL_JSON_SCAN_HEAP ){ return NULL; }
+
+    void *p = kernel_pass_malloc( size );               // <! pooled in pass, heap otherwise
+    if( p != NULL ){ s->heap[ s->heap_num++ ] = p; }
+    return p;
+}
+
+static struct kernel_json_mark_t kernel_json_mark(const struct kernel_json_scan_t *s){
+    struct kernel_json_mark_t mark = { s->used, s->heap_num };
+    return mark;
+}
+
+static void kernel_json_release(struct kernel_json_scan_t *s, struct kernel_json_mark_t mark){
+    while( s->heap_num > mark.heap_num ){
+        kernel_pass_free( s->heap[ --s->heap_num ] );   // <! LIFO, arena gives it back
+    }
+    s->used = mark.used;
+}
+
+  /**********************************************************************
+  |                                                                     |
+  |                             tokenizer                               |
+  |                                                                     |
+  **********************************************************************/
+
+static void kernel_json_ws(struct kernel_json_scan_t *s){
+    while( (s->p < s->end) && ((*s->p == ' ') || (*s->p == '\t') || (*s->p == '\r') || (*s->p == '\n')) ){ s->p++; }
+}
+
+static bool kernel_json_expect(struct kernel_json_scan_t *s, char c){
+    kernel_json_ws( s );
+    if( (s->p < s->end) && (*s->p == c) ){ s->p++;  return true; }
+    s->err = true;
+    return false;
+}
+
+static bool kernel_json_str(struct kernel_json_scan_t *s, struct kernel_json_str_t *str){
+    if( ! kernel_json_expect(s, '"') ){ return false; }
+
+    str->s = s->p;  str->escaped = false;
+    while( s->p < s->end ){
+        char c = *s->p++;
+        if( c == '"' ){
+            str->len = (int32_t)( s->p - 1 - str->s );
+            return true;
+        }
+        if( c == '\\' ){
+            if( s->p >= s->end ){ break; }
+            s->p++;  str->escaped = true;
+        }
+    }
+    s->err = true;
+    return false;
+}
+
+static bool kernel_json_num(struct kernel_json_scan_t *s, int64_t *v){
+    kernel_json_ws( s );
+    bool neg = false;  int32_t digits = 0;  *v = 0;
+
+    if( (s->p < s->end) && (*s->p == '-') ){ neg = true;  s->p++; }
+    while( (s->p < s->end) && (*s->p >= '0') && (*s->p <= '9') ){
+        *v = (*v * 10) + (*s->p++ - '0');  digits++;
+    }
+    while( (s->p < s->end) && ( ((*s->p >= '0') && (*s->p <= '9')) || (*s->p == '.') ||
+           (*s->p == 'e') || (*s->p == 'E') || (*s->p == '+') || (*s->p == '-') ) ){ s->p++; }   // <! fraction is truncated like valueint
+    if( digits == 0 ){ s->err = true;  return false; }
+    if( neg ){ *v = -*v; }
+    return true;
+}
+
+static bool kernel_json_word(struct kernel_json_scan_t *s, const char *word){
+    int32_t n = strlen( word );
+    if( (s->end - s->p >= n) && (memcmp(s->p, word, n) == 0) ){ s->p += n;  return true; }
+    return false;
+}
+
+static bool kernel_json_skip(struct kernel_json_scan_t *s, int32_t depth){
+    struct kernel_json_str_t str;  int64_t v;
+    kernel_json_ws( s );
+    if( (s->p >= s->end) || (depth > KERNEL_JSON_SCAN_DEPTH) ){ s->err = true;  return false; }
+
+    switch( *s->p ){
+        case '"' : return kernel_json_str( s, &str );
+        case '{' :
+        case '[' : {
+            char close = (*s->p == '{')?('}'):(']');
+            bool is_obj = (*s->p == '{');
+            s->p++;  kernel_json_ws( s );
+            if( (s->p < s->end) && (*s->p == close) ){ s->p++;  return true; }
+            for( ;; ){
+                if( is_obj && ((! kernel_json_str(s, &str)) || (! kernel_json_expect(s, ':'))) ){ return false; }
+                if( ! kernel_json_skip(s, depth + 1) ){ return false; }
+                kernel_json_ws( s );
+                if( (s->p < s->end) && (*s->p == ',') ){ s->p++;  continue; }
+                return kernel_json_expect( s, close );
+            }
+        }
+        case 't' : if( kernel_json_word(s, "true") ) { return true; }  break;
+        case 'f' : if( kernel_json_word(s, "false") ){ return true; }  break;
+        case 'n' : if( kernel_json_word(s, "null") ) { return true; }  break;
+        default  : return kernel_json_num( s, &v );
+    }
+    s->err = true;
+    return false;
+}
+
+/**
+ *  @brief step to next member of object / item of array
+ *
+ *  @param [in] first : true before the first member, cleared by callee
+ *  @param [out] key  : NULL for array
+ *  @return false: container closed or broken (s->err)
+ **/
+static bool kernel_json_next(struct kernel_json_scan_t *s, bool *first, char close, struct kernel_json_str_t *key){
+    kernel_json_ws( s );
+    if( (s->p < s->end) && (*s->p == close) ){ s->p++;  return false; }
+    if( ! *first ){
+        if( ! kernel_json_expect(s, ',') ){ return false; }
+    }
+    *first = false;
+    if( key != NULL ){
+        if( (! kernel_json_str(s, key)) || (! kernel_json_expect(s, ':')) ){ return false; }
+    }
+    kernel_json_ws( s );
+    return s->p < s->end;
+}
+
+static bool kernel_json_is(const struct kernel_json_str_t *str, const char *word){
+    return ( (int32_t)strlen(word) == str->len ) && ( memcmp(str->s, word, str->len) == 0 );
+}
+
+static bool kernel_json_peek(struct kernel_json_scan_t *s, char c){
+    kernel_json_ws( s );
+    return (s->p < s->end) && (*s->p == c);
+}
+
+  /**********************************************************************
+  |                                                                     |
+  |                              decoder                                |
+  |                                                                     |
+  **********************************************************************/
+
+static int32_t kernel_json_hex_nibble(char c){
+    if( (c >= '0') && (c <= '9') ){ return c - '0'; }
+    if( (c >= 'a') && (c <= 'f') ){ return c - 'a' + 10; }
+    if( (c >= 'A') && (c <= 'F') ){ return c - 'A' + 10; }
+    return -1;
+}
+
+/**
+ *  @brief decode string token to '\0' ended string in scratch
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return NULL if no memory
+ **/
+static char * kernel_json_cstr(struct kernel_json_scan_t *s, const struct kernel_json_str_t *str){
+    char *out = (char *)kernel_json_scratch_alloc( s, str->len + 1 );
+    if( out == NULL ){ return NULL; }
+
+    int32_t n = 0;
+    for( int32_t i=0; i<str->len; i++ ){
+        char c = str->s[i];
+        if( (c == '\\') && (i + 1 < str->len) ){
+            switch( c = str->s[++i] ){
+                case 'b' : c = '\b';  break;
+                case 'f' : c = '\f';  break;
+                case 'n' : c = '\n';  break;
+                case 'r' : c = '\r';  break;
+                case 't' : c = '\t';  break;
+                case 'u' : {                            // <! only ASCII is kept, others become '?'
+                    int32_t u = 0;
+                    for( int32_t k=0; (k<4) && (i + 1 < str->len); k++ ){
+                        int32_t h = kernel_json_hex_nibble( str->s[++i] );
+                        u = (u << 4) | ((h < 0)?(0):(h));
+                    }
+                    c = (u < 0x80)?((char)u):('?');
+                } break;
+                default : break;                        // <! '"', '\\', '/'
+            }
+        }
+        out[n++] = c;
+    }
+    out[n] = '\0';
+    return out;
+}
+
+/**
+ *  @brief frame of key may carry cJSON_HexString, which only cJSON DOM reads
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+static bool kernel_json_needs_dom(const struct kernel_json_str_t *key){
+    if( all_support & KERNEL_CAP_HEX_TEXT ){ return false; }
+    return kernel_json_is(key, "msg") || kernel_json_is(key, "mmap");
+}
+
+/**
+ *  @brief decode hex text to bytes in scratch
+ *
+ *  @param [in]
+ *  @param [out] length : 0 when data carried outside of JSON
+ *  @return NULL if length is 0, broken or no memory
+ **/
+static uint8_t * kernel_json_hex(struct kernel_json_scan_t *s, const struct kernel_json_str_t *str, int32_t *length){
+    const char *hex = str->s + strlen( KERNEL_JSON_HEX_PREFIX );
+    int32_t digits = str->len - (int32_t)strlen( KERNEL_JSON_HEX_PREFIX );
+
+    *length = digits / 2;
+    if( (digits <= 0) || (digits & 1) ){ *length = 0;  return NULL; }
+
+    uint8_t *out = (uint8_t *)kernel_json_scratch_alloc( s, *length );
+    if( out == NULL ){ return NULL; }
+    if( ! kernel_hex_decode(hex, out, *length) ){ *length = -1;  return NULL; }       // <! see kernel_hex.c
+    return out;
+}
+
+  /**********************************************************************
+  |                                                                     |
+  |                          top-level keys                             |
+  |                                                                     |
+  **********************************************************************/
+
+static void kernel_json_scan_msg(struct kernel_json_scan_t *s, struct comm_tunnel_t *tunnel, const uint8_t *raw_data, int32_t raw_length){
+    struct kernel_recv_msg_t m;  struct kernel_json_str_t key, str;  int64_t v = 0;
+    memset( &m, 0x0, sizeof(struct kernel_recv_msg_t) );
+    m.preodic = -1;  m.cnt = -1;
+    struct kernel_json_mark_t mark = kernel_json_mark( s );
+
+    if( ! kernel_json_expect(s, '{') ){ return; }
+    for( bool first = true; kernel_json_next(s, &first, '}', &key); ){
+        if( kernel_json_is(&key, "targ_task") || kernel_json_is(&key, "src_task") || kernel_json_is(&key, "notify") ){
+            if( ! kernel_json_str(s, &str) ){ return; }
+            const char *cstr = kernel_json_cstr( s, &str );
+            if( kernel_json_is(&key, "targ_task") ){ m.target_task  = cstr; }
+            if( kernel_json_is(&key, "src_task") ) { m.src_task     = cstr; }
+            if( kernel_json_is(&key, "notify") )   { m.notification = cstr; }
+
+        }else if( kernel_json_is(&key, "data") ){
+            m.data = "";  m.length = -1;                                    // <! drop msg unless data decoded
+            if( ! kernel_json_peek(s, '"') ){
+                if( ! kernel_json_skip(s, 0) ){ return; }
+            }else if( ! kernel_json_str(s, &str) ){
+                return;
+            }else if( ! kernel_hex_prefixed(str.s, str.len) ){
+                const char *cstr = kernel_json_cstr( s, &str );
+                if( cstr != NULL ){ m.data = cstr;  m.length = 0; }
+            }else{
+                int32_t len = 0;
+                uint8_t *hex_data = kernel_json_hex( s, &str, &len );
+                if( hex_data != NULL ){
+                    m.data = (const char *)hex_data;  m.length = len;
+                }else if( len == 0 ){                                       // <! Extra data carry ouside of JSON.
+                    const uint8_t *ex = kernel_json_extra_data( raw_data, raw_length, &len );
+                    if( ex != NULL ){ m.data = (const char *)ex;  m.length = len; }
+                }
+            }
+
+        }else if( kernel_json_is(&key, "delay") || kernel_json_is(&key, "preodic") ||
+                  kernel_json_is(&key, "cnt") || kernel_json_is(&key, "call_id") ){
+            if( ! kernel_json_num(s, &v) ){ return; }
+            if( kernel_json_is(&key, "delay") )  { m.delay   = (int32_t)v;  }
+            if( kernel_json_is(&key, "preodic") ){ m.preodic = (int32_t)v;  }
+            if( kernel_json_is(&key, "cnt") )    { m.cnt     = (int32_t)v;  }
+            if( kernel_json_is(&key, "call_id") ){ m.call_id = (uint32_t)v; }
+
+        }else{
+            if( kernel_json_is(&key, "timer") )     { m.timer = true; }
+            if( kernel_json_is(&key, "call_reply") ){ m.call_reply = kernel_json_peek( s, 't' ); }
+            if( ! kernel_json_skip(s, 0) ){ return; }
+        }
+    }
+    if( ! s->err ){
+        kernel_recv_msg( tunnel, &m, raw_data, raw_length );
+    }
+    kernel_json_release( s, mark );
+}
+
+static void kernel_json_scan_mmap_entry(struct kernel_json_scan_t *s, struct comm_tunnel_t *tunnel, const char *mem_name){
+    const char *src_core = NULL, *dst_core = NULL;  uint8_t *mem_data = NULL;
+    int32_t mem_size = 0, len = 0;  int64_t v = 0;
+    struct kernel_json_str_t key, str, hex;  bool has_hex = false;
+
+    if( ! kernel_json_expect(s, '{') ){ return; }
+    for( bool first = true; kernel_json_next(s, &first, '}', &key); ){
+        if( kernel_json_is(&key, "src_core") || kernel_json_is(&key, "dst_core") ){
+            if( ! kernel_json_str(s, &str) ){ break; }
+            if( kernel_json_is(&key, "src_core") ){ src_core = kernel_json_cstr( s, &str ); }
+            else                                  { dst_core = kernel_json_cstr( s, &str ); }
+        }else if( kernel_json_is(&key, "mem_size") ){
+            if( ! kernel_json_num(s, &v) ){ break; }
+            mem_size = (int32_t)v;
+        }else if( kernel_json_is(&key, "mem_data") ){
+            if( ! kernel_json_peek(s, '"') ){
+                if( ! kernel_json_skip(s, 0) ){ break; }
+            }else{
+                if( ! kernel_json_str(s, &hex) ){ break; }
+                has_hex = kernel_hex_prefixed( hex.s, hex.len );
+            }
+        }else{
+            if( ! kernel_json_skip(s, 0) ){ break; }
+        }
+    }
+
+    if( ! s->err ){
+        int32_t prefix = (int32_t)strlen( KERNEL_JSON_HEX_PREFIX );
+        const char *local_core = get_my_core_name();
+        if( has_hex && (src_core != NULL) && (dst_core != NULL) && (local_core != NULL) && (strcmp(dst_core, local_core) == 0x0) &&
+            (mem_size > 0) && (hex.len - prefix == 2 * mem_size) && kernel_mmap_update_from_hex(src_core, mem_name, hex.s + prefix, mem_size) ){
+            return;                                     // <! decoded straight into receiving space
+        }
+        if( has_hex ){ mem_data = kernel_json_hex( s, &hex, &len ); }
+
+        if( mem_data == NULL ){
+            WARNING( "mmap type Error!!!" );
+        }else if( len != mem_size ){
+            WARNING( "mmap size not match" );
+        }else{
+            kernel_recv_mmap( tunnel, src_core, dst_core, mem_name, mem_data, mem_size );
+        }
+    }
+}
+
+static void kernel_json_scan_mmap(struct kernel_json_scan_t *s, struct comm_tunnel_t *tunnel){
+    struct kernel_json_str_t key;
+
+    if( ! kernel_json_expect(s, '{') ){ return; }
+    for( bool first = true; kernel_json_next(s, &first, '}', &key); ){
+        struct kernel_json_mark_t mark = kernel_json_mark( s );
+        if( (! kernel_json_is(&key, "mmap_array")) && kernel_json_peek(s, '{') ){   // <! every object member is a mmap entry
+            const char *mem_name = kernel_json_cstr( s, &key );
+            if( mem_name != NULL ){ kernel_json_scan_mmap_entry( s, tunnel, mem_name ); }
+            else                  { kernel_json_skip( s, 0 ); }
+        }else{
+            kernel_json_skip( s, 0 );
+        }
+        kernel_json_release( s, mark );
+        if( s->err ){ return; }
+    }
+}
+
+static void kernel_json_scan_mmap_req(struct kernel_json_scan_t *s, struct comm_tunnel_t *tunnel){
+    const char *src_core = NULL, *dst_core = NULL;
+    struct kernel_json_str_t key, str;
+
+    if( ! kernel_json_expect(s, '{') ){ return; }
+    for( bool first = true; kernel_json_next(s, &first, '}', &key); ){
+        if( kernel_json_is(&key, "src_core") || kernel_json_is(&key, "dst_core") ){
+            if( ! kernel_json_str(s, &str) ){ return; }
+            if( kernel_json_is(&key, "src_core") ){ src_core = kernel_json_cstr( s, &str ); }
+            else                                  { dst_core = kernel_json_cstr( s, &str ); }
+        }else{
+            if( ! kernel_json_skip(s, 0) ){ return; }
+        }
+    }
+    if( ! s->err ){
+        kernel_recv_mmap_sync_req( tunnel, src_core, dst_core );
+    }
+}
+
+/**
+ *  @brief is name listed in "Cores" array, array token is scanned again without decoding
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+static bool kernel_json_cores_has(const char *cores, const char *cores_end, const struct kernel_json_str_t *name){
+    struct kernel_json_scan_t a;  struct kernel_json_str_t item;
+    memset( &a, 0x0, sizeof(struct kernel_json_scan_t) );
+    a.p = cores;  a.end = cores_end;
+
+    if( ! kernel_json_expect(&a, '[') ){ return false; }
+    for( bool first = true; kernel_json_next(&a, &first, ']', NULL); ){
+        if( ! kernel_json_str(&a, &item) ){ return false; }
+        if( (item.len == name->len) && (memcmp(item.s, name->s, name->len) == 0) ){ return true; }
+    }
+    return false;
+}
+
+// !> KERNEL_CAP_xxx of "SupportXxx" key, 0 for other keys
+static uint16_t kernel_json_cap(const struct kernel_json_str_t *key){
+    for( int32_t i=0; i<KERNEL_CAP_NUM; i++ ){
+        if( kernel_json_is(key, kernel_cap_names[i].name) ){ return kernel_cap_names[i].cap; }
+    }
+    return 0;
+}
+
+static void kernel_json_scan_core(struct kernel_json_scan_t *s, struct kernel_recv_cores_t *ctx, const char *core_name){
+    struct kernel_recv_core_t c;  int64_t v = 0;  uint16_t cap = 0;
+    struct kernel_json_str_t key, str;
+    struct kernel_json_scan_t ids;                      // <! "TaskIds" is packed ahead of "TaskArray", walked in step
+    bool has_tasks = false, has_ids = false;
+
+    kernel_recv_core_init( &c, core_name );
+    memset( &ids, 0x0, sizeof(struct kernel_json_scan_t) );
+
+    if( ! kernel_json_expect(s, '{') ){ return; }
+    for( bool first = true; kernel_json_next(s, &first, '}', &key); ){
+        if( kernel_json_is(&key, "Jump") ){
+            if( ! kernel_json_num(s, &v) ){ return; }
+            c.jump = (int32_t)v;
+        }else if( kernel_json_is(&key, "CoreId") ){
+            if( ! kernel_json_num(s, &v) ){ return; }
+            c.core_id = (int32_t)v;
+        }else if( kernel_json_is(&key, "Cost") ){
+            if( ! kernel_json_num(s, &v) ){ return; }
+            c.cost = (int32_t)v;
+        }else if( kernel_json_is(&key, "Via") ){
+            if( ! kernel_json_num(s, &v) ){ return; }
+            c.via = (int32_t)v;
+        }else if( kernel_json_is(&key, "Version") ){
+            if( ! kernel_json_num(s, &v) ){ return; }
+            c.version = v;
+        }else if( 0 != (cap = kernel_json_cap(&key)) ){
+            c.caps_known |= cap;
+            if( kernel_json_peek(s, 't') ){ c.caps |= cap; }
+            if( ! kernel_json_skip(s, 0) ){ return; }
+        }else if( kernel_json_is(&key, "TaskIds") && (! has_tasks) && kernel_json_peek(s, '[') ){
+            ids.p = s->p;  ids.end = s->end;
+            if( ! kernel_json_skip(s, 0) ){ return; }
+            has_ids = kernel_json_expect( &ids, '[' );
+        }else if( kernel_json_is(&key, "TaskArray") && (! has_tasks) && kernel_json_peek(s, '[') ){
+            has_tasks = true;
+            struct MCUs_t *mcu = kernel_recv_core( ctx, &c );
+
+            kernel_json_expect( s, '[' );
+            bool first_id = true;
+            for( bool first_task = true; kernel_json_next(s, &first_task, ']', NULL); ){
+                if( ! kernel_json_str(s, &str) ){ return; }
+                int32_t task_id = -1;
+                if( has_ids && kernel_json_next(&ids, &first_id, ']', NULL) && kernel_json_num(&ids, &v) ){ task_id = (int32_t)v; }
+                else{ has_ids = false; }
+
+                struct kernel_json_mark_t mark = kernel_json_mark( s );
+                const char *task_name = kernel_json_cstr( s, &str );
+                if( task_name != NULL ){ kernel_recv_core_task( ctx, mcu, task_name, task_id ); }
+                kernel_json_release( s, mark );
+            }
+            if( s->err ){ return; }
+            kernel_recv_core_end( ctx, mcu );
+        }else{
+            if( ! kernel_json_skip(s, 0) ){ return; }
+        }
+    }
+    if( (! s->err) && (! has_tasks) ){
+        str_chksum( &ctx->peer_sum, core_name );        // <! listed core without TaskArray
+    }
+}
+
+/**
+ *  @brief unpack JSON frame without cJSON DOM, called by kernel_msg_layer_unpack
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return -1 when frame is left to cJSON DOM, before any member is handled
+ **/
+static int32_t kernel_json_scan_unpack(struct comm_tunnel_t *tunnel, const uint8_t *data, int32_t length){
+    uint8_t scratch[ KERNEL_JSON_SCAN_SCRATCH ];
+    struct kernel_json_scan_t s;
+    struct kernel_json_str_t key;
+
+    int32_t text_length = 0;                            // <! JSON text ends at '\0', extra data may follow
+    while( (text_length < length) && (data[text_length] != '\0') ){ text_length++; }
+
+    memset( &s, 0x0, sizeof(struct kernel_json_scan_t) );
+    s.p = (const char *)data;  s.end = (const char *)data + text_length;
+    s.scratch = scratch;  s.size = sizeof(scratch);
+
+    struct kernel_recv_cores_t ctx;
+    const char *cores = NULL, *cores_end = NULL;
+    bool local_known = ( get_my_core_name() != NULL );
+    bool first_key = true;                              // <! kernel builds every frame with one top-level kind
+
+    if( ! kernel_json_expect(&s, '{') ){ return 0; }
+    for( bool first = true; kernel_json_next(&s, &first, '}', &key); ){
+        if( first_key && kernel_json_needs_dom(&key) ){ return -1; }          // <! nothing dispatched, DOM parses frame once
+        first_key = false;
+
+        struct kernel_json_mark_t mark = kernel_json_mark( &s );
+        if( kernel_json_is(&key, "msg") ){
+            kernel_json_scan_msg( &s, tunnel, data, length );
+        }else if( kernel_json_is(&key, "mmap") && local_known ){
+            kernel_json_scan_mmap( &s, tunnel );
+        }else if( kernel_json_is(&key, "mmap_sync_req") && local_known ){
+            kernel_json_scan_mmap_req( &s, tunnel );
+        }else if( kernel_json_is(&key, "Cores") && local_known && kernel_json_peek(&s, '[') ){
+            cores = s.p;
+            if( ! kernel_json_skip(&s, 0) ){ break; }
+            cores_end = s.p;
+            kernel_recv_cores_begin( &ctx, tunnel );
+        }else if( (cores != NULL) && (! key.escaped) && kernel_json_peek(&s, '{') && kernel_json_cores_has(cores, cores_end, &key) ){
+            const char *core_name = kernel_json_cstr( &s, &key );
+            if( core_name != NULL ){ kernel_json_scan_core( &s, &ctx, core_name ); }
+            else                   { kernel_json_skip( &s, 0 ); }
+        }else{
+            kernel_json_skip( &s, 0 );
+        }
+        kernel_json_release( &s, mark );
+        if( s.err ){ break; }
+    }
+
+    if( s.err ){
+        WARNING( "Broken JSON frame at %d", (int)(s.p - (const char *)data) );
+    }
+    if( cores != NULL ){
+        kernel_recv_cores_end( &ctx );
+    }
+    return 0;
+}
+
+#endif
@@ -0,0 +1,402 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/*************************************************************************
+
+           -------------------------------------------------
+          |                                                 |
+          |       Link Cost, Least Cost Route, Failover     |
+          |                                                 |
+           -------------------------------------------------
+
+ Note:
+ 1.every tunnel of local core keeps metrics of its link:
+        rtt       : KERNEL_WIRE_PROBE echoed by peer, sent every KERNEL_LINK_PROBE_MS
+        loss      : probes not echoed before next probe
+        bandwidth : measured on blocking send of tunnel, or given by port
+                    (kernel_link_set_bandwidth)
+   link cost = KERNEL_LINK_HOP_COST + rtt + loss * KERNEL_LINK_LOSS_COST
+             + time to send KERNEL_LINK_REF_BYTES
+ 2.each core announces "Cost" of its route to every core and "Via", id of
+   the next core on that route, in task list sync. cost of path through a
+   tunnel is announced cost + link cost, path through local core (Via) is
+   poisoned, so every core ends on the least cost route (distance vector)
+ 3.every tunnel a core was announced from is kept as a path, route is
+   switched when another path is KERNEL_LINK_SWITCH_MARGIN percent cheaper
+ 4.link stalls when nothing was received in KERNEL_LINK_STALL_MS while
+   probes are sent, routes over it fail over to next best path at once and
+   task list is synced so peers learn new costs
+ 5.probes are only sent when every core announced "SupportLinkCost",
+   otherwise link cost is made of hop and bandwidth only
+
+*************************************************************************/
+
+#ifndef KERNEL_LINK_PROBE_MS
+#define KERNEL_LINK_PROBE_MS            1000            // <! 0 to disable probes
+#endif
+
+#ifndef KERNEL_LINK_STALL_MS
+#define KERNEL_LINK_STALL_MS            (3 * KERNEL_LINK_PROBE_MS)
+#endif
+
+#ifndef KERNEL_LINK_HOP_COST
+#define KERNEL_LINK_HOP_COST            10              // <! cost of each hop, keeps route short on equal links
+#endif
+
+#ifndef KERNEL_LINK_LOSS_COST
+#define KERNEL_LINK_LOSS_COST           10              // <! cost per percent of probes lost
+#endif
+
+#ifndef KERNEL_LINK_REF_BYTES
+#define KERNEL_LINK_REF_BYTES           128             // <! frame size to turn bandwidth into cost (ms)
+#endif
+
+#ifndef KERNEL_LINK_SWITCH_MARGIN
+#define KERNEL_LINK_SWITCH_MARGIN       20              // <! percent, no flapping between close paths
+#endif
+
+#define KERNEL_LINK_COST_MAX            0xFFFF          // <! unreachable
+#define KERNEL_LINK_BW_WINDOW_MS        100             // <! send time collected before bandwidth sample
+
+struct kernel_link_t {
+    struct kernel_link_t          *next;
+    struct comm_tunnel_t          *tunnel;
+    uint16_t                      peer_id;              // <! core id at the other end, 0: unknown
+
+    int32_t                       srtt8;                // <! rtt ms x8, EWMA
+    int32_t                       loss8;                // <! percent of lost probes x8, EWMA
+    int32_t                       bandwidth;            // <! bytes per second measured, 0: unknown
+    int32_t                       bandwidth_hint;       // <! given by port
+    int32_t                       tx_bytes;             // <! by kernel_link_sent, may be TX thread
+    int32_t                       tx_ms;
+
+    uint32_t                      probe_seq;
+    int32_t                       probe_time;           // <! tick of outstanding probe
+    bool                          probe_out;
+    int32_t                       probe_age_ms;         // <! since last probe sent
+    int32_t                       idle_ms;              // <! since last frame received
+    bool                          stalled;
+    int32_t                       cost;                 // <! cost routes were computed with
+};
+
+struct kernel_link_path_t {
+    struct kernel_link_path_t     *next;
+    struct comm_tunnel_t          *tunnel;
+    int32_t                       cost;                 // <! announced by peer, link cost not included
+    int32_t                       jump;
+};
+
+static struct kernel_link_t *kernel_link_queue = NULL;
+
+#ifdef PTHREAD_H
+static pthread_mutex_t kernel_link_list_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static struct kernel_link_t * kernel_link_of(struct comm_tunnel_t *tunnel, bool create){
+    #ifdef PTHREAD_H
+    pthread_mutex_lock( &kernel_link_list_mutex );      // <! kernel_link_sent may come from TX thread
+    #endif
+    struct kernel_link_t *l = kernel_link_queue;
+    while( l != NULL ){
+        if( l->tunnel == tunnel ){ break; }
+        l = l->next;
+    }
+
+    if( (l == NULL) && create && (tunnel != NULL) ){
+        if( NULL != (l = (struct kernel_link_t *)x_malloc( sizeof(struct kernel_link_t) )) ){
+            memset( l, 0x0, sizeof(struct kernel_link_t) );
+            l->tunnel = tunnel;
+            l->cost   = KERNEL_LINK_HOP_COST;
+            MOUNT( kernel_link_queue, l );
+        }
+    }
+    #ifdef PTHREAD_H
+    pthread_mutex_unlock( &kernel_link_list_mutex );
+    #endif
+    return l;
+}
+
+static int32_t kernel_link_cost_of(const struct kernel_link_t *l){
+    if( l->stalled ){ return KERNEL_LINK_COST_MAX; }
+
+    int32_t cost = KERNEL_LINK_HOP_COST + (l->srtt8 >> 3) + (l->loss8 >> 3) * KERNEL_LINK_LOSS_COST;
+    int32_t bandwidth = (l->bandwidth > 0)?(l->bandwidth):(l->bandwidth_hint);
+    if( bandwidth > 0 ){
+        cost += (int32_t)( (int64_t)KERNEL_LINK_REF_BYTES * 1000 / bandwidth );
+    }
+    return MIN( cost, KERNEL_LINK_COST_MAX );
+}
+
+static int32_t kernel_link_cost(struct comm_tunnel_t *tunnel){
+    struct kernel_link_t *l = kernel_link_of( tunnel, false );
+    return (l != NULL)?(l->cost):(KERNEL_LINK_HOP_COST);
+}
+
+/**
+ *  @brief nominal bandwidth of tunnel, used until it is measured
+ *
+ *  @param [in] bytes_per_sec : 0 for unknown
+ *  @param [out]
+ *  @return
+ **/
+void kernel_link_set_bandwidth(struct comm_tunnel_t *tunnel, int32_t bytes_per_sec){
+    struct kernel_link_t *l = kernel_link_of( tunnel, true );
+    if( l != NULL ){ l->bandwidth_hint = bytes_per_sec; }
+}
+
+/**
+ *  @brief frame handed to tunnel, called by kernel_tx_tunnel_send
+ *
+ *  @param [in] ms : time spent in send layers
+ *  @param [out]
+ *  @return
+ **/
+static void kernel_link_sent(struct comm_tunnel_t *tunnel, int32_t length, int32_t ms){
+    if( ms <= 0 ){ return; }                            // <! send did not block, nothing learnt
+    struct kernel_link_t *l = kernel_link_of( tunnel, true );
+    if( l == NULL ){ return; }
+    kernel_atomic_add32( &l->tx_bytes, length );
+    kernel_atomic_add32( &l->tx_ms, ms );
+}
+
+static void kernel_link_rx(struct comm_tunnel_t *tunnel){
+    struct kernel_link_t *l = kernel_link_of( tunnel, true );
+    if( l != NULL ){ l->idle_ms = 0; }
+}
+
+// !> core announced with Jump 1 is the peer of tunnel
+static void kernel_link_peer(struct comm_tunnel_t *tunnel, int32_t core_id){
+    if( (core_id <= 0) || (core_id > 0xFFFF) ){ return; }
+    struct kernel_link_t *l = kernel_link_of( tunnel, true );
+    if( l != NULL ){ l->peer_id = (uint16_t)core_id; }
+}
+
+// !> id of next core on route of mcu, announced as "Via"
+static uint16_t kernel_link_via(const struct MCUs_t *mcu){
+    if( mcu->is_local ){ return 0; }
+    struct kernel_link_t *l = kernel_link_of( mcu->tunnel, false );
+    return (l != NULL)?(l->peer_id):(0);
+}
+
+/**
+ *  @brief cost of core announced by peer
+ *
+ *  @param [in] cost, via : -1 when not announced (old peer), cost is made of jump then
+ *  @param [out]
+ *  @return cost without link cost
+ **/
+static int32_t kernel_link_announced(int32_t cost, int32_t jump, int32_t via){
+    struct MCUs_t *local = kernel_mcu_queue;
+    while( (local != NULL) && (! local->is_local) ){ local = local->next; }
+    if( (via > 0) && (local != NULL) && (via == local->id) ){
+        return KERNEL_LINK_COST_MAX;                    // <! peer routes it through me, poisoned
+    }
+    if( cost >= 0 ){ return MIN( cost, KERNEL_LINK_COST_MAX ); }
+    return (jump > 1)?((jump - 1) * KERNEL_LINK_HOP_COST):(0);
+}
+
+/**
+ *  @brief remember path to mcu through tunnel
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return true if path is new or changed
+ **/
+static bool kernel_link_path_update(struct MCUs_t *mcu, struct comm_tunnel_t *tunnel, int32_t cost, int32_t jump){
+    if( mcu->is_local || (tunnel == NULL) ){ return false; }
+
+    struct kernel_link_path_t *p = mcu->paths;
+    while( (p != NULL) && (p->tunnel != tunnel) ){ p = p->next; }
+    if( p == NULL ){
+        if( NULL == (p = (struct kernel_link_path_t *)x_malloc( sizeof(struct kernel_link_path_t) )) ){ return false; }
+        p->next = NULL;  p->tunnel = tunnel;  p->cost = -1;  p->jump = 0;
+        MOUNT( mcu->paths, p );
+    }
+    if( (p->cost == cost) && (p->jump == jump) ){ return false; }
+    p->cost = cost;
+    p->jump = jump;
+    return true;
+}
+
+static void kernel_link_path_free(struct MCUs_t *mcu){
+    struct kernel_link_path_t *p = NULL;
+    while( NULL != (p = mcu->paths) ){ UNMOUNT( mcu->paths, p );  x_free( p ); }
+}
+
+/**
+ *  @brief route mcu over path of least cost
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return true if tunnel of mcu changed
+ **/
+static bool kernel_link_select(struct MCUs_t *mcu){
+    if( mcu->is_local || (mcu->paths == NULL) ){ return false; }
+
+    struct kernel_link_path_t *best = NULL, *cur = NULL;
+    int32_t best_cost = KERNEL_LINK_COST_MAX, cur_cost = KERNEL_LINK_COST_MAX;
+    for( struct kernel_link_path_t *p = mcu->paths; p != NULL; p = p->next ){
+        int32_t cost = MIN( p->cost + kernel_link_cost(p->tunnel), KERNEL_LINK_COST_MAX );
+        if( p->tunnel == mcu->tunnel ){ cur = p;  cur_cost = cost; }
+        if( cost < best_cost ){ best = p;  best_cost = cost; }
+    }
+
+    if( best == NULL ){ mcu->cost = cur_cost;  return false; }   // <! no way out, keep route
+    if( (cur != NULL) && (cur_cost < KERNEL_LINK_COST_MAX) &&
+        (best_cost * (100 + KERNEL_LINK_SWITCH_MARGIN) >= cur_cost * 100) ){
+        best = cur;  best_cost = cur_cost;              // <! not cheaper enough
+    }
+    mcu->cost = best_cost;
+
+    if( best->tunnel == mcu->tunnel ){
+        if( mcu->jump != best->jump ){
+            mcu->jump = best->jump;
+            mcu->sync_mark |= KERNEL_SYNC_MARK_DIRTY;
+            kernel_route_changed();
+        }
+        return false;
+    }
+    LOG( "core (%s) rerouted, cost %d\r\n", mcu->core, best_cost );
+    return kernel_change_mcu_tunnel( mcu, best->tunnel, best->jump );
+}
+
+/**
+ *  @brief select route of every core again, link cost changed
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+static void kernel_link_reroute(void){
+    bool changed = false;
+    for( struct MCUs_t *mcu = kernel_mcu_queue; mcu != NULL; mcu = mcu->next ){
+        if( kernel_link_select(mcu) ){
+            kernel_mmap_update_to( mcu->core, false );  // <! update mmap when tunnel changed
+            mcu->task_modified = true;
+            changed = true;
+        }
+    }
+    if( changed ){ synchonize_tasklist( NULL, 0 ); }
+}
+
+  /**********************************************************************
+  |                                                                     |
+  |                              probe                                  |
+  |                                                                     |
+  **********************************************************************/
+
+static void kernel_link_send_probe(struct comm_tunnel_t *tunnel, uint8_t tag, uint32_t seq){
+    uint8_t *frame = (uint8_t *)x_malloc( 2 + 2 + 5 );
+    if( frame == NULL ){ return; }
+
+    struct kernel_wire_t w = { frame, 0, 2 + 2 + 5, false };
+    w.buf[ w.len++ ] = KERNEL_WIRE_MAGIC;
+    w.buf[ w.len++ ] = KERNEL_WIRE_PROBE;
+    kernel_wire_put_uint( &w, tag, seq );
+    kernel_tx_control( tunnel, frame, w.len );
+}
+
+/**
+ *  @brief probe or echo received, called by kernel_wire_unpack
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+static void kernel_link_unpack_probe(struct comm_tunnel_t *tunnel, struct kernel_wire_reader_t *r){
+    uint8_t tag;  const uint8_t *v;  int32_t len;
+    while( kernel_wire_next(r, &tag, &v, &len) ){
+        uint32_t seq = kernel_wire_uint( v, len );
+        if( tag == WIRE_PROBE_SEQ ){
+            kernel_link_send_probe( tunnel, WIRE_PROBE_ECHO, seq );
+        }else if( tag == WIRE_PROBE_ECHO ){
+            struct kernel_link_t *l = kernel_link_of( tunnel, false );
+            if( (l == NULL) || (! l->probe_out) || (seq != l->probe_seq) ){ continue; }     // <! late echo, counted as lost
+
+            int32_t rtt = MAX( kernel_get_tick_callback() - l->probe_time, 0 );
+            l->srtt8 = (l->srtt8 == 0)?(rtt * 8):(l->srtt8 + rtt - (l->srtt8 >> 3));
+            l->loss8 -= l->loss8 >> 3;
+            l->probe_out = false;
+        }
+    }
+}
+
+static void kernel_link_probe(struct kernel_link_t *l, int32_t delta_ms){
+    #if ( KERNEL_LINK_PROBE_MS > 0 )
+    l->probe_age_ms += delta_ms;
+    if( l->probe_age_ms < KERNEL_LINK_PROBE_MS ){ return; }
+
+    if( l->probe_out ){ l->loss8 += 100 - (l->loss8 >> 3); }   // <! previous probe lost
+    l->probe_age_ms = 0;
+    l->probe_out    = true;
+    l->probe_time   = kernel_get_tick_callback();
+    kernel_link_send_probe( l->tunnel, WIRE_PROBE_SEQ, ++l->probe_seq );
+    #endif
+}
+
+/**
+ *  @brief called at the end of scheduler pass, before kernel_route_pass_end
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+void kernel_link_pass_end(int32_t delta_ms){
+    struct MCUs_t *local = kernel_mcu_queue;
+    while( (local != NULL) && (! local->is_local) ){ local = local->next; }
+    if( local == NULL ){ return; }
+
+    bool reroute = false;
+    for( struct comm_tunnel_t *tunnel = local->tunnel; tunnel != NULL; tunnel = tunnel->next ){
+        struct kernel_link_t *l = kernel_link_of( tunnel, true );
+        if( l == NULL ){ continue; }
+        bool enabled = (! tunnel->passive_tunnel) || tunnel->tunnel_enabled;
+
+        int32_t tx_ms = kernel_atomic_load32( (uint32_t *)&l->tx_ms );
+        if( tx_ms >= KERNEL_LINK_BW_WINDOW_MS ){
+            int32_t tx_bytes = (int32_t)kernel_atomic_xchg32( (uint32_t *)&l->tx_bytes, 0 );
+            tx_ms = (int32_t)kernel_atomic_xchg32( (uint32_t *)&l->tx_ms, 0 );
+            int32_t bandwidth = (int32_t)( (int64_t)tx_bytes * 1000 / tx_ms );
+            l->bandwidth = (l->bandwidth > 0)?((l->bandwidth * 7 + bandwidth) / 8):(bandwidth);
+        }
+
+        bool stalled = false;
+        if( (all_support & KERNEL_CAP_LINK_COST) && enabled && (KERNEL_LINK_PROBE_MS > 0) ){
+            kernel_link_probe( l, delta_ms );
+            l->idle_ms += delta_ms;
+            stalled = (l->idle_ms >= KERNEL_LINK_STALL_MS);
+        }
+        if( stalled != l->stalled ){
+            l->stalled = stalled;
+            WARNING( "Tunnel %s", (stalled)?("stalled, fail over"):("recovered") );
+        }
+
+        int32_t cost = kernel_link_cost_of( l );
+        int32_t diff = (cost > l->cost)?(cost - l->cost):(l->cost - cost);
+        if( diff * 100 > l->cost * KERNEL_LINK_SWITCH_MARGIN ){
+            l->cost = cost;
+            reroute = true;
+        }
+    }
+    if( reroute ){ kernel_link_reroute(); }
+}
+
+/**
+ *  @brief time before next probe, used by kernel_idle_time
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return -1 if no probe
+ **/
+int32_t kernel_link_next_time(void){
+    int32_t min_time = -1;
+    #if ( KERNEL_LINK_PROBE_MS > 0 )
+    if( ! (all_support & KERNEL_CAP_LINK_COST) ){ return -1; }
+    for( struct kernel_link_t *l = kernel_link_queue; l != NULL; l = l->next ){
+        int32_t t = MAX( KERNEL_LINK_PROBE_MS - l->probe_age_ms, 0 );
+        if( (min_time < 0) || (t < min_time) ){ min_time = t; }
+    }
+    #endif
+    return min_time;
+}
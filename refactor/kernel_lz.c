@@ -0,0 +1,158 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/*************************************************************************
+
+           -------------------------------------------------
+          |                                                 |
+          |       Lightweight Compression of Payloads       |
+          |                                                 |
+           -------------------------------------------------
+
+ Note:
+ 1.LZ4 like block format, sequence of:
+        [token][literal len ext][literals][offset lo][offset hi][match len ext]
+   token: high nibble literal length, low nibble match length - 4, 15 is
+   followed by extension bytes (255 continues), the last sequence has
+   literals only
+ 2.compressor keeps 1 << KERNEL_LZ_HASH_BITS positions on stack, nothing
+   is allocated, decompressor works in place of given buffer
+ 3.used by kernel_wire.c for WIRE_DATA / WIRE_MEM_DATA when every core
+   announced "SupportLz", payload shorter than KERNEL_LZ_MIN_SIZE or not
+   getting smaller is sent as it is
+
+*************************************************************************/
+
+#ifndef KERNEL_LZ_MIN_SIZE
+#define KERNEL_LZ_MIN_SIZE              64              // <! 0 to disable compression
+#endif
+
+#ifndef KERNEL_LZ_HASH_BITS
+#define KERNEL_LZ_HASH_BITS             8               // <! 2 bytes of stack per entry
+#endif
+
+#define KERNEL_LZ_MIN_MATCH             4
+#define KERNEL_LZ_MAX_SIZE              0xFFFF          // <! positions are kept in 16 bits
+
+static uint32_t kernel_lz_read32(const uint8_t *p){
+    uint32_t v;
+    memcpy( &v, p, sizeof(v) );
+    return v;
+}
+
+static uint32_t kernel_lz_hash(uint32_t seq){
+    return (seq * 2654435761u) >> (32 - KERNEL_LZ_HASH_BITS);
+}
+
+static bool kernel_lz_put_len(uint8_t **op, const uint8_t *end, int32_t len){
+    while( len >= 255 ){
+        if( *op >= end ){ return false; }
+        *(*op)++ = 255;  len -= 255;
+    }
+    if( *op >= end ){ return false; }
+    *(*op)++ = (uint8_t)len;
+    return true;
+}
+
+static bool kernel_lz_get_len(const uint8_t **ip, const uint8_t *end, int32_t *len){
+    uint8_t b;
+    do{
+        if( *ip >= end ){ return false; }
+        b = *(*ip)++;  *len += b;
+    }while( b == 255 );
+    return true;
+}
+
+static bool kernel_lz_put_seq(uint8_t **op, const uint8_t *end, const uint8_t *literal, int32_t literal_len,
+                              int32_t offset, int32_t match_len){
+    uint8_t *token = (*op)++;
+    if( token >= end ){ return false; }
+
+    *token = (uint8_t)( ((literal_len < 15)?(literal_len):(15)) << 4 );
+    if( (literal_len >= 15) && (! kernel_lz_put_len(op, end, literal_len - 15)) ){ return false; }
+    if( *op + literal_len > end ){ return false; }
+    memcpy( *op, literal, literal_len );
+    *op += literal_len;
+
+    if( match_len == 0 ){ return true; }                // <! last sequence
+    if( *op + 2 > end ){ return false; }
+    *(*op)++ = (uint8_t)( offset & 0xFF );
+    *(*op)++ = (uint8_t)( offset >> 8 );
+
+    match_len -= KERNEL_LZ_MIN_MATCH;
+    *token |= (uint8_t)( (match_len < 15)?(match_len):(15) );
+    if( (match_len >= 15) && (! kernel_lz_put_len(op, end, match_len - 15)) ){ return false; }
+    return true;
+}
+
+/**
+ *  @brief compress src into dst
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return compressed length, -1 when it does not fit in dst_size
+ **/
+static int32_t kernel_lz_compress(const uint8_t *src, int32_t length, uint8_t *dst, int32_t dst_size){
+    if( (length <= 0) || (length > KERNEL_LZ_MAX_SIZE) ){ return -1; }
+
+    uint16_t table[ 1 << KERNEL_LZ_HASH_BITS ];
+    memset( table, 0xFF, sizeof(table) );               // <! 0xFFFF: empty
+
+    uint8_t *op = dst, *end = dst + dst_size;
+    int32_t ip = 0, anchor = 0;
+    while( ip + KERNEL_LZ_MIN_MATCH <= length ){
+        uint32_t seq = kernel_lz_read32( &src[ip] );
+        uint32_t h   = kernel_lz_hash( seq );
+        int32_t  ref = table[ h ];
+        table[ h ] = (uint16_t)ip;
+
+        if( (ref == 0xFFFF) || (kernel_lz_read32(&src[ref]) != seq) ){ ip++;  continue; }
+
+        int32_t match_len = KERNEL_LZ_MIN_MATCH;
+        while( (ip + match_len < length) && (src[ref + match_len] == src[ip + match_len]) ){ match_len++; }
+
+        if( ! kernel_lz_put_seq(&op, end, &src[anchor], ip - anchor, ip - ref, match_len) ){ return -1; }
+        ip += match_len;
+        anchor = ip;
+    }
+    if( ! kernel_lz_put_seq(&op, end, &src[anchor], length - anchor, 0, 0) ){ return -1; }
+    return (int32_t)(op - dst);
+}
+
+/**
+ *  @brief decompress src into dst of raw_length
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return raw_length, -1 if broken
+ **/
+static int32_t kernel_lz_decompress(const uint8_t *src, int32_t length, uint8_t *dst, int32_t raw_length){
+    const uint8_t *ip = src, *ip_end = src + length;
+    uint8_t *op = dst, *op_end = dst + raw_length;
+
+    while( ip < ip_end ){
+        uint8_t token = *ip++;
+
+        int32_t literal_len = token >> 4;
+        if( (literal_len == 15) && (! kernel_lz_get_len(&ip, ip_end, &literal_len)) ){ return -1; }
+        if( (ip + literal_len > ip_end) || (op + literal_len > op_end) ){ return -1; }
+        memcpy( op, ip, literal_len );
+        ip += literal_len;  op += literal_len;
+        if( ip == ip_end ){ break; }                    // <! last sequence
+
+        if( ip + 2 > ip_end ){ return -1; }
+        int32_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if( (offset == 0) || (offset > op - dst) ){ return -1; }
+
+        int32_t match_len = token & 0x0F;
+        if( (match_len == 15) && (! kernel_lz_get_len(&ip, ip_end, &match_len)) ){ return -1; }
+        match_len += KERNEL_LZ_MIN_MATCH;
+        if( op + match_len > op_end ){ return -1; }
+
+        const uint8_t *match = op - offset;
+        while( match_len-- > 0 ){ *op++ = *match++; }   // <! may overlap
+    }
+    return (op == op_end)?(raw_length):(-1);
+}
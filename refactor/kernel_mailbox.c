@@ -5,93 +5,668 @@
 struct kernel_mailbox_t {
     int32_t mailbox_type : 1;         // <! mailbox and timer in 1 union, use this to determin.
     int32_t occupied     : 1;
-    int32_t token        : 1;
-    int32_t reserved     : 29;        // <! reserved for timer which declear above
+    int32_t spare        : 2;         // <! bit 3 overlaps timer.enable, keep 0 for mailbox msg
+    int32_t index        : 20;        // <! box index in group, bit of group bitmaps
+    int32_t reserved     : 8;
 
-    struct kernel_task_t *task_handler;
+    struct kernel_task_t          *task_handler;
+    struct kernel_mailbox_group_t *group;
 };
 
 struct kernel_mailbox_group_t {
     struct kernel_mailbox_group_t *next;
-    struct kernel_msg_t           *mailbox_queue;
+    struct kernel_mailbox_group_t *class_next;             // <! next group in same size class, small -> large
+    struct kernel_msg_t           **boxes;                 // <! box of index
+    uint32_t                      *claimed_map;            // <! bit set: box claimed by producer (and pad bits)
+    uint32_t                      *ready_map;              // <! bit set: box posted to task, wait for drain
+    int32_t                       map_words;
     int32_t                       box_size;
-    int32_t                       num_of_boxes;
+    int32_t                       num_of_boxes;            // <! boxes malloced now
+    int32_t                       min_boxes;               // <! size asked by create_mailbox, never shrink below
+    int32_t                       max_boxes;               // <! slots of box table, never grow above
+    int32_t                       in_use;                  // <! claimed boxes
     bool                          unread_msg;
+
+    // !> telemetry, producers only touch peak / claim_fail
+    int32_t                       peak_in_use;             // <! since boot
+    int32_t                       window_peak;             // <! since last maintain
+    uint32_t                      claim_fail;              // <! claims found group full
+    uint32_t                      full_ms;                 // <! time at full occupancy
+    uint32_t                      idle_ms;                 // <! time above high watermark, reset on grow / shrink
+    uint32_t                      grow_cnt;
+    uint32_t                      shrink_cnt;
 };
 
+#ifndef KERNEL_MAILBOX_CLASS_NUM
+#define KERNEL_MAILBOX_CLASS_NUM        16              // <! class k holds box_size in [2^k, 2^(k+1)), last one holds the rest
+#endif
+
+#ifndef KERNEL_MAILBOX_POOL_NUM
+#define KERNEL_MAILBOX_POOL_NUM         1               // <! 1 pool per cpu (or per producer) on SMP host
+#endif
+
+#ifndef KERNEL_MAILBOX_POOL_ID
+#define KERNEL_MAILBOX_POOL_ID()        (0)             // <! pool of current producer, port maps it to cpu id
+#endif
+
+struct kernel_mailbox_pool_t {
+    struct kernel_mailbox_group_t *group_queue;                             // <! groups of pool, drain order
+    struct kernel_mailbox_group_t *class[KERNEL_MAILBOX_CLASS_NUM];
+    uint32_t                      class_mask;                               // <! bit k set: class k has group
+};
+
+#ifndef KERNEL_MAILBOX_ELASTIC_FACTOR
+#define KERNEL_MAILBOX_ELASTIC_FACTOR   4               // <! group may grow up to factor x created boxes, 1 to disable
+#endif
+
+#ifndef KERNEL_MAILBOX_LOW_WATERMARK
+#define KERNEL_MAILBOX_LOW_WATERMARK    25              // <! free boxes under 25%: grow
+#endif
+
+#ifndef KERNEL_MAILBOX_HIGH_WATERMARK
+#define KERNEL_MAILBOX_HIGH_WATERMARK   75              // <! free boxes above 75% for KERNEL_MAILBOX_SHRINK_MS: shrink
+#endif
+
+#ifndef KERNEL_MAILBOX_SHRINK_MS
+#define KERNEL_MAILBOX_SHRINK_MS        10000
+#endif
+
+static bool kernel_spill_create(void);
+static struct kernel_msg_t * kernel_spill_alloc(int32_t length);
+static void kernel_spill_ready(struct kernel_msg_t *p);
+static void kernel_spill_release(struct kernel_msg_t *p);
+static void kernel_msg_ref_release(struct kernel_msg_t *p);
+
+static struct kernel_mailbox_pool_t kernel_mailbox_pool[KERNEL_MAILBOX_POOL_NUM];
+static int32_t kernel_mailbox_drain_first = 0;          // <! pool drained first, rotate every pass
+static uint32_t kernel_mailbox_drop = 0;                // <! msg dropped for no box, reported in task context
+static uint32_t kernel_mailbox_drop_reported = 0;
+
+static int32_t kernel_clz32(uint32_t x){
+    if( x == 0 ){ return 32; }
+    #if defined (__GNUC__) || defined (__clang__)
+    return __builtin_clz( x );
+    #elif defined (__CC_ARM)
+    return __clz( x );
+    #else
+    int32_t n = 0;
+    while( ! (x & 0x80000000) ){ x <<= 1;  n++; }
+    return n;
+    #endif
+}
+
+static int32_t kernel_ctz32(uint32_t x){
+    if( x == 0 ){ return 32; }
+    return 31 - kernel_clz32( x & (~x + 1) );           // <! isolate lowest set bit
+}
+
+  /**********************************************************************
+  |                                                                     |
+  |     word atomics: claim from ISR / producer thread, release in task |
+  |                                                                     |
+  **********************************************************************/
+
+// !> KERNEL_MAILBOX_ATOMIC   : compiler atomics, lock free
+//    KERNEL_MAILBOX_IRQ_LOCK : read-modify-write with interrupts masked (PRIMASK saved / restored),
+//                              ARMCC5 and ARMv6-M, where GCC lowers __atomic_fetch_xxx to libatomic
+//    other targets give KERNEL_ATOMIC_ENTER() / KERNEL_ATOMIC_EXIT(saved) in port
+#if defined (KERNEL_ATOMIC_ENTER) && defined (KERNEL_ATOMIC_EXIT)
+#define KERNEL_MAILBOX_IRQ_LOCK
+#elif defined (__CC_ARM) || defined (__ARM_ARCH_6M__)
+#define KERNEL_MAILBOX_IRQ_LOCK
+#elif defined (__GNUC__) || defined (__clang__)
+#define KERNEL_MAILBOX_ATOMIC
+#else
+#error "no ISR safe atomics, define KERNEL_ATOMIC_ENTER() / KERNEL_ATOMIC_EXIT(saved) in port"
+#endif
+
+#if defined (KERNEL_MAILBOX_IRQ_LOCK) && ! defined (KERNEL_ATOMIC_ENTER)
+static uint32_t kernel_atomic_enter(void){              // <! mask interrupts, return PRIMASK before
+    #if defined (__CC_ARM)
+    register uint32_t primask __asm( "primask" );
+    uint32_t saved = primask;
+    __disable_irq();
+    return saved;
+    #else
+    uint32_t saved;
+    __asm volatile( "mrs %0, primask\n\tcpsid i" : "=r"(saved) : : "memory" );
+    return saved;
+    #endif
+}
+
+static void kernel_atomic_exit(uint32_t saved){
+    if( saved & 0x1 ){ return; }                         // <! masked by caller already, keep it
+    #if defined (__CC_ARM)
+    __enable_irq();
+    #else
+    __asm volatile( "cpsie i" : : : "memory" );
+    #endif
+}
+
+#define KERNEL_ATOMIC_ENTER()           kernel_atomic_enter()
+#define KERNEL_ATOMIC_EXIT(saved)       kernel_atomic_exit( saved )
+#endif
+
+static uint32_t kernel_atomic_load32(uint32_t *p){
+    #ifdef KERNEL_MAILBOX_ATOMIC
+    return __atomic_load_n( p, __ATOMIC_ACQUIRE );
+    #else
+    return *(volatile uint32_t *)p;
+    #endif
+}
+
+static void kernel_atomic_or32(uint32_t *p, uint32_t v){
+    #ifdef KERNEL_MAILBOX_ATOMIC
+    __atomic_fetch_or( p, v, __ATOMIC_RELEASE );
+    #else
+    uint32_t saved = KERNEL_ATOMIC_ENTER();
+    *(volatile uint32_t *)p |= v;
+    KERNEL_ATOMIC_EXIT( saved );
+    #endif
+}
+
+static void kernel_atomic_and32(uint32_t *p, uint32_t v){
+    #ifdef KERNEL_MAILBOX_ATOMIC
+    __atomic_fetch_and( p, v, __ATOMIC_RELEASE );
+    #else
+    uint32_t saved = KERNEL_ATOMIC_ENTER();
+    *(volatile uint32_t *)p &= v;
+    KERNEL_ATOMIC_EXIT( saved );
+    #endif
+}
+
+static uint32_t kernel_atomic_xchg32(uint32_t *p, uint32_t v){
+    #ifdef KERNEL_MAILBOX_ATOMIC
+    return __atomic_exchange_n( p, v, __ATOMIC_ACQ_REL );
+    #else
+    uint32_t saved = KERNEL_ATOMIC_ENTER();
+    uint32_t old = *(volatile uint32_t *)p;  *(volatile uint32_t *)p = v;
+    KERNEL_ATOMIC_EXIT( saved );
+    return old;
+    #endif
+}
+
+static int32_t kernel_atomic_add32(int32_t *p, int32_t v){
+    #ifdef KERNEL_MAILBOX_ATOMIC
+    return __atomic_add_fetch( p, v, __ATOMIC_RELAXED );
+    #else
+    uint32_t saved = KERNEL_ATOMIC_ENTER();
+    int32_t n = (*(volatile int32_t *)p += v);
+    KERNEL_ATOMIC_EXIT( saved );
+    return n;
+    #endif
+}
+
+static bool kernel_atomic_cas32(uint32_t *p, uint32_t *expected, uint32_t desired){
+    #ifdef KERNEL_MAILBOX_ATOMIC
+    return __atomic_compare_exchange_n( p, expected, desired, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED );
+    #else
+    uint32_t saved = KERNEL_ATOMIC_ENTER();
+    uint32_t now = *(volatile uint32_t *)p;
+    bool ok = ( now == *expected );
+    if( ok ){ *(volatile uint32_t *)p = desired; }
+    KERNEL_ATOMIC_EXIT( saved );
+    if( ! ok ){ *expected = now; }
+    return ok;
+    #endif
+}
+
+static void * kernel_atomic_load_ptr(void **p){
+    #ifdef KERNEL_MAILBOX_ATOMIC
+    return __atomic_load_n( p, __ATOMIC_ACQUIRE );
+    #else
+    return *(void * volatile *)p;
+    #endif
+}
+
+static void * kernel_atomic_xchg_ptr(void **p, void *v){
+    #ifdef KERNEL_MAILBOX_ATOMIC
+    return __atomic_exchange_n( p, v, __ATOMIC_ACQ_REL );
+    #else
+    uint32_t saved = KERNEL_ATOMIC_ENTER();
+    void *old = *(void * volatile *)p;  *(void * volatile *)p = v;
+    KERNEL_ATOMIC_EXIT( saved );
+    return old;
+    #endif
+}
+
+static void kernel_atomic_fence(void){
+    #ifdef KERNEL_MAILBOX_ATOMIC
+    __atomic_thread_fence( __ATOMIC_SEQ_CST );
+    #elif defined (__CC_ARM)
+    __dmb( 0xF );
+    #elif defined (__GNUC__) || defined (__clang__)
+    __asm volatile( "dmb 0xF" : : : "memory" );
+    #endif
+}
+
+static int32_t kernel_mailbox_class_of(int32_t size){
+    int32_t c = 31 - kernel_clz32( (uint32_t)size );   // <! floor( log2(size) )
+    return MIN( c, KERNEL_MAILBOX_CLASS_NUM - 1 );
+}
+
 /**
- *  @brief create mailbox group 
+ *  @brief malloc box table and bitmaps of new group, bits are claimed until box filled
+ *         Note: table is never swapped once group is linked, producers claim through it
+ *               without lock, so live group refuses to resize, elastic grow / shrink
+ *               and later create_mailbox stay inside max_boxes
  * 
  *  @param [in]
  *  @param [out]
  *  @return 
  **/
-bool create_mailbox( int32_t mailbox_size,
-                     int32_t num_of_boxes
-                   ){
+static bool kernel_mailbox_group_resize(struct kernel_mailbox_group_t *g, int32_t num_of_boxes){
+    int32_t words = (num_of_boxes + 31) / 32;
+    if( g->map_words > 0 ){ return (words <= g->map_words); }   // <! live group
+
+    struct kernel_msg_t **boxes = (struct kernel_msg_t **)x_malloc( words * 32 * sizeof(struct kernel_msg_t *) );
+    uint32_t *maps = (uint32_t *)x_malloc( words * 2 * sizeof(uint32_t) );
+    if( (boxes == NULL) || (maps == NULL) ){
+        if( boxes != NULL ){ x_free( boxes ); }
+        if( maps != NULL ) { x_free( maps );  }
+        return false;
+    }
+
+    memset( boxes, 0x0, words * 32 * sizeof(struct kernel_msg_t *) );
+    memset( &maps[0],     0xFF, words * sizeof(uint32_t) );   // <! claimed_map: no box yet
+    memset( &maps[words], 0x00, words * sizeof(uint32_t) );   // <! ready_map
+    g->boxes       = boxes;
+    g->claimed_map = &maps[0];
+    g->ready_map   = &maps[words];
+    g->map_words   = words;
+    return true;
+}
+
+/**
+ *  @brief malloc boxes into empty slots of group, box is published by clearing its claimed bit
+ * 
+ *  @param [in]
+ *  @param [out]
+ *  @return number of boxes added
+ **/
+static int32_t kernel_mailbox_group_fill(struct kernel_mailbox_group_t *g, int32_t num_of_boxes){
+    int32_t added = 0;
+
+    for( int32_t i=0; (i<g->max_boxes) && (added<num_of_boxes); i++ ){
+        if( g->boxes[i] != NULL ){ continue; }
+
+        struct kernel_msg_t *p = (struct kernel_msg_t *)x_malloc( sizeof(struct kernel_msg_t) + g->box_size );
+        if( p == NULL ){ break; }
+        memset( p, 0x0, sizeof(struct kernel_msg_t) + g->box_size );
+
+        p->mail.mailbox_type = 1;
+        p->mail.group        = g;
+        p->mail.index        = i;
+        g->boxes[i]          = p;
+        g->num_of_boxes++;                      // <! record num of malloced boxes
+        kernel_atomic_and32( &g->claimed_map[i / 32], ~(1u << (i % 32)) );   // <! box is free now
+        added++;
+    }
+    return added;
+}
+
+/**
+ *  @brief take free boxes out of group from the highest slot and free them
+ *         the claimed bit is taken like a producer would, and kept set so no one can claim it again
+ * 
+ *  @param [in]
+ *  @param [out]
+ *  @return number of boxes freed
+ **/
+static int32_t kernel_mailbox_group_park(struct kernel_mailbox_group_t *g, int32_t num_of_boxes){
+    int32_t parked = 0;
+
+    for( int32_t i=g->max_boxes-1; (i>=0) && (parked<num_of_boxes); i-- ){
+        if( g->boxes[i] == NULL ){ continue; }
+
+        uint32_t *word = &g->claimed_map[i / 32], bit = 1u << (i % 32);
+        uint32_t v = kernel_atomic_load32( word );
+        while( ! (v & bit) ){
+            if( kernel_atomic_cas32(word, &v, v | bit) ){
+                x_free( g->boxes[i] );
+                g->boxes[i] = NULL;
+                g->num_of_boxes--;
+                parked++;
+                break;
+            }
+        }
+    }
+    return parked;
+}
+
+/**
+ *  @brief create mailbox group in pool
+ * 
+ *  @param [in]
+ *  @param [out]
+ *  @return 
+ **/
+bool create_mailbox_on_pool( int32_t pool_id,
+                             int32_t mailbox_size,
+                             int32_t num_of_boxes
+                           ){
     /*****************************************************************************
      *                          mailbox group structure                          * 
      *                                                                           *
-     *  mailbox_group1 ------> mailbox_group2 ------> mailbox_group3             *
-     *         |                      |                      |                   *
-     *      mailbox1               mailbox1               mailbox1               *
-     *         |                      |                      |                   *
-     *      mailbox2               mailbox2               mailbox2               *
-     *         |                      |                      |                   *
-     *      mailbox...             mailbox...             mailbox...             *
+     *  pool[i].class[0]  ...   class[k] ------> class[k+1] ...                 *
+     *                                 |                 |                       *
+     *                              group(2^k) ------> group(2^(k+1)+8)          *
+     *                                 |  class_next                             *
+     *                              group(2^k+4)                                 *
+     *                                 |                                         *
+     *                              boxes[] + claimed_map / ready_map            *
      *                                                                           *
      * Note:                                                                     *
      * 1.mailbox组按照单个mailbox的size大小由小到大加入链表中                       * 
      * 2.假设size有1 2 3，则实现上述结构需要处理以下逻辑                            *   
      *   * 3 -> 1 2(顺序)   * 2 -> 1 3(存在逆序)    * 2 -> 1 2(存在相同情况)       *
+     * 3.group is placed in class floor(log2(box_size)), groups of same class    *
+     *   are linked from small to large, same size group shares one group        *
+     * 4.all groups of pool are linked in pool[i].group_queue for drain          *
      * ***************************************************************************/
+    ASSERT_TRUE( (pool_id >= 0) && (pool_id < KERNEL_MAILBOX_POOL_NUM) );
     ASSERT_TRUE( mailbox_size > 0 );
     ASSERT_TRUE( num_of_boxes > 0 );
 
-    struct kernel_mailbox_group_t *q = kernel_mailbox_group_queue, *g = NULL;
-    while( q != NULL ){
-        if( mailbox_size > q->box_size ){ g = q;  q = q->next; continue; }  // <! search the insert point
-        break;
-    }
+    struct kernel_mailbox_pool_t *pool = &kernel_mailbox_pool[pool_id];
+    int32_t c = kernel_mailbox_class_of( mailbox_size );
+
+    struct kernel_mailbox_group_t *q = pool->class[c], *prev = NULL, *g = NULL;
+    while( (q != NULL) && (q->box_size < mailbox_size) ){ prev = q;  q = q->class_next; }   // <! search the insert point
 
     // !>    situation: 2 -> 1 3 or 2 -> 1 2
-    if( q != NULL ){                          // <! found (a match size) or (a insert point)
-        if( mailbox_size < q->box_size ){       // <! size doesn't match
-            if( g != NULL ){ g->next = NULL; }    // <! break the queue from (g) to (g->next)
-        }else{ 
-            g = q; goto FILL_BOXES;            // !> situation ：2 -> 1 2 3  ----> 1 2 2 3 
-        }       // <! size match exactly, no need to malloc
-    }else{  }                                 // <! (group_queue == NULL) or (box_size > all_exist_box)
-
-    g = (struct kernel_mailbox_group_t *)x_malloc( sizeof(struct kernel_mailbox_group_t) );
-    if( g != NULL ){
-        memset( g, 0x0, sizeof(struct kernel_mailbox_group_t) );
-        g->box_size = mailbox_size;
-        MOUNT( kernel_mailbox_group_queue, g ); // <! MOUNT new group to queue
-        g->next = q;                            // <! Join the queue together, doesn't hurt if q == NULL
-    }
-
-    FILL_BOXES:
-    if( g != NULL ){
-        while( num_of_boxes-- ){
-            struct kernel_msg_t *p = (struct kernel_msg_t *)x_malloc( sizeof(struct kernel_msg_t) + mailbox_size );
-            if( p != NULL ){
-                memset( p, 0x0, sizeof(struct kernel_msg_t) + mailbox_size );
-
-                p->mail.mailbox_type = 1;
-            
-                MOUNT( g->mailbox_queue, p );       // <! MOUNT to mailbox_group->mailbox_queue
-                g->num_of_boxes++;                  // <! record num of malloced boxes
-            }
+    if( (q != NULL) && (q->box_size == mailbox_size) ){
+        g = q;                                          // !> situation ：2 -> 1 2 3  ----> 1 2 2 3 
+    }else{                                              // <! size doesn't match, (class == NULL) or (box_size > all_exist_box)
+        g = (struct kernel_mailbox_group_t *)x_malloc( sizeof(struct kernel_mailbox_group_t) );
+        if( g != NULL ){
+            memset( g, 0x0, sizeof(struct kernel_mailbox_group_t) );
+            g->box_size   = mailbox_size;
+            g->class_next = q;
+            if( prev != NULL ){ prev->class_next = g; }
+            else{ pool->class[c] = g; }
+            pool->class_mask |= (1u << c);
+            MOUNT( pool->group_queue, g );              // <! MOUNT new group to queue
         }
     }
 
+    if( (g != NULL) && (g->max_boxes == 0) ){           // <! new group, table sized once before producers see it
+        int32_t max_boxes = num_of_boxes * KERNEL_MAILBOX_ELASTIC_FACTOR;
+        if( kernel_mailbox_group_resize(g, max_boxes) ){ g->max_boxes = max_boxes; }
+    }
+
+    if( (g != NULL) && (g->max_boxes > 0) ){            // <! same size asked again: take elastic room of the table
+        int32_t spare = MIN( MAX(g->num_of_boxes - g->min_boxes, 0), num_of_boxes );   // <! elastic boxes already malloced
+        g->min_boxes  = MIN( g->min_boxes + num_of_boxes, g->max_boxes );
+        num_of_boxes -= spare;
+        num_of_boxes -= kernel_mailbox_group_fill( g, num_of_boxes );
+    }
+
     if( num_of_boxes <= 0 ){ return true; }
 
     WARNING( "No memory for Mailbox" );
     return false;
 }
 
+/**
+ *  @brief create mailbox group, boxes are split over all pools
+ * 
+ *  @param [in]
+ *  @param [out]
+ *  @return 
+ **/
+bool create_mailbox( int32_t mailbox_size,
+                     int32_t num_of_boxes
+                   ){
+    int32_t per_pool = (num_of_boxes + KERNEL_MAILBOX_POOL_NUM - 1) / KERNEL_MAILBOX_POOL_NUM;
+    bool ret = kernel_spill_create();
+
+    for( int32_t i=0; i<KERNEL_MAILBOX_POOL_NUM; i++ ){
+        ret &= create_mailbox_on_pool( i, mailbox_size, per_pool );
+    }
+    return ret;
+}
+
+/**
+ *  @brief claim a free box of group: find first zero of claimed_map
+ *         return NULL if all boxes are occupied
+ * 
+ *  @param [in]
+ *  @param [out]
+ *  @return 
+ **/
+static struct kernel_msg_t * kernel_mailbox_claim(struct kernel_mailbox_group_t *g){
+    for( int32_t w=0; w<g->map_words; w++ ){
+        uint32_t v = kernel_atomic_load32( &g->claimed_map[w] );
+        while( v != 0xFFFFFFFF ){
+            int32_t b = kernel_ctz32( ~v );
+            if( kernel_atomic_cas32(&g->claimed_map[w], &v, v | (1u << b)) ){   // <! v reloaded when failed
+                struct kernel_msg_t *p = g->boxes[ w * 32 + b ];
+                int32_t n = kernel_atomic_add32( &g->in_use, 1 );
+                if( n > g->window_peak ){ g->window_peak = n; }     // <! racy max, telemetry only
+                p->mail.occupied = 1;
+                g->unread_msg    = true;
+                return p;
+            }
+        }
+    }
+    kernel_atomic_add32( (int32_t *)&g->claim_fail, 1 );
+    return NULL;
+}
+
+/**
+ *  @brief mark box posted, scheduler drains it in next pass
+ * 
+ *  @param [in]
+ *  @param [out]
+ *  @return 
+ **/
+static void kernel_mailbox_ready(struct kernel_msg_t *p){
+    struct kernel_mailbox_group_t *g = p->mail.group;
+    if( g == NULL ){ kernel_spill_ready( p );  return; }     // <! record of spill ring
+    kernel_atomic_or32( &g->ready_map[p->mail.index / 32], 1u << (p->mail.index % 32) );
+    g->unread_msg = true;
+}
+
+/**
+ *  @brief give box back to group
+ * 
+ *  @param [in]
+ *  @param [out]
+ *  @return 
+ **/
+static void kernel_mailbox_release(struct kernel_msg_t *p){
+    struct kernel_mailbox_group_t *g = p->mail.group;
+    if( g == NULL ){ kernel_spill_release( p );  return; }   // <! record of spill ring
+
+    uint32_t bit = 1u << (p->mail.index % 32);
+
+    p->mail.task_handler = NULL;
+    p->mail.occupied     = 0;
+    kernel_atomic_add32( &g->in_use, -1 );
+    kernel_atomic_and32( &g->ready_map[p->mail.index / 32], ~bit );
+    kernel_atomic_and32( &g->claimed_map[p->mail.index / 32], ~bit );   // <! release last, box can be claimed again
+}
+
+/**
+ *  @brief claim a box of pool which fits length, select group by size class
+ *         class of need: groups may be smaller, check size
+ *         larger classes: every group fits, fallback to the next class when exhausted
+ * 
+ *  @param [in]
+ *  @param [out]
+ *  @return 
+ **/
+static struct kernel_msg_t * kernel_mailbox_pool_alloc(struct kernel_mailbox_pool_t *pool, int32_t length){
+    int32_t need = length + 2;                          // <! box_size > length + 1
+    int32_t c = kernel_mailbox_class_of( need );
+    struct kernel_mailbox_group_t *g = NULL;
+    struct kernel_msg_t *p = NULL;
+
+    for( g = pool->class[c]; g != NULL; g = g->class_next ){
+        if( g->box_size < need ){ continue; }
+        if( NULL != (p = kernel_mailbox_claim(g)) ){ return p; }
+    }
+
+    uint32_t mask = (c < 31)?( pool->class_mask & ~((2u << c) - 1) ):(0);
+    while( mask != 0 ){
+        for( g = pool->class[ kernel_ctz32(mask) ]; g != NULL; g = g->class_next ){
+            if( NULL != (p = kernel_mailbox_claim(g)) ){ return p; }
+        }
+        mask &= mask - 1;                               // <! class exhausted, next class
+    }
+    return NULL;
+}
+
+/**
+ *  @brief claim a box from pool of current producer,
+ *         steal from the other pools only when local pool is exhausted,
+ *         spill ring is the last resort
+ * 
+ *  @param [in]
+ *  @param [out]
+ *  @return 
+ **/
+static struct kernel_msg_t * kernel_mailbox_alloc(int32_t length){
+    int32_t self = (int32_t)( (uint32_t)KERNEL_MAILBOX_POOL_ID() % KERNEL_MAILBOX_POOL_NUM );
+    struct kernel_msg_t *p = NULL;
+
+    for( int32_t i=0; i<KERNEL_MAILBOX_POOL_NUM; i++ ){
+        p = kernel_mailbox_pool_alloc( &kernel_mailbox_pool[ (self + i) % KERNEL_MAILBOX_POOL_NUM ], length );
+        if( p != NULL ){ return p; }
+    }
+    if( NULL != (p = kernel_spill_alloc(length)) ){ return p; }
+    kernel_atomic_add32( (int32_t *)&kernel_mailbox_drop, 1 );    // <! never log in ISR, kernel_mailbox_maintain reports it
+    return NULL;
+}
+
+/**
+ *  @brief copy posted boxes of group to msg_queue of aimed task, run in scheduler
+ * 
+ *  @param [in]
+ *  @param [out]
+ *  @return 
+ **/
+static void kernel_mailbox_drain_group(struct kernel_mailbox_group_t *g){
+    g->unread_msg = false;                  // <! we are going to read all the boxes
+                                            // <! in case new message arrived while fetch mail, we clear here
+                                            // <! so the unread flag won't be accidentally clear in the process
+    for( int32_t w=0; w<g->map_words; w++ ){
+        uint32_t bits = kernel_atomic_load32( &g->ready_map[w] );
+        while( bits != 0 ){                 // <! only visit posted boxes
+            struct kernel_msg_t *m = g->boxes[ w * 32 + kernel_ctz32(bits) ];
+            bits &= bits - 1;
+
+            struct kernel_msg_t *nmsg = new_msg( m->msg.notification, m->msg.data, m->msg.length );
+            if( nmsg != NULL ){
+                struct kernel_task_t *t = m->mail.task_handler;
+                nmsg->time_stamp = m->time_stamp;
+
+                nmsg->msg_ref    = m->msg_ref;  // <! reference moves to heap msg
+                m->msg_ref       = false;
+
+                MOUNT( t->msg_queue, nmsg );    // <! duplicate the msg from mailbox
+                t->is_busy |= TASK_MSG_PENDING;
+                memset( &(m->msg), 0x0, sizeof(struct msg_t) );
+            }else{
+                kernel_msg_ref_release( m );    // <! msg lost, hand buffer back to driver
+            }
+            kernel_mailbox_release( m );        // <! release box
+        }
+    }
+    if( g->in_use > 0 ){
+        g->unread_msg = true;               // <! claimed but not posted yet
+    }
+}
+
+/**
+ *  @brief drain all pools, start pool rotates every pass so no pool is always last
+ * 
+ *  @param [in]
+ *  @param [out]
+ *  @return 
+ **/
+void kernel_mailbox_drain(void){
+    for( int32_t i=0; i<KERNEL_MAILBOX_POOL_NUM; i++ ){
+        struct kernel_mailbox_pool_t *pool = &kernel_mailbox_pool[ (kernel_mailbox_drain_first + i) % KERNEL_MAILBOX_POOL_NUM ];
+        for( struct kernel_mailbox_group_t *g = pool->group_queue; g != NULL; g = g->next ){
+            if( g->unread_msg ){ kernel_mailbox_drain_group( g ); }     // <! only enter when group has unread mail
+        }
+    }
+    kernel_mailbox_drain_first = (kernel_mailbox_drain_first + 1) % KERNEL_MAILBOX_POOL_NUM;
+}
+
+/**
+ *  @brief check unread mail of all pools
+ * 
+ *  @param [in]
+ *  @param [out]
+ *  @return 
+ **/
+bool kernel_mailbox_unread(void){
+    for( int32_t i=0; i<KERNEL_MAILBOX_POOL_NUM; i++ ){
+        for( struct kernel_mailbox_group_t *g = kernel_mailbox_pool[i].group_queue; g != NULL; g = g->next ){
+            if( g->unread_msg ){ return true; }
+        }
+    }
+    return false;
+}
+
+/**
+ *  @brief elastic sizing of one group by watermarks, run in task context
+ * 
+ *  @param [in]
+ *  @param [out]
+ *  @return 
+ **/
+static void kernel_mailbox_group_maintain(struct kernel_mailbox_group_t *g, int32_t delta_ms){
+    int32_t in_use = g->in_use,  peak = (g->window_peak > in_use)?(g->window_peak):(in_use);
+    int32_t step   = (g->min_boxes > 1)?(g->min_boxes / 2):(1);
+
+    g->window_peak = in_use;                                    // <! open new window
+    if( peak > g->peak_in_use ){ g->peak_in_use = peak; }
+    if( peak >= g->num_of_boxes ){ g->full_ms += delta_ms; }
+
+    int32_t free_boxes = g->num_of_boxes - peak;
+    if( free_boxes * 100 < g->num_of_boxes * KERNEL_MAILBOX_LOW_WATERMARK ){
+        if( g->num_of_boxes < g->max_boxes ){                   // <! under low watermark, grow
+            int32_t n = kernel_mailbox_group_fill( g, MIN(step, g->max_boxes - g->num_of_boxes) );
+            if( n > 0 ){ g->grow_cnt++; }
+        }
+        g->idle_ms = 0;
+    }else if( free_boxes * 100 > g->num_of_boxes * KERNEL_MAILBOX_HIGH_WATERMARK ){
+        g->idle_ms += delta_ms;
+        if( (g->idle_ms >= KERNEL_MAILBOX_SHRINK_MS) && (g->num_of_boxes > g->min_boxes) ){
+            int32_t n = kernel_mailbox_group_park( g, MIN(step, g->num_of_boxes - g->min_boxes) );
+            if( n > 0 ){ g->shrink_cnt++; }
+            g->idle_ms = 0;                                     // <! shrink one step per idle period
+        }
+    }else{
+        g->idle_ms = 0;
+    }
+}
+
+/**
+ *  @brief grow / shrink groups and report exhaustion, run in scheduler after drain
+ * 
+ *  @param [in]
+ *  @param [out]
+ *  @return 
+ **/
+void kernel_mailbox_maintain(int32_t delta_ms){
+    for( int32_t i=0; i<KERNEL_MAILBOX_POOL_NUM; i++ ){
+        for( struct kernel_mailbox_group_t *g = kernel_mailbox_pool[i].group_queue; g != NULL; g = g->next ){
+            kernel_mailbox_group_maintain( g, delta_ms );
+        }
+    }
+
+    uint32_t drop = kernel_mailbox_drop;
+    if( drop != kernel_mailbox_drop_reported ){
+        WARNING( "No Mailbox, %u msg dropped from ISR", drop - kernel_mailbox_drop_reported );
+        kernel_mailbox_drop_reported = drop;
+    }
+}
+
 /**
  *  @brief show mailbox group and occupied mailbox info
  * 
@@ -102,18 +677,23 @@ bool create_mailbox( int32_t mailbox_size,
 void show_mailbox(void){
     LOG( "\r\nMailbox List\r\n" );
 
-    struct kernel_mailbox_group_t *g = kernel_mailbox_group_queue;
+    for( int32_t n=0; n<KERNEL_MAILBOX_POOL_NUM; n++ ){
+    struct kernel_mailbox_group_t *g = kernel_mailbox_pool[n].group_queue;
     while( g != NULL ){
-        LOG( "Mailbox[%d] x %d Bytes\r\n", g->num_of_boxes, g->box_size );
-        struct kernel_msg_t *p = g->mailbox_queue;  int cnt = 0;
-        while( p != NULL ){
-            if( p->mail.occupied ){
-                LOG( "\tbox[%d] : %s (%d)\r\n", cnt, p->msg.notification, p->msg.length );
+        LOG( "Pool[%d] Mailbox[%d] x %d Bytes (min %d, max %d)\r\n", n, g->num_of_boxes, g->box_size, g->min_boxes, g->max_boxes );
+        LOG( "\tpeak %d, claim fail %u, full %u ms, grow %u, shrink %u\r\n",
+             g->peak_in_use, g->claim_fail, g->full_ms, g->grow_cnt, g->shrink_cnt );
+        for( int32_t i=0; i<g->max_boxes; i++ ){
+            if( (g->boxes[i] != NULL) && g->boxes[i]->mail.occupied ){
+                struct kernel_msg_t *p = g->boxes[i];
+                LOG( "\tbox[%d] : %s (%d)\r\n", i, p->msg.notification, p->msg.length );
             }
-            cnt++;
-            p = p->next;
         }
         g = g->next;
     }
+    }
+    void show_spill(void);
+    show_spill();
+    LOG( "Dropped from ISR : %u\r\n", kernel_mailbox_drop );
 }
 
@@ -1,6 +1,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <stddef.h>
 
 struct kernel_msg_timer_t {
     int32_t reserved : 3;             // <! reserved for mailbox which declear below
@@ -21,10 +22,35 @@ struct kernel_msg_t {
         struct kernel_mailbox_t   mail;
     };
     int32_t time_stamp;
+    uint32_t                  call_id;        // <! correlation id of call, 0 means plain msg
+    bool                      call_reply;     // <! msg is the reply (or timeout) of call_id
+    bool                      msg_ref;        // <! data holds kernel_msg_ref_t, payload owned by driver
+    struct comm_tunnel_t      *rx_tunnel;     // <! msg received from tunnel, credit held until deleted
 
     struct msg_t              msg;
 };
 
+struct kernel_msg_ref_t {
+    void                      *buf;           // <! driver buffer, e.g. DMA rx buffer
+    int32_t                   length;
+    void                      (*release)(void *buf, void *arg);   // <! called once when msg is deleted
+    void                      *arg;
+};
+
+typedef void (*msg_release_callback)(void *buf, void *arg);
+
+/**
+ *  @brief get kernel msg which holds the msg delivered to task callback
+ * 
+ *  @param [in]
+ *  @param [out]
+ *  @return 
+ **/
+static struct kernel_msg_t * kernel_msg_of(const struct msg_t *msg){
+    if( msg == NULL ){ return NULL; }
+    return (struct kernel_msg_t *)( (char *)msg - offsetof(struct kernel_msg_t, msg) );
+}
+
 char * __strdup__(const char *src){
     if( src == NULL ){ return NULL; }
 
@@ -62,6 +88,45 @@ static struct kernel_msg_t * kernel_duplicate_msg(const struct kernel_msg_t *src
     return p;
 }
 
+/**
+ *  @brief hand driver buffer of reference msg back to driver
+ * 
+ *  @param [in]
+ *  @param [out]
+ *  @return 
+ **/
+static void kernel_msg_ref_release(struct kernel_msg_t *p){
+    if( ! p->msg_ref ){ return; }
+
+    struct kernel_msg_ref_t ref;
+    memcpy( &ref, p->msg.data, sizeof(ref) );           // <! data is not aligned
+    p->msg_ref = false;
+    if( ref.release != NULL ){
+        ref.release( ref.buf, ref.arg );
+    }
+}
+
+/**
+ *  @brief get payload of msg, driver buffer for reference msg
+ * 
+ *  @param [in]  msg    : msg delivered to task callback
+ *  @param [out] length : payload length
+ *  @return 
+ **/
+void * msg_payload(const struct msg_t *msg, int32_t *length){
+    struct kernel_msg_t *p = kernel_msg_of( msg );
+    if( p == NULL ){ return NULL; }
+
+    if( p->msg_ref ){
+        struct kernel_msg_ref_t ref;
+        memcpy( &ref, p->msg.data, sizeof(ref) );
+        if( length != NULL ){ *length = ref.length; }
+        return ref.buf;
+    }
+    if( length != NULL ){ *length = p->msg.length; }
+    return (void *)p->msg.data;
+}
+
 /**
  *  @brief delete msg : clear flag / release memory
  * 
@@ -69,10 +134,17 @@ static struct kernel_msg_t * kernel_duplicate_msg(const struct kernel_msg_t *src
  *  @param [out]
  *  @return 
  **/
+static void kernel_tx_rx_release(struct comm_tunnel_t *tunnel);
+
 static void __delete_msg(struct kernel_msg_t *p){
     ASSERT_NULL( p );
     if( p == NULL ){ return; }
 
+    kernel_msg_ref_release( p );                // <! task consumed payload of driver
+    if( p->rx_tunnel != NULL ){
+        kernel_tx_rx_release( p->rx_tunnel );   // <! credit of tunnel may be returned, see kernel_tx.c
+    }
+
     if( ! p->mail.mailbox_type ){
         // !>  malloc from new_msg
         if( p->msg.notification != NULL ){
@@ -83,9 +155,7 @@ static void __delete_msg(struct kernel_msg_t *p){
         }
         x_free( p );
     }else{
-        p->mail.task_handler = NULL;
-        p->mail.token = 0;
-        p->mail.occupied = 0;
+        kernel_mailbox_release( p );
     }
 }
 
@@ -150,48 +220,51 @@ xMsgHandler __new_msg_from_isr(const char *notification, char *data, int32_t len
     if( get_ipsr() == 0 ){  WARNING( "new_msg[%s] outside of Interrupt is not recommended", notification ); }
     #endif
 
-    #ifdef PTHREAD_H
-    pthread_mutex_lock( &isr_mutex );
-    #endif
-
-    struct kernel_mailbox_group_t *g = kernel_mailbox_group_queue;
-    while( g != NULL ){
-        if( g->box_size > length + 1 ){
-            struct kernel_msg_t *p = g->mailbox_queue;
-            while( p != NULL ){
-                if( ! p->mail.occupied ){
-                    if(  p->mail.token   ){ p = p->next; continue; }
-                    p->mail.token = 1;
-
-                    if( p->mail.occupied ){ p = p->next; continue; }
-                    p->mail.occupied    = 1;
-                    p->msg.src_task     = NULL;
-                    p->msg.notification = notification;
-                    p->msg.length       = length;
-                    memcpy( p->msg.data, data, length );
-                    p->msg.data[length] = 0;
-                    p->time_stamp       = tick_us();
-
-                    g->unread_msg       = true;
-                    
-                    #ifdef PTHREAD_H
-                    pthread_mutex_unlock( &isr_mutex );
-                    #endif
-
-                    return p;
-                }
-                p = p->next;
-            }
-        }
-        g = g->next;
+    struct kernel_msg_t *p = kernel_mailbox_alloc( length );     // <! atomic claim, no lock needed
+    if( p != NULL ){
+        p->msg.src_task     = NULL;
+        p->msg.notification = notification;
+        p->msg.length       = length;
+        p->msg_ref          = false;
+        memcpy( p->msg.data, data, length );
+        p->msg.data[length] = 0;
+        p->time_stamp       = tick_us();
+        return p;
     }
 
-    #ifdef PTHREAD_H
-    pthread_mutex_unlock( &isr_mutex );
-    #endif
+    return NULL;                                // <! counted by mailbox, reported in task context
+}
+
+/**
+ *  @brief new reference msg when in interrupt, only a descriptor is put in mailbox
+ *         release( buf, arg ) is called when msg is deleted, after task consumed it
+ *         Note: buffer stays owned by driver if NULL is returned
+ * 
+ *  @param [in]
+ *  @param [out]
+ *  @return 
+ **/
+xMsgHandler __new_msg_ref_from_isr( const char *notification, 
+                                    void *buf, 
+                                    int32_t length, 
+                                    msg_release_callback release, 
+                                    void *arg
+                                  ){
+    ASSERT_NULL( notification );
+    ASSERT_TRUE( length >= 0 );
 
-    WARNING( "No Mailbox for msg[%s]\r\n", notification );
-    show_mailbox();
+    struct kernel_msg_ref_t ref = { buf, length, release, arg };
+
+    struct kernel_msg_t *p = kernel_mailbox_alloc( sizeof(ref) );
+    if( p != NULL ){
+        p->msg.src_task     = NULL;
+        p->msg.notification = notification;
+        p->msg.length       = sizeof(ref);
+        memcpy( p->msg.data, &ref, sizeof(ref) );
+        p->time_stamp       = tick_us();
+        p->msg_ref          = true;
+        return p;
+    }
     return NULL;
 }
 
@@ -245,6 +318,8 @@ xMsgHandler msg_set_delay_timer(xMsgHandler msg, int32_t delay){
   **********************************************************************/
 
 static bool try_post_msg_outside(const char *target_task, struct kernel_msg_t *msg, const char *src_task);
+static struct kernel_task_t * get_task_handler(const char *task_name, struct kernel_task_t *task_queue);
+static bool kernel_call_complete(uint32_t call_id, const char *caller_task);
 
 /**
  *  @brief post msg from source task to target task
@@ -277,18 +352,20 @@ bool __post_msg_from(const char *target_task, xMsgHandler msg, const char *src_t
     if( t->task_paused ){ goto ERR; }           // <! task has been paused.
 
     if( p->mail.mailbox_type ){                 // <! msg from mailbox
-        #ifdef PTHREAD_H
-        pthread_mutex_lock( &isr_mutex );
-        #endif
         p->mail.task_handler = t;
         if( src_task != NULL ){
             ERROR( "Msg[%s] From ISR Should not have src_task[%s]", p->msg.notification, src_task );
         }
-        t->is_busy |= TASK_MSG_PENDING; //t->is_busy = TASK_BUSY;
-        #ifdef PTHREAD_H
-        pthread_mutex_unlock( &isr_mutex );
-        #endif
+        kernel_mailbox_ready( p );              // <! visible to scheduler after handler is set, task state is set at drain
     }else{
+        if( p->call_reply ){                      // <! reply of call, only deliver when call is outstanding
+            if( ! kernel_call_complete(p->call_id, t->task_name) ){
+                LOG( "Late reply[%s] of call[%u] to [%s], msg Drop!\r\n", p->msg.notification, p->call_id, target_task );
+                __delete_msg( msg );
+                return false;
+            }
+        }
+
         p->msg.src_task = __strdup__( src_task );
 
         if( p->timer.enable ){                    // <! timer enable
@@ -0,0 +1,150 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/*************************************************************************
+
+           -------------------------------------------------
+          |                                                 |
+          |       Per-Pass Arena of Kernel Task Scheduler   | 
+          |                                                 |
+           -------------------------------------------------
+
+ Note:
+ 1.arena is reset at the end of each kernel_task_sheduler pass
+ 2.only kernel JSON packing/parsing inside the pass use arena
+   (kernel_pass_json_enter/leave), task callbacks still use heap
+ 3.buffer that escapes the pass must be promoted by kernel_pass_promote
+ 4.arena full or other thread: fallback to heap
+
+*************************************************************************/
+
+#ifndef KERNEL_PASS_ARENA_SIZE
+#define KERNEL_PASS_ARENA_SIZE          (4 * 1024)
+#endif
+
+static uint64_t kernel_pass_arena[ (KERNEL_PASS_ARENA_SIZE + 7) / 8 ];   // <! 8 bytes aligned
+static int32_t  kernel_pass_arena_used   = 0;
+static int32_t  kernel_pass_arena_last   = -1;          // <! offset of last allocation, LIFO free
+static int32_t  kernel_pass_arena_peak   = 0;
+static int32_t  kernel_pass_arena_spill  = 0;           // <! allocations fallback to heap
+static int32_t  kernel_pass_json_depth   = 0;
+static bool     kernel_pass_arena_active = false;
+#ifdef PTHREAD_H
+static pthread_t kernel_pass_arena_owner;
+#endif
+
+static bool kernel_pass_arena_owns(const void *p){
+    return ( (const uint8_t *)p >= (const uint8_t *)&kernel_pass_arena[0] ) &&
+           ( (const uint8_t *)p <  (const uint8_t *)&kernel_pass_arena[sizeof(kernel_pass_arena) / 8] );
+}
+
+static bool kernel_pass_arena_in_pass(void){
+    if( ! kernel_pass_arena_active ){ return false; }
+    #ifdef PTHREAD_H
+    if( ! pthread_equal(pthread_self(), kernel_pass_arena_owner) ){ return false; }
+    #endif
+    return true;
+}
+
+/**
+ *  @brief alloc transient memory, freed all together at the end of pass
+ * 
+ *  @param [in]
+ *  @param [out]
+ *  @return 
+ **/
+void * kernel_pass_malloc(size_t size){
+    if( kernel_pass_arena_in_pass() ){
+        int32_t aligned = (int32_t)((size + 7) & ~(size_t)7);
+        if( kernel_pass_arena_used + aligned <= (int32_t)sizeof(kernel_pass_arena) ){
+            void *p = (uint8_t *)kernel_pass_arena + kernel_pass_arena_used;
+            kernel_pass_arena_last  = kernel_pass_arena_used;
+            kernel_pass_arena_used += aligned;
+            kernel_pass_arena_peak  = MAX( kernel_pass_arena_peak, kernel_pass_arena_used );
+            return p;
+        }
+        kernel_pass_arena_spill++;
+    }
+    return x_malloc( size );
+}
+
+void kernel_pass_free(void *p){
+    if( p == NULL ){ return; }
+    if( kernel_pass_arena_owns(p) ){
+        if( (uint8_t *)p == (uint8_t *)kernel_pass_arena + kernel_pass_arena_last ){
+            kernel_pass_arena_used = kernel_pass_arena_last;   // <! give back the last allocation
+            kernel_pass_arena_last = -1;
+        }
+        return;                                               // <! others released when pass end
+    }
+    x_free( p );
+}
+
+/**
+ *  @brief move buffer out of arena when it escapes the pass
+ * 
+ *  @param [in]
+ *  @param [out]
+ *  @return heap buffer, NULL when no memory
+ **/
+void * kernel_pass_promote(void *p, size_t size){
+    if( (p == NULL) || (! kernel_pass_arena_owns(p)) ){ return p; }
+
+    void *h = x_malloc( size );
+    if( h != NULL ){
+        memcpy( h, p, size );
+    }else{ WARNING( "No Memory for promote %d Bytes", (int)size ); }
+    kernel_pass_free( p );
+    return h;
+}
+
+static void * kernel_heap_malloc(size_t size){ return x_malloc( size ); }
+static void   kernel_heap_free(void *p)       { x_free( p ); }
+
+/**
+ *  @brief route cJSON allocation to arena while kernel packing/parsing JSON in pass
+ * 
+ *  @param [in]
+ *  @param [out]
+ *  @return true: arena entered, pass it to kernel_pass_json_leave
+ **/
+bool kernel_pass_json_enter(void){
+    if( ! kernel_pass_arena_in_pass() ){ return false; }
+
+    if( kernel_pass_json_depth++ == 0 ){
+        cJSON_Hooks hooks = { kernel_pass_malloc, kernel_pass_free };
+        cJSON_InitHooks( &hooks );
+    }
+    return true;
+}
+
+void kernel_pass_json_leave(bool entered){
+    if( ! entered ){ return; }
+
+    if( --kernel_pass_json_depth == 0 ){
+        cJSON_Hooks hooks = { kernel_heap_malloc, kernel_heap_free };
+        cJSON_InitHooks( &hooks );
+    }
+}
+
+void kernel_pass_arena_begin(void){
+    #ifdef PTHREAD_H
+    kernel_pass_arena_owner = pthread_self();
+    #endif
+    kernel_pass_arena_used   = 0;
+    kernel_pass_arena_last   = -1;
+    kernel_pass_json_depth   = 0;
+    kernel_pass_arena_active = true;
+}
+
+void kernel_pass_arena_end(void){
+    kernel_pass_arena_active = false;
+    kernel_pass_arena_used   = 0;                       // <! release everything of this pass
+    kernel_pass_arena_last   = -1;
+}
+
+void show_pass_arena(void){
+    LOG( "\r\nPass Arena : %d Bytes, peak %d, fallback to heap %d\r\n",
+         (int)sizeof(kernel_pass_arena), kernel_pass_arena_peak, kernel_pass_arena_spill );
+}
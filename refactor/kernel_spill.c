@@ -0,0 +1,246 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/*************************************************************************
+
+           -------------------------------------------------
+          |                                                 |
+          |      Overflow Spill Ring of ISR Messages        |
+          |                                                 |
+           -------------------------------------------------
+
+ Note:
+ 1.used by __new_msg_from_isr only when no mailbox is free
+ 2.bounded lock-free ring, slot sequence tells producers which lap the
+   slot belongs to, producers reserve slots by CAS on tail
+ 3.record looks like a mailbox msg (mail.group == NULL), so post /
+   delete path is the same as mailbox
+ 4.scheduler drains ring after mailbox groups, in ring order, stops at
+   record which is claimed but not posted yet
+ 5.KERNEL_SPILL_KEEP_LATEST: among drained records only the latest of
+   same task and notification is delivered, the others are coalesced
+
+*************************************************************************/
+
+#define KERNEL_SPILL_FIFO               0
+#define KERNEL_SPILL_KEEP_LATEST        1
+
+#ifndef KERNEL_SPILL_NUM
+#define KERNEL_SPILL_NUM                16              // <! must be power of 2, 0 to disable
+#endif
+
+#ifndef KERNEL_SPILL_DATA_SIZE
+#define KERNEL_SPILL_DATA_SIZE          32              // <! compact record, larger payload is dropped
+#endif
+
+#ifndef KERNEL_SPILL_POLICY
+#define KERNEL_SPILL_POLICY             KERNEL_SPILL_FIFO
+#endif
+
+enum {
+    SPILL_FREE = 0,
+    SPILL_CLAIMED,                                      // <! producer filling / not posted yet
+    SPILL_READY,                                        // <! posted, wait for drain
+    SPILL_DEAD,                                         // <! deleted before drain, skip it
+};
+
+struct kernel_spill_t {
+    uint32_t                      head;                 // <! scheduler only
+    uint32_t                      tail;                 // <! producers, CAS
+    uint32_t                      *seq;                 // <! seq == pos: free for pos, seq == pos + 1: taken at pos
+    uint32_t                      *state;
+    struct kernel_msg_t           **slot;
+
+    uint32_t                      spilled;              // <! records taken from ring
+    uint32_t                      too_large;            // <! payload larger than KERNEL_SPILL_DATA_SIZE
+    uint32_t                      full;                 // <! ring full
+    uint32_t                      coalesced;            // <! dropped by KERNEL_SPILL_KEEP_LATEST
+};
+
+static struct kernel_spill_t kernel_spill = { 0 };
+
+/**
+ *  @brief malloc ring, called with the first create_mailbox
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+static bool kernel_spill_create(void){
+    #if ( KERNEL_SPILL_NUM > 0 )
+    if( kernel_spill.slot != NULL ){ return true; }
+    ASSERT_TRUE( (KERNEL_SPILL_NUM & (KERNEL_SPILL_NUM - 1)) == 0 );
+
+    struct kernel_msg_t **slot = (struct kernel_msg_t **)x_malloc( KERNEL_SPILL_NUM * sizeof(struct kernel_msg_t *) );
+    uint32_t *words = (uint32_t *)x_malloc( KERNEL_SPILL_NUM * 2 * sizeof(uint32_t) );
+    if( (slot == NULL) || (words == NULL) ){ goto ERR; }
+    memset( slot, 0x0, KERNEL_SPILL_NUM * sizeof(struct kernel_msg_t *) );
+
+    for( int32_t i=0; i<KERNEL_SPILL_NUM; i++ ){
+        slot[i] = (struct kernel_msg_t *)x_malloc( sizeof(struct kernel_msg_t) + KERNEL_SPILL_DATA_SIZE );
+        if( slot[i] == NULL ){ goto ERR; }
+        memset( slot[i], 0x0, sizeof(struct kernel_msg_t) + KERNEL_SPILL_DATA_SIZE );
+        slot[i]->mail.mailbox_type = 1;
+        slot[i]->mail.group        = NULL;              // <! spill record
+        slot[i]->mail.index        = i;
+        words[i]                   = i;                 // <! seq: free for lap 0
+        words[KERNEL_SPILL_NUM + i] = SPILL_FREE;
+    }
+
+    kernel_spill.seq   = &words[0];
+    kernel_spill.state = &words[KERNEL_SPILL_NUM];
+    kernel_spill.slot  = slot;
+    return true;
+
+    ERR:
+    if( slot != NULL ){
+        for( int32_t i=0; i<KERNEL_SPILL_NUM; i++ ){ if( slot[i] != NULL ){ x_free( slot[i] ); } }
+        x_free( slot );
+    }
+    if( words != NULL ){ x_free( words ); }
+    WARNING( "No memory for spill ring" );
+    return false;
+    #else
+    return true;
+    #endif
+}
+
+/**
+ *  @brief take a record at tail of ring, called in ISR when mailbox is exhausted
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return NULL: ring full or payload too large
+ **/
+static struct kernel_msg_t * kernel_spill_alloc(int32_t length){
+    if( kernel_spill.slot == NULL ){ return NULL; }
+    if( length + 1 > KERNEL_SPILL_DATA_SIZE ){
+        kernel_atomic_add32( (int32_t *)&kernel_spill.too_large, 1 );
+        return NULL;
+    }
+
+    uint32_t pos = kernel_atomic_load32( &kernel_spill.tail ), i = 0;
+    for( ;; ){
+        i = pos & (KERNEL_SPILL_NUM - 1);
+        int32_t dif = (int32_t)( kernel_atomic_load32(&kernel_spill.seq[i]) - pos );
+        if( dif == 0 ){
+            if( kernel_atomic_cas32(&kernel_spill.tail, &pos, pos + 1) ){ break; }   // <! pos reloaded when failed
+        }else if( dif < 0 ){
+            kernel_atomic_add32( (int32_t *)&kernel_spill.full, 1 );               // <! slot of last lap not drained
+            return NULL;
+        }else{
+            pos = kernel_atomic_load32( &kernel_spill.tail );                      // <! other producer took it
+        }
+    }
+
+    struct kernel_msg_t *p = kernel_spill.slot[i];
+    p->mail.occupied     = 1;
+    p->mail.task_handler = NULL;
+    p->msg_ref           = false;
+    kernel_spill.state[i] = SPILL_CLAIMED;
+    kernel_atomic_xchg32( &kernel_spill.seq[i], pos + 1 );                          // <! taken at pos
+    kernel_atomic_add32( (int32_t *)&kernel_spill.spilled, 1 );
+    return p;
+}
+
+static void kernel_spill_ready(struct kernel_msg_t *p){
+    kernel_atomic_xchg32( &kernel_spill.state[p->mail.index], SPILL_READY );
+}
+
+static void kernel_spill_release(struct kernel_msg_t *p){   // <! deleted before drain
+    p->mail.task_handler = NULL;
+    p->mail.occupied     = 0;
+    kernel_atomic_xchg32( &kernel_spill.state[p->mail.index], SPILL_DEAD );
+}
+
+/**
+ *  @brief record at pos is posted (or dead) and can be drained
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+static bool kernel_spill_drainable(uint32_t pos){
+    uint32_t i = pos & (KERNEL_SPILL_NUM - 1);
+    if( kernel_atomic_load32(&kernel_spill.seq[i]) != pos + 1 ){ return false; }
+    return kernel_atomic_load32( &kernel_spill.state[i] ) != SPILL_CLAIMED;
+}
+
+#if ( KERNEL_SPILL_POLICY == KERNEL_SPILL_KEEP_LATEST )
+static bool kernel_spill_superseded(uint32_t pos, uint32_t end){
+    struct kernel_msg_t *p = kernel_spill.slot[ pos & (KERNEL_SPILL_NUM - 1) ];
+    for( uint32_t n = pos + 1; n != end; n++ ){
+        struct kernel_msg_t *q = kernel_spill.slot[ n & (KERNEL_SPILL_NUM - 1) ];
+        if( (kernel_spill.state[ n & (KERNEL_SPILL_NUM - 1) ] == SPILL_READY) &&
+            (q->mail.task_handler == p->mail.task_handler) &&
+            ( (q->msg.notification == p->msg.notification) || (strcmp(q->msg.notification, p->msg.notification) == 0) ) ){
+            return true;
+        }
+    }
+    return false;
+}
+#endif
+
+/**
+ *  @brief copy posted records to msg_queue of aimed task, run in scheduler after mailbox drain
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+void kernel_spill_drain(void){
+    if( kernel_spill.slot == NULL ){ return; }
+
+    uint32_t end = kernel_spill.head;
+    while( kernel_spill_drainable(end) ){ end++; }      // <! stop at record not posted yet
+
+    for( uint32_t pos = kernel_spill.head; pos != end; pos++ ){
+        uint32_t i = pos & (KERNEL_SPILL_NUM - 1);
+        struct kernel_msg_t *m = kernel_spill.slot[i];
+
+        if( kernel_spill.state[i] == SPILL_READY ){
+            #if ( KERNEL_SPILL_POLICY == KERNEL_SPILL_KEEP_LATEST )
+            if( kernel_spill_superseded(pos, end) ){
+                kernel_msg_ref_release( m );
+                kernel_spill.coalesced++;
+                goto NEXT;
+            }
+            #endif
+
+            struct kernel_msg_t *nmsg = new_msg( m->msg.notification, m->msg.data, m->msg.length );
+            if( nmsg != NULL ){
+                struct kernel_task_t *t = m->mail.task_handler;
+                nmsg->time_stamp = m->time_stamp;
+                nmsg->msg_ref    = m->msg_ref;      // <! reference moves to heap msg
+                m->msg_ref       = false;
+
+                MOUNT( t->msg_queue, nmsg );
+                t->is_busy |= TASK_MSG_PENDING;
+            }else{
+                kernel_msg_ref_release( m );
+            }
+        }
+
+        #if ( KERNEL_SPILL_POLICY == KERNEL_SPILL_KEEP_LATEST )
+        NEXT:
+        #endif
+        m->mail.task_handler = NULL;
+        m->mail.occupied     = 0;
+        kernel_spill.state[i] = SPILL_FREE;
+        kernel_atomic_xchg32( &kernel_spill.seq[i], pos + KERNEL_SPILL_NUM );     // <! free for next lap
+    }
+    kernel_spill.head = end;
+}
+
+bool kernel_spill_unread(void){
+    if( kernel_spill.slot == NULL ){ return false; }
+    return kernel_spill_drainable( kernel_spill.head );
+}
+
+void show_spill(void){
+    LOG( "Spill ring[%d] x %d Bytes, policy %s\r\n", KERNEL_SPILL_NUM, KERNEL_SPILL_DATA_SIZE,
+         (KERNEL_SPILL_POLICY == KERNEL_SPILL_KEEP_LATEST)?("keep latest"):("fifo") );
+    LOG( "\tspilled %u, coalesced %u, lost: full %u, too large %u\r\n",
+         kernel_spill.spilled, kernel_spill.coalesced, kernel_spill.full, kernel_spill.too_large );
+}
@@ -16,13 +16,22 @@ struct kernel_task_t {
     int32_t                 busy_timeout;
     struct kernel_msg_t     *msg_queue;
     struct kernel_msg_t     *timer_msg_queue;      // !> don't allow more than one msg in queue
+    uint32_t                event_flags;          // !> bits OR'ed by ISR, delivered as one msg per pass
 
-    task_freeze_event_callbac  freezer_callback
+    task_freeze_event_callback freezer_callback;
     bool                    task_suspended;
     bool                    task_paused;
     bool                    task_deleted;
 };
 
+typedef struct kernel_task_t * xTaskHandler;
+
+#ifndef KERNEL_TASK_EVENT_NOTIFY
+#define KERNEL_TASK_EVENT_NOTIFY        "event_flags"
+#endif
+
+static uint32_t kernel_task_event_pending = 0;      // <! any task has event_flags set
+
 bool create_task( const char *task_name,
                   task_state (*task_callback)(const char *this_task, struct msg_t *msg, void *arg),
                   void *arg,
@@ -182,6 +191,90 @@ bool task_disable_timer(const char *task_name){ // <! drop timer msg and disable
     } return false;
 }
 
+/**
+ *  @brief handle of task for task_notify_from_isr, resolve it once in task context
+ *         Note: handle is freed by scheduler after delete_task, stop notifying before
+ * 
+ *  @param [in]
+ *  @param [out]
+ *  @return NULL if task not found
+ **/
+xTaskHandler task_handle(const char *task_name){
+    struct kernel_task_t *t = get_task_handler( task_name, kernel_task_queue );
+    if( (t == NULL) || t->task_deleted ){ return NULL; }
+    return t;
+}
+
+/**
+ *  @brief set event flags of task from interrupt, no mailbox is claimed and no task list walked
+ *         flags set before the task runs are coalesced into one msg
+ * 
+ *  @param [in] task : from task_handle
+ *  @param [out]
+ *  @return 
+ **/
+bool task_notify_from_isr(xTaskHandler task, uint32_t flags){
+    if( (task == NULL) || task->task_deleted || task->task_paused ){ return false; }
+    if( flags == 0 ){ return true; }
+
+    kernel_atomic_or32( &task->event_flags, flags );
+    kernel_atomic_or32( &kernel_task_event_pending, 1 );
+    return true;
+}
+
+/**
+ *  @brief task_notify_from_isr by task name, task context only
+ * 
+ *  @param [in]
+ *  @param [out]
+ *  @return 
+ **/
+bool task_notify(const char *task_name, uint32_t flags){
+    return task_notify_from_isr( task_handle(task_name), flags );
+}
 
+/**
+ *  @brief get accumulated event flags from msg delivered to task callback
+ * 
+ *  @param [in]
+ *  @param [out]
+ *  @return 0 if msg is not event msg
+ **/
+uint32_t msg_event_flags(const struct msg_t *msg){
+    uint32_t flags = 0;
+    if( (msg != NULL) && (msg->length == sizeof(flags)) && (strcmp(msg->notification, KERNEL_TASK_EVENT_NOTIFY) == 0) ){
+        memcpy( &flags, msg->data, sizeof(flags) );
+    }
+    return flags;
+}
 
+/**
+ *  @brief take event flags of all tasks, mount 1 msg for each task with flags, run in scheduler
+ * 
+ *  @param [in]
+ *  @param [out]
+ *  @return 
+ **/
+void kernel_task_deliver_events(void){
+    if( kernel_atomic_xchg32(&kernel_task_event_pending, 0) == 0 ){ return; }
 
+    struct kernel_task_t *t = kernel_task_queue;
+    while( t != NULL ){
+        uint32_t flags = kernel_atomic_xchg32( &t->event_flags, 0 );
+        if( flags != 0 ){
+            struct kernel_msg_t *m = new_msg( KERNEL_TASK_EVENT_NOTIFY, (char *)&flags, sizeof(flags) );
+            if( m != NULL ){
+                MOUNT( t->msg_queue, m );
+                t->is_busy |= TASK_MSG_PENDING;
+            }else{
+                kernel_atomic_or32( &t->event_flags, flags );           // <! keep flags, try next pass
+                kernel_atomic_or32( &kernel_task_event_pending, 1 );
+            }
+        }
+        t = t->next;
+    }
+}
+
+bool kernel_task_event_unread(void){
+    return kernel_atomic_load32( &kernel_task_event_pending ) != 0;
+}
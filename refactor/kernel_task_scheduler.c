@@ -43,11 +43,12 @@ uint32_t kernel_idle_time(void){
     struct kernel_task_t *t = kernel_task_queue;
     uint32_t min = 0xFFFFFFFF;
 
-    struct kernel_mailbox_group_t *g = kernel_mailbox_group_queue;
-    while( g != NULL ){
-        if( g->unread_msg ){ return 0; }              // <! Mailbox has unread msg
-        g = g->next;
-    }
+    bool kernel_mailbox_unread(void);
+    if( kernel_mailbox_unread() ){ return 0; }        // <! Mailbox has unread msg
+    bool kernel_spill_unread(void);
+    if( kernel_spill_unread() ){ return 0; }          // <! Spill ring has unread msg
+    bool kernel_task_event_unread(void);
+    if( kernel_task_event_unread() ){ return 0; }     // <! Event flags set by ISR
 
     // !> calculate the minimal delay time of local task 
     while( t != NULL ){
@@ -69,6 +70,28 @@ uint32_t kernel_idle_time(void){
         min = MIN( (uint32_t)pending_time, min );
     }
 
+    // !> calculate the minimal time before flushing batch / sending queued frame
+    int32_t kernel_batch_next_time(void);
+    int32_t batch_time = kernel_batch_next_time();
+    if( batch_time >= 0 ){
+        min = MIN( (uint32_t)batch_time, min );
+    }
+    int32_t kernel_tx_next_time(void);
+    int32_t tx_time = kernel_tx_next_time();
+    if( tx_time >= 0 ){
+        min = MIN( (uint32_t)tx_time, min );
+    }
+    int32_t kernel_link_next_time(void);
+    int32_t link_time = kernel_link_next_time();
+    if( link_time >= 0 ){
+        min = MIN( (uint32_t)link_time, min );
+    }
+    int32_t kernel_delta_next_time(void);
+    int32_t delta_time = kernel_delta_next_time();
+    if( delta_time >= 0 ){
+        min = MIN( (uint32_t)delta_time, min );
+    }
+
     // !> calculate the minimal time interval before next Synchronizing core 
     // !> Synchronize core: triggered when local task has changed 
     int32_t mmap_retry_time = get_kernel_mmap_unsync_timeout();
@@ -76,6 +99,13 @@ uint32_t kernel_idle_time(void){
         min = MIN( (uint32_t)mmap_retry_time, min );
     }
 
+    // !> calculate the minimal time before next call timeout
+    int32_t kernel_call_min_timeout(void);
+    int32_t call_timeout = kernel_call_min_timeout();
+    if( call_timeout >= 0 ){
+        min = MIN( (uint32_t)call_timeout, min );
+    }
+
     return min;
 }
 
@@ -90,51 +120,29 @@ void kernel_task_sheduler(void){
     extern void pwr_mgr_timer_update(int32_t delta_ms);
     pwr_mgr_timer_update( delta_ms );
 
+    void kernel_pass_arena_begin(void);
+    kernel_pass_arena_begin();                      // <! transient allocations of this pass
+
     /**********************************************************************
      |                                                                     |
     |                  Convert Mailbox to Kernel Message                  |
     |                                                                     |
     **********************************************************************/
 
-    #ifdef PTHREAD_H
-    pthread_mutex_lock( &isr_mutex );
-    #endif
-    {
-    // !> copy all of the mailbox messages to msg_queue of aimed task 
-    struct kernel_mailbox_group_t *g = kernel_mailbox_group_queue;
-    while( g != NULL ){
-        if( g->unread_msg ){                    // <! only enter when mailbox has unread mail
-            g->unread_msg = false;                // <! we are going to read all the boxes
-                                                // <! in case new message arrived while fetch mail, we clear here
-                                                // <! so the unread flag won't be accidentally clear in the process
-            m = g->mailbox_queue;
-            while( m != NULL ){
-                if( m->mail.occupied ){             // <! get the occupied mailbox
-                    if( m->mail.task_handler != NULL ){
-                        struct kernel_msg_t *nmsg = new_msg( m->msg.notification, m->msg.data, m->msg.length );
-                        if( nmsg != NULL ){
-                            t = m->mail.task_handler;
-                            nmsg->time_stamp  = m->time_stamp;
-                
-                            MOUNT( t->msg_queue, nmsg );    // <! duplicate the msg from mailbox
-                            memset( &(m->msg), 0x0, sizeof(struct msg_t) );
-                            m->mail.task_handler = NULL;
-                        }
-                        m->mail.token     = 0;          // <! release token
-                        m->mail.occupied  = 0;
-                    }else{
-                        g->unread_msg = true;           // <! Message is unread
-                    }
-                }
-                m = m->next;
-            }
-        }
-        g = g->next;
-    }
-    }
-    #ifdef PTHREAD_H
-    pthread_mutex_unlock( &isr_mutex );
-    #endif
+    // !> copy all of the mailbox messages to msg_queue of aimed task, pools in round-robin order
+    void kernel_mailbox_drain(void);
+    kernel_mailbox_drain();
+    void kernel_spill_drain(void);
+    kernel_spill_drain();                           // <! overflow of mailbox, after groups
+
+    void kernel_mailbox_maintain(int32_t delta_ms);
+    kernel_mailbox_maintain( delta_ms );          // <! grow / shrink mailbox groups by watermarks
+    void kernel_co_maintain(void);
+    kernel_co_maintain();                         // <! report msg dropped by coroutine tasks last pass
+
+    // !> coalesced event flags from ISR, 1 msg per task
+    void kernel_task_deliver_events(void);
+    kernel_task_deliver_events();
 
     /**********************************************************************
      |                                                                     |
@@ -171,6 +179,9 @@ void kernel_task_sheduler(void){
             }
             t = t->next;
         }
+
+        void kernel_call_check_timeout(int32_t delta_ms);
+        kernel_call_check_timeout( delta_ms );                          // <! report timeout of outstanding calls
     }
 
     t = kernel_task_queue;
@@ -335,6 +346,8 @@ void kernel_task_sheduler(void){
                     __delete_msg( m );
                 }
                 }
+                void kernel_co_task_release(struct kernel_task_t *t);
+                kernel_co_task_release( t );                           // <! free coroutine frame
                 x_free( t );                                           // <! free resource
                 t = next;
                 continue;
@@ -345,11 +358,26 @@ void kernel_task_sheduler(void){
         t = t->next;
     }
 
+    void kernel_link_pass_end(int32_t delta_ms);
+    kernel_link_pass_end( delta_ms );               // <! probe links, fail over stalled ones
+    void kernel_delta_pass_end(int32_t delta_ms);
+    kernel_delta_pass_end( delta_ms );              // <! digest of task list versions
+    void kernel_route_pass_end(void);
+    kernel_route_pass_end();                        // <! publish route snapshot, free retired one
+
+    void kernel_batch_pass_end(int32_t delta_ms);
+    kernel_batch_pass_end( delta_ms );              // <! flush outbound batch frames
+    void kernel_tx_pass_end(int32_t delta_ms);
+    kernel_tx_pass_end( delta_ms );                 // <! return credit, drain send queues of tunnels
+
     int32_t try_send_tunnel_pending_packet(void);
     try_send_tunnel_pending_packet();
 
     kernel_mmap_update_to( NULL, true );
     kernel_mmap_check_unsync_core( 0 );
+
+    void kernel_pass_arena_end(void);
+    kernel_pass_arena_end();                        // <! release all transient allocations
 }
 
 
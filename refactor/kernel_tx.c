@@ -0,0 +1,360 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/*************************************************************************
+
+           -------------------------------------------------
+          |                                                 |
+          |     Asynchronous Send Queue and Flow Control    |
+          |                                                 |
+           -------------------------------------------------
+
+ Note:
+ 1.frames are not sent in caller context any more, kernel_tx_push puts
+   frame in bounded queue of its tunnel, KERNEL_TX_BURST frames of each
+   tunnel are sent at the end of scheduler pass, a full queue only drops
+   frames of its own tunnel
+ 2.two lanes per tunnel, control lane (task list sync, credit) is always
+   sent first and never waits for credit, data lane is bounded by credit
+ 3.credit: when every core announced "SupportCredit", sender may have
+   KERNEL_TX_CREDITS frames in flight per tunnel, receiver returns credit
+   of consumed frames by KERNEL_WIRE_CREDIT frame at the end of pass, and
+   holds them back while msg received from that tunnel is still queued in
+   local tasks (kernel_tx_rx_hold / kernel_tx_rx_release)
+ 4.credit lost on link is restored after KERNEL_TX_CREDIT_TIMEOUT_MS
+ 5.data lane full: new frame is dropped, control lane full: the oldest
+   frame is dropped (newer task list supersedes it)
+
+*************************************************************************/
+
+#ifndef KERNEL_TX_QUEUE_NUM
+#define KERNEL_TX_QUEUE_NUM             16              // <! frames per lane
+#endif
+
+#ifndef KERNEL_TX_BURST
+#define KERNEL_TX_BURST                 8               // <! frames per tunnel per scheduler pass
+#endif
+
+#ifndef KERNEL_TX_CREDITS
+#define KERNEL_TX_CREDITS               8               // <! frames in flight before peer returns credit
+#endif
+
+#ifndef KERNEL_TX_CREDIT_TIMEOUT_MS
+#define KERNEL_TX_CREDIT_TIMEOUT_MS     1000
+#endif
+
+#define KERNEL_TX_CREDIT_RETURN         ((KERNEL_TX_CREDITS + 1) / 2)     // <! consumed frames to return at once
+
+enum {
+    KERNEL_TX_CONTROL = 0,
+    KERNEL_TX_DATA,
+    KERNEL_TX_LANES,
+};
+
+struct kernel_tx_lane_t {
+    uint8_t                       *frame[ KERNEL_TX_QUEUE_NUM ];
+    int32_t                       length[ KERNEL_TX_QUEUE_NUM ];
+    int32_t                       head;
+    int32_t                       count;
+    uint32_t                      dropped;
+};
+
+struct kernel_tx_t {
+    struct kernel_tx_t            *next;
+    struct comm_tunnel_t          *tunnel;
+    struct kernel_tx_lane_t       lane[ KERNEL_TX_LANES ];
+
+    int32_t                       credits;              // <! data frames allowed to send
+    int32_t                       credit_wait_ms;       // <! time blocked without credit
+    int32_t                       consumed;             // <! frames received, credit not returned yet
+    int32_t                       rx_queued;            // <! msg received from tunnel, not consumed by local task
+
+    uint32_t                      sent;
+    #ifdef PTHREAD_H
+    pthread_mutex_t               mutex;
+    #endif
+};
+
+static struct kernel_tx_t *kernel_tx_queue = NULL;
+
+#ifdef PTHREAD_H
+static pthread_mutex_t kernel_tx_list_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define KERNEL_TX_LOCK(m)               pthread_mutex_lock( m )
+#define KERNEL_TX_UNLOCK(m)             pthread_mutex_unlock( m )
+#else
+#define KERNEL_TX_LOCK(m)
+#define KERNEL_TX_UNLOCK(m)
+#endif
+
+static struct kernel_tx_t * kernel_tx_of(struct comm_tunnel_t *tunnel, bool create){
+    KERNEL_TX_LOCK( &kernel_tx_list_mutex );
+    struct kernel_tx_t *tx = kernel_tx_queue;
+    while( tx != NULL ){
+        if( tx->tunnel == tunnel ){ break; }
+        tx = tx->next;
+    }
+
+    if( (tx == NULL) && create ){
+        if( NULL != (tx = (struct kernel_tx_t *)x_malloc( sizeof(struct kernel_tx_t) )) ){
+            memset( tx, 0x0, sizeof(struct kernel_tx_t) );
+            tx->tunnel  = tunnel;
+            tx->credits = KERNEL_TX_CREDITS;
+            #ifdef PTHREAD_H
+            pthread_mutex_init( &tx->mutex, NULL );
+            #endif
+            MOUNT( kernel_tx_queue, tx );
+        }
+    }
+    KERNEL_TX_UNLOCK( &kernel_tx_list_mutex );
+    return tx;
+}
+
+static bool kernel_tx_is_credit(const uint8_t *frame, int32_t length){    // <! credit frame is not counted by peer
+    return (length >= 2) && (frame[0] == KERNEL_WIRE_MAGIC) && (frame[1] == KERNEL_WIRE_CREDIT);
+}
+
+static void kernel_link_sent(struct comm_tunnel_t *tunnel, int32_t length, int32_t ms);
+
+static void kernel_tx_tunnel_send(struct comm_tunnel_t *tunnel, uint8_t *frame, int32_t length){
+    layer_proc_func_list *proc = tunnel->send_proc;
+    int32_t t1 = kernel_get_tick_callback();
+    proc[0].func( &proc[1], tunnel, frame, length );                            // <! frame freed by tunnel
+    kernel_link_sent( tunnel, length, kernel_get_tick_callback() - t1 );        // <! bandwidth of link, see kernel_link.c
+}
+
+/**
+ *  @brief queue frame to lane of tunnel, frame is freed inside
+ *
+ *  @param [in] frame x_malloc
+ *  @param [out]
+ *  @return false if dropped
+ **/
+static bool kernel_tx_push(struct comm_tunnel_t *tunnel, uint8_t *frame, int32_t length, int32_t lane){
+    struct kernel_tx_t *tx = kernel_tx_of( tunnel, true );
+    if( tx == NULL ){ kernel_tx_tunnel_send( tunnel, frame, length );  return true; }
+
+    bool pushed = true;
+    KERNEL_TX_LOCK( &tx->mutex );
+    struct kernel_tx_lane_t *l = &tx->lane[ lane ];
+    if( l->count == KERNEL_TX_QUEUE_NUM ){
+        l->dropped++;
+        if( lane == KERNEL_TX_DATA ){
+            pushed = false;
+        }else{                                          // <! drop the oldest control frame
+            x_free( l->frame[l->head] );
+            l->head = (l->head + 1) % KERNEL_TX_QUEUE_NUM;
+            l->count--;
+        }
+    }
+    if( pushed ){
+        int32_t tail = (l->head + l->count) % KERNEL_TX_QUEUE_NUM;
+        l->frame[ tail ]  = frame;
+        l->length[ tail ] = length;
+        l->count++;
+    }
+    KERNEL_TX_UNLOCK( &tx->mutex );
+
+    if( ! pushed ){
+        WARNING( "Send queue of tunnel full, frame dropped" );
+        x_free( frame );
+    }
+    return pushed;
+}
+
+static bool kernel_tx_data(struct comm_tunnel_t *tunnel, uint8_t *frame, int32_t length){
+    return kernel_tx_push( tunnel, frame, length, KERNEL_TX_DATA );
+}
+
+/**
+ *  @brief data lane of tunnel can take one more frame
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+static bool kernel_tx_data_room(struct comm_tunnel_t *tunnel){
+    struct kernel_tx_t *tx = kernel_tx_of( tunnel, false );
+    if( tx == NULL ){ return true; }
+
+    KERNEL_TX_LOCK( &tx->mutex );
+    bool room = ( tx->lane[ KERNEL_TX_DATA ].count < KERNEL_TX_QUEUE_NUM );
+    KERNEL_TX_UNLOCK( &tx->mutex );
+    return room;
+}
+
+static void kernel_tx_control(struct comm_tunnel_t *tunnel, uint8_t *frame, int32_t length){
+    kernel_tx_push( tunnel, frame, length, KERNEL_TX_CONTROL );
+}
+
+/**
+ *  @brief send queued frames of tunnel, control lane first
+ *
+ *  @param [in] budget: max frames, <= 0 for all sendable frames
+ *  @param [out]
+ *  @return frames sent
+ **/
+static int32_t kernel_tx_drain(struct kernel_tx_t *tx, int32_t budget){
+    int32_t n = 0;
+    while( (budget <= 0) || (n < budget) ){
+        uint8_t *frame = NULL;  int32_t length = 0;
+
+        KERNEL_TX_LOCK( &tx->mutex );
+        struct kernel_tx_lane_t *l = &tx->lane[ KERNEL_TX_CONTROL ];
+        if( l->count == 0 ){
+            l = &tx->lane[ KERNEL_TX_DATA ];
+            if( (all_support & KERNEL_CAP_CREDIT) && (tx->credits <= 0) ){ l = NULL; }   // <! wait for credit
+        }
+        if( (l != NULL) && (l->count > 0) ){
+            frame  = l->frame[ l->head ];
+            length = l->length[ l->head ];
+            l->head = (l->head + 1) % KERNEL_TX_QUEUE_NUM;
+            l->count--;
+            if( (all_support & KERNEL_CAP_CREDIT) && (! kernel_tx_is_credit(frame, length)) ){ tx->credits--; }   // <! control frame may take credit below 0
+        }
+        KERNEL_TX_UNLOCK( &tx->mutex );
+
+        if( frame == NULL ){ break; }
+        kernel_tx_tunnel_send( tx->tunnel, frame, length );      // <! outside of lock, only this tunnel waits
+        tx->sent++;  n++;
+    }
+    return n;
+}
+
+/**
+ *  @brief peer returned credit, called by kernel_wire_unpack
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+static void kernel_tx_credit(struct comm_tunnel_t *tunnel, uint32_t credits){
+    struct kernel_tx_t *tx = kernel_tx_of( tunnel, true );
+    if( tx == NULL ){ return; }
+
+    KERNEL_TX_LOCK( &tx->mutex );
+    tx->credits += (int32_t)((credits > KERNEL_TX_CREDITS)?(KERNEL_TX_CREDITS):(credits));
+    if( tx->credits > KERNEL_TX_CREDITS ){ tx->credits = KERNEL_TX_CREDITS; }
+    tx->credit_wait_ms = 0;
+    KERNEL_TX_UNLOCK( &tx->mutex );
+}
+
+/**
+ *  @brief frame received from tunnel, credit of it is returned later
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+static void kernel_tx_consumed(struct comm_tunnel_t *tunnel, const uint8_t *frame, int32_t length){
+    if( (! (all_support & KERNEL_CAP_CREDIT)) || kernel_tx_is_credit(frame, length) ){ return; }
+    struct kernel_tx_t *tx = kernel_tx_of( tunnel, true );
+    if( tx == NULL ){ return; }
+
+    KERNEL_TX_LOCK( &tx->mutex );
+    tx->consumed++;
+    KERNEL_TX_UNLOCK( &tx->mutex );
+}
+
+/**
+ *  @brief msg received from tunnel is queued to local task, credit of tunnel is held
+ *         until kernel_tx_rx_release, called by kernel_recv_msg
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+static void kernel_tx_rx_hold(struct comm_tunnel_t *tunnel){
+    if( ! (all_support & KERNEL_CAP_CREDIT) ){ return; }
+    struct kernel_tx_t *tx = kernel_tx_of( tunnel, true );
+    if( tx == NULL ){ return; }
+
+    KERNEL_TX_LOCK( &tx->mutex );
+    tx->rx_queued++;
+    KERNEL_TX_UNLOCK( &tx->mutex );
+}
+
+/**
+ *  @brief msg held by kernel_tx_rx_hold is deleted, called by __delete_msg
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+static void kernel_tx_rx_release(struct comm_tunnel_t *tunnel){
+    struct kernel_tx_t *tx = kernel_tx_of( tunnel, false );
+    if( tx == NULL ){ return; }
+
+    KERNEL_TX_LOCK( &tx->mutex );
+    if( tx->rx_queued > 0 ){ tx->rx_queued--; }
+    KERNEL_TX_UNLOCK( &tx->mutex );
+}
+
+static void kernel_tx_return_credit(struct kernel_tx_t *tx){
+    uint8_t *frame = (uint8_t *)x_malloc( 2 + 2 + 5 );
+    if( frame == NULL ){ return; }
+
+    struct kernel_wire_t w = { frame, 0, 2 + 2 + 5, false };
+    w.buf[ w.len++ ] = KERNEL_WIRE_MAGIC;
+    w.buf[ w.len++ ] = KERNEL_WIRE_CREDIT;
+    KERNEL_TX_LOCK( &tx->mutex );
+    kernel_wire_put_uint( &w, WIRE_CREDIT, tx->consumed );
+    tx->consumed = 0;
+    KERNEL_TX_UNLOCK( &tx->mutex );
+    kernel_tx_push( tx->tunnel, frame, w.len, KERNEL_TX_CONTROL );
+}
+
+/**
+ *  @brief called at the end of scheduler pass, after kernel_batch_pass_end
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+void kernel_tx_pass_end(int32_t delta_ms){
+    struct kernel_tx_t *tx = kernel_tx_queue;
+    while( tx != NULL ){
+        if( all_support & KERNEL_CAP_CREDIT ){
+            if( (tx->consumed >= KERNEL_TX_CREDIT_RETURN) && (tx->rx_queued == 0) ){   // <! held back while msg of tunnel is pending
+                kernel_tx_return_credit( tx );
+            }
+
+            KERNEL_TX_LOCK( &tx->mutex );
+            if( (tx->credits <= 0) && (tx->lane[KERNEL_TX_DATA].count > 0) ){
+                tx->credit_wait_ms += delta_ms;
+                if( tx->credit_wait_ms >= KERNEL_TX_CREDIT_TIMEOUT_MS ){
+                    tx->credits = KERNEL_TX_CREDITS;                    // <! credit frame lost
+                    tx->credit_wait_ms = 0;
+                    WARNING( "No credit returned from tunnel, restore credit" );
+                }
+            }
+            KERNEL_TX_UNLOCK( &tx->mutex );
+        }
+
+        kernel_tx_drain( tx, KERNEL_TX_BURST );
+        tx = tx->next;
+    }
+}
+
+/**
+ *  @brief time before queued frame can be sent, used by kernel_idle_time
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return -1 if nothing queued
+ **/
+int32_t kernel_tx_next_time(void){
+    int32_t min_time = -1;
+    struct kernel_tx_t *tx = kernel_tx_queue;
+    while( tx != NULL ){
+        int32_t t = -1;
+        if( (tx->lane[KERNEL_TX_CONTROL].count > 0) || ((tx->consumed >= KERNEL_TX_CREDIT_RETURN) && (tx->rx_queued == 0)) ){
+            t = 0;
+        }else if( tx->lane[KERNEL_TX_DATA].count > 0 ){
+            t = ((all_support & KERNEL_CAP_CREDIT) && (tx->credits <= 0))?(KERNEL_TX_CREDIT_TIMEOUT_MS - tx->credit_wait_ms):(0);
+        }
+        if( (t >= 0) && ((min_time < 0) || (t < min_time)) ){ min_time = t; }
+        tx = tx->next;
+    }
+    return min_time;
+}
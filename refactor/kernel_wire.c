@@ -0,0 +1,888 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/*************************************************************************
+
+           -------------------------------------------------
+          |                                                 |
+          |     Compact Binary Frame Between Other MCUs     |
+          |                                                 |
+           -------------------------------------------------
+
+ frame : [ KERNEL_WIRE_MAGIC ][ type ][ tlv ][ tlv ] ...
+ tlv   : [ tag : 1 byte ][ length : varint ][ value : length bytes ]
+
+ Note:
+ 1.varint is LEB128, signed value is zigzag encoded first
+ 2.string value carries its '\0', so receiver uses it in place
+ 3.binary data is raw bytes, no hex / extra data trailer needed
+ 4.frame is only sent when every core announced "SupportBinFrame",
+   JSON stays the fallback for old peers
+ 5.unknown tags are skipped, so fields can be added later
+ 6.when every core announced "SupportIds", tasks, cores and mmap are
+   carried as numeric ids instead of names, names stay as fallback field
+   by field. ids are dense and assigned by their owner: tasks by their
+   core (kernel_task_id_bind), cores by sync (kernel_mcu_id_assign),
+   mmap by receiving core, sent along in KERNEL_WIRE_MMAP_SYNC_REQ
+ 7.frame to core behind relays is wrapped by fixed routing header when
+   every core announced "SupportRouteHead":
+        [KERNEL_WIRE_MAGIC][KERNEL_WIRE_ROUTED][core id lo][core id hi][hops][frame]
+   relay looks at the header only, decreases hops and passes the same
+   buffer on (see kernel_msg_layer_take), destination unpacks [frame]
+ 8.KERNEL_WIRE_DELTA / KERNEL_WIRE_DIGEST / KERNEL_WIRE_SYNC_REQ share the
+   tags of KERNEL_WIRE_CORES, see kernel_delta_sync.c
+ 9.WIRE_MEM_RUNS carries changed runs of mmap in place of WIRE_MEM_DATA:
+        [region size][gap][length][bytes][gap][length][bytes] ...
+   gap is counted from end of previous run, all varints
+
+*************************************************************************/
+
+enum {
+    KERNEL_WIRE_MSG           = 1,
+    KERNEL_WIRE_MMAP          = 2,
+    KERNEL_WIRE_MMAP_SYNC_REQ = 3,
+    KERNEL_WIRE_CORES         = 4,
+    KERNEL_WIRE_BATCH         = 5,                      // <! see kernel_batch.c
+    KERNEL_WIRE_CREDIT        = 6,                      // <! see kernel_tx.c
+    KERNEL_WIRE_ROUTED        = 7,                      // <! fixed routing header, not tlv
+    KERNEL_WIRE_PROBE         = 8,                      // <! see kernel_link.c
+    KERNEL_WIRE_DELTA         = 9,                      // <! see kernel_delta_sync.c
+    KERNEL_WIRE_DIGEST        = 10,
+    KERNEL_WIRE_SYNC_REQ      = 11,
+};
+
+enum {
+    // !> KERNEL_WIRE_MSG
+    WIRE_TARG_TASK  = 1,
+    WIRE_SRC_TASK   = 2,
+    WIRE_NOTIFY     = 3,
+    WIRE_DATA       = 4,
+    WIRE_TIMER      = 5,                                // <! delay, preodic, cnt (zigzag varint)
+    WIRE_CALL_ID    = 6,
+    WIRE_CALL_REPLY = 7,                                // <! no value
+    WIRE_TARG_ID    = 8,                                // <! core id, task id (varint)
+    WIRE_SRC_ID     = 9,                                // <! core id, task id (varint)
+    WIRE_DATA_LZ    = 10,                               // <! raw length (varint), compressed data, see kernel_lz.c
+
+    // !> KERNEL_WIRE_MMAP, KERNEL_WIRE_MMAP_SYNC_REQ, entry of mmap starts with WIRE_MEM_NAME / WIRE_MEM_ID
+    WIRE_MEM_NAME   = 1,
+    WIRE_SRC_CORE   = 2,
+    WIRE_DST_CORE   = 3,
+    WIRE_MEM_DATA   = 4,
+    WIRE_MEM_ID     = 5,
+    WIRE_SRC_CORE_ID = 6,
+    WIRE_DST_CORE_ID = 7,
+    WIRE_MEM_DATA_LZ = 8,                               // <! same as WIRE_DATA_LZ
+    WIRE_MEM_RUNS   = 9,                                // <! changed runs only, see kernel_wire_send_mmap_delta
+
+    // !> KERNEL_WIRE_CORES, entry of core starts with WIRE_CORE
+    WIRE_CORE       = 1,
+    WIRE_JUMP       = 2,
+    WIRE_FLAGS      = 3,                                // <! KERNEL_CAP_xxx, 1 or 2 bytes little endian
+    WIRE_TASK       = 4,
+    WIRE_CORE_ID    = 5,
+    WIRE_TASK_ID    = 6,                                // <! id of the following WIRE_TASK
+    WIRE_COST       = 7,                                // <! cost of route to the core
+    WIRE_VIA        = 8,                                // <! id of next core on the route
+    WIRE_VERSION    = 9,                                // <! version of task list of the core
+    WIRE_BASE       = 10,                               // <! version the delta applies to
+    WIRE_TASK_DEL   = 11,                               // <! name of task removed
+
+    // !> KERNEL_WIRE_BATCH
+    WIRE_PART       = 1,                                // <! a complete frame
+
+    // !> KERNEL_WIRE_CREDIT
+    WIRE_CREDIT     = 1,                                // <! frames consumed by receiver (varint)
+
+    // !> KERNEL_WIRE_PROBE
+    WIRE_PROBE_SEQ  = 1,                                // <! echo me
+    WIRE_PROBE_ECHO = 2,                                // <! seq of probe answered
+};
+
+#define KERNEL_WIRE_ROUTE_HEAD          5               // <! magic + type + core id + hops
+
+#ifndef KERNEL_WIRE_ROUTE_HOPS
+#define KERNEL_WIRE_ROUTE_HOPS          16              // <! relays passed before routed frame is dropped
+#endif
+
+struct kernel_wire_t {
+    uint8_t                       *buf;                 // <! pass arena (or heap fallback)
+    int32_t                       len;
+    int32_t                       size;
+    bool                          err;
+};
+
+struct kernel_wire_reader_t {
+    const uint8_t                 *p;
+    const uint8_t                 *end;
+};
+
+static void kernel_batch_unpack(struct comm_tunnel_t *tunnel, struct kernel_wire_reader_t *r);
+static void kernel_tx_credit(struct comm_tunnel_t *tunnel, uint32_t credits);
+static void kernel_link_unpack_probe(struct comm_tunnel_t *tunnel, struct kernel_wire_reader_t *r);
+static void kernel_delta_unpack(struct comm_tunnel_t *tunnel, struct kernel_wire_reader_t *r, const uint8_t *raw_data, int32_t raw_length);
+static void kernel_delta_unpack_digest(struct comm_tunnel_t *tunnel, struct kernel_wire_reader_t *r);
+static void kernel_delta_unpack_req(struct comm_tunnel_t *tunnel, struct kernel_wire_reader_t *r);
+
+// !> payload compression, see kernel_lz.c
+#ifndef KERNEL_LZ_MAX_SIZE
+#define KERNEL_LZ_MAX_SIZE              0xFFFF
+#endif
+static int32_t kernel_lz_compress(const uint8_t *src, int32_t length, uint8_t *dst, int32_t dst_size);
+static int32_t kernel_lz_decompress(const uint8_t *src, int32_t length, uint8_t *dst, int32_t raw_length);
+
+  /**********************************************************************
+  |                                                                     |
+  |                              writer                                 |
+  |                                                                     |
+  **********************************************************************/
+
+static bool kernel_wire_reserve(struct kernel_wire_t *w, int32_t need){
+    if( w->err ){ return false; }
+    if( w->len + need <= w->size ){ return true; }
+
+    int32_t size = w->size * 2;
+    while( size < w->len + need ){ size *= 2; }
+
+    uint8_t *buf = (uint8_t *)kernel_pass_malloc( size );
+    if( buf == NULL ){ w->err = true;  return false; }
+    memcpy( buf, w->buf, w->len );
+    kernel_pass_free( w->buf );
+    w->buf  = buf;
+    w->size = size;
+    return true;
+}
+
+static bool kernel_wire_begin(struct kernel_wire_t *w, uint8_t type){
+    memset( w, 0x0, sizeof(struct kernel_wire_t) );
+    w->size = 64;
+    w->buf  = (uint8_t *)kernel_pass_malloc( w->size );
+    if( w->buf == NULL ){ w->err = true;  return false; }
+
+    w->buf[ w->len++ ] = KERNEL_WIRE_MAGIC;
+    w->buf[ w->len++ ] = type;
+    return true;
+}
+
+/**
+ *  @brief begin frame to core, routing header goes first when core is behind relays
+ *
+ *  @param [in] jump : jump point of the core, 1 for neighbour
+ *  @param [out]
+ *  @return
+ **/
+static bool kernel_wire_begin_to(struct kernel_wire_t *w, uint8_t type, uint16_t dst_id, int32_t jump){
+    if( (! (all_support & KERNEL_CAP_ROUTE_HEAD)) || (dst_id == 0) || (jump <= 1) ){ return kernel_wire_begin( w, type ); }
+    if( ! kernel_wire_begin(w, KERNEL_WIRE_ROUTED) ){ return false; }
+
+    w->buf[ w->len++ ] = (uint8_t)( dst_id & 0xFF );
+    w->buf[ w->len++ ] = (uint8_t)( dst_id >> 8 );
+    w->buf[ w->len++ ] = KERNEL_WIRE_ROUTE_HOPS;
+    w->buf[ w->len++ ] = KERNEL_WIRE_MAGIC;            // <! inner frame
+    w->buf[ w->len++ ] = type;
+    return true;
+}
+
+static void kernel_wire_put_varint(struct kernel_wire_t *w, uint32_t v){
+    if( ! kernel_wire_reserve(w, 5) ){ return; }
+    do{
+        uint8_t b = v & 0x7F;  v >>= 7;
+        w->buf[ w->len++ ] = (v != 0)?(b | 0x80):(b);
+    }while( v != 0 );
+}
+
+static uint32_t kernel_wire_zigzag(int32_t v){
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static void kernel_wire_put_bytes(struct kernel_wire_t *w, uint8_t tag, const void *data, int32_t length){
+    if( ! kernel_wire_reserve(w, 1) ){ return; }
+    w->buf[ w->len++ ] = tag;
+    kernel_wire_put_varint( w, length );
+    if( (length > 0) && kernel_wire_reserve(w, length) ){
+        memcpy( &w->buf[w->len], data, length );
+        w->len += length;
+    }
+}
+
+static void kernel_wire_put_str(struct kernel_wire_t *w, uint8_t tag, const char *str){
+    if( str == NULL ){ return; }
+    kernel_wire_put_bytes( w, tag, str, strlen(str) + 1 );     // <! with '\0'
+}
+
+static void kernel_wire_put_uint(struct kernel_wire_t *w, uint8_t tag, uint32_t v){
+    uint8_t tmp[5];  int32_t n = 0;
+    do{
+        uint8_t b = v & 0x7F;  v >>= 7;
+        tmp[n++] = (v != 0)?(b | 0x80):(b);
+    }while( v != 0 );
+    kernel_wire_put_bytes( w, tag, tmp, n );
+}
+
+// !> compressed when every core supports it and it saves bytes
+static void kernel_wire_put_data(struct kernel_wire_t *w, uint8_t tag, uint8_t tag_lz, const void *data, int32_t length){
+    #if ( KERNEL_LZ_MIN_SIZE > 0 )
+    if( (all_support & KERNEL_CAP_LZ) && (length >= KERNEL_LZ_MIN_SIZE) && (length <= KERNEL_LZ_MAX_SIZE) ){
+        uint8_t *tmp = (uint8_t *)kernel_pass_malloc( length );
+        if( tmp != NULL ){
+            struct kernel_wire_t t = { tmp, 0, length, false };
+            kernel_wire_put_varint( &t, length );
+            int32_t lz_length = kernel_lz_compress( (const uint8_t *)data, length, &tmp[t.len], length - t.len - 1 );
+            if( lz_length > 0 ){
+                kernel_wire_put_bytes( w, tag_lz, tmp, t.len + lz_length );
+                kernel_pass_free( tmp );
+                return;
+            }
+            kernel_pass_free( tmp );
+        }
+    }
+    #endif
+    kernel_wire_put_bytes( w, tag, data, length );
+}
+
+static void kernel_wire_put_pair(struct kernel_wire_t *w, uint8_t tag, uint32_t a, uint32_t b){
+    struct kernel_wire_t t;  uint8_t tmp[10];
+    t.buf = tmp;  t.len = 0;  t.size = sizeof(tmp);  t.err = false;
+    kernel_wire_put_varint( &t, a );
+    kernel_wire_put_varint( &t, b );
+    kernel_wire_put_bytes( w, tag, tmp, t.len );
+}
+
+/**
+ *  @brief finish frame and router it, frame is freed by tunnel
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+static bool kernel_wire_route(struct kernel_wire_t *w, struct comm_tunnel_t *route, struct comm_tunnel_t *avoid_tunnel){
+    if( w->err ){
+        if( w->buf != NULL ){ kernel_pass_free( w->buf ); }
+        WARNING( "No memory for binary frame" );
+        return false;
+    }
+    if( route == NULL ){ kernel_pass_free( w->buf );  return false; }
+    return kernel_router_raw_tunnel( route, w->buf, w->len, avoid_tunnel );
+}
+
+  /**********************************************************************
+  |                                                                     |
+  |                              reader                                 |
+  |                                                                     |
+  **********************************************************************/
+
+static bool kernel_wire_get_varint(const uint8_t **p, const uint8_t *end, uint32_t *v){
+    *v = 0;
+    for( int32_t shift = 0; shift < 35; shift += 7 ){
+        if( *p >= end ){ return false; }
+        uint8_t b = *(*p)++;
+        *v |= (uint32_t)(b & 0x7F) << shift;
+        if( ! (b & 0x80) ){ return true; }
+    }
+    return false;
+}
+
+static int32_t kernel_wire_unzigzag(uint32_t v){
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+/**
+ *  @brief get next tlv
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return false: end of frame or frame broken
+ **/
+static bool kernel_wire_next(struct kernel_wire_reader_t *r, uint8_t *tag, const uint8_t **value, int32_t *length){
+    if( r->p >= r->end ){ return false; }
+    *tag = *(r->p)++;
+
+    uint32_t len = 0;
+    if( ! kernel_wire_get_varint(&r->p, r->end, &len) ){ return false; }
+    if( len > (uint32_t)(r->end - r->p) ){ return false; }
+
+    *value  = r->p;
+    *length = (int32_t)len;
+    r->p   += len;
+    return true;
+}
+
+static const char * kernel_wire_str(const uint8_t *value, int32_t length){
+    if( (length <= 0) || (value[length - 1] != '\0') ){ return NULL; }
+    return (const char *)value;
+}
+
+static uint32_t kernel_wire_uint(const uint8_t *value, int32_t length){
+    uint32_t v = 0;
+    kernel_wire_get_varint( &value, value + length, &v );
+    return v;
+}
+
+/**
+ *  @brief inflate value of WIRE_DATA_LZ / WIRE_MEM_DATA_LZ
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return kernel_pass_malloc buffer, NULL if broken
+ **/
+static uint8_t * kernel_wire_inflate(const uint8_t *value, int32_t length, int32_t *raw_length){
+    uint32_t raw = 0;  const uint8_t *p = value, *end = value + length;
+    if( (! kernel_wire_get_varint(&p, end, &raw)) || (raw == 0) || (raw > KERNEL_LZ_MAX_SIZE) ){ return NULL; }
+
+    uint8_t *buf = (uint8_t *)kernel_pass_malloc( raw );
+    if( buf == NULL ){ return NULL; }
+    if( kernel_lz_decompress(p, (int32_t)(end - p), buf, (int32_t)raw) < 0 ){
+        kernel_pass_free( buf );
+        WARNING( "Broken compressed data" );
+        return NULL;
+    }
+    *raw_length = (int32_t)raw;
+    return buf;
+}
+
+static struct kernel_external_task_t * kernel_wire_task(const uint8_t *value, int32_t length){
+    uint32_t core_id = 0, task_id = 0;
+    const uint8_t *p = value, *end = value + length;
+    if( (! kernel_wire_get_varint(&p, end, &core_id)) || (! kernel_wire_get_varint(&p, end, &task_id)) ){ return NULL; }
+    if( (core_id > 0xFFFF) || (task_id > 0xFFFF) ){ return NULL; }
+    return kernel_id_task( (uint16_t)core_id, (uint16_t)task_id );
+}
+
+static struct MCUs_t * kernel_wire_core(const uint8_t *value, int32_t length){
+    uint32_t id = kernel_wire_uint( value, length );
+    return (id <= 0xFFFF)?(kernel_id_mcu((uint16_t)id)):(NULL);
+}
+
+// !> both cores of mmap frame have ids in route snapshot, otherwise names are used
+static bool kernel_wire_core_ids(const struct kernel_route_snap_t *snap, const char *src_core, const char *dst_core,
+                                 const struct kernel_route_core_t **src, const struct kernel_route_core_t **dst){
+    if( ! (all_support & KERNEL_CAP_IDS) ){ return false; }
+    *src = kernel_route_snap_core( snap, src_core );
+    *dst = kernel_route_snap_core( snap, dst_core );
+    return (*src != NULL) && (*dst != NULL) && ((*src)->id != 0) && ((*dst)->id != 0);
+}
+
+  /**********************************************************************
+  |                                                                     |
+  |                          frame packers                              |
+  |                                                                     |
+  **********************************************************************/
+
+static bool kernel_wire_send_msg(const struct kernel_route_t *target, const struct kernel_route_t *src,
+                                 const struct kernel_msg_t *msg, const char *src_task, const void *data, int32_t length){
+    struct kernel_wire_t w;
+    if( ! kernel_wire_begin_to(&w, KERNEL_WIRE_MSG, target->mcu->id, target->mcu->jump) ){ return false; }
+
+    if( (all_support & KERNEL_CAP_IDS) && (target->id != 0) && (target->mcu->id != 0) ){
+        kernel_wire_put_pair( &w, WIRE_TARG_ID, target->mcu->id, target->id );
+    }else{
+        kernel_wire_put_str( &w, WIRE_TARG_TASK, target->task_name );
+    }
+    kernel_wire_put_str( &w, WIRE_NOTIFY, msg->msg.notification );
+
+    if( (all_support & KERNEL_CAP_IDS) && (src != NULL) && (src->id != 0) && (src->mcu->id != 0) ){
+        kernel_wire_put_pair( &w, WIRE_SRC_ID, src->mcu->id, src->id );
+    }else{
+        kernel_wire_put_str( &w, WIRE_SRC_TASK, src_task );
+    }
+    if( length > 0 ){
+        kernel_wire_put_data( &w, WIRE_DATA, WIRE_DATA_LZ, data, length );
+    }
+    if( msg->call_id != 0 ){
+        kernel_wire_put_uint( &w, WIRE_CALL_ID, msg->call_id );
+        if( msg->call_reply ){ kernel_wire_put_bytes( &w, WIRE_CALL_REPLY, NULL, 0 ); }
+    }
+    if( msg->timer.enable ){
+        struct kernel_wire_t t;  uint8_t tmp[15];
+        t.buf = tmp;  t.len = 0;  t.size = sizeof(tmp);  t.err = false;
+        kernel_wire_put_varint( &t, kernel_wire_zigzag(msg->timer.delay) );
+        kernel_wire_put_varint( &t, kernel_wire_zigzag(msg->timer.preodic) );
+        kernel_wire_put_varint( &t, kernel_wire_zigzag(msg->timer.cnt) );
+        kernel_wire_put_bytes( &w, WIRE_TIMER, tmp, t.len );
+    }
+    return kernel_wire_route( &w, target->mcu->tunnel, NULL );
+}
+
+// !> mem_id: assigned by receiving core, 0 when not bound yet
+static void kernel_wire_put_mmap_head(struct kernel_wire_t *w, const struct kernel_route_snap_t *snap,
+                                      const char *src_core, const char *dst_core, const char *mem_name, uint16_t mem_id){
+    const struct kernel_route_core_t *src = NULL, *dst = NULL;
+    if( (mem_id != 0) && kernel_wire_core_ids(snap, src_core, dst_core, &src, &dst) ){
+        kernel_wire_put_uint( w, WIRE_MEM_ID,      mem_id );
+        kernel_wire_put_uint( w, WIRE_SRC_CORE_ID, src->id );
+        kernel_wire_put_uint( w, WIRE_DST_CORE_ID, dst->id );
+    }else{
+        kernel_wire_put_str( w, WIRE_MEM_NAME, mem_name );
+        kernel_wire_put_str( w, WIRE_SRC_CORE, src_core );
+        kernel_wire_put_str( w, WIRE_DST_CORE, dst_core );
+    }
+}
+
+// !> route: core of snap, which the caller holds by kernel_route_read_lock
+static bool kernel_wire_send_mmap(const struct kernel_route_snap_t *snap, const struct kernel_route_core_t *route,
+                                  const char *src_core, const char *dst_core, const char *mem_name,
+                                  const void *mem_data, int32_t mem_size, struct comm_tunnel_t *avoid_tunnel){
+    struct kernel_wire_t w;
+    if( ! kernel_wire_begin_to(&w, KERNEL_WIRE_MMAP, route->id, route->jump) ){ return false; }
+
+    kernel_wire_put_mmap_head( &w, snap, src_core, dst_core, mem_name, kernel_mmap_to_id(src_core, dst_core, mem_name) );
+    kernel_wire_put_data( &w, WIRE_MEM_DATA, WIRE_MEM_DATA_LZ, mem_data, mem_size );
+    return kernel_wire_route( &w, route->tunnel, avoid_tunnel );
+}
+
+/**
+ *  @brief apply value of WIRE_MEM_RUNS, every run is checked before anything is written
+ *
+ *  @param [in] size : size of mem, must match region size of runs
+ *  @param [out] changed : any byte of mem changed
+ *  @return false if runs broken or for another size
+ **/
+static bool kernel_wire_apply_runs(uint8_t *mem, int32_t size, const uint8_t *runs, int32_t length, bool *changed){
+    const uint8_t *end = runs + length;
+    *changed = false;
+
+    for( int32_t pass = 0; pass < 2; pass++ ){          // <! check first, then write
+        const uint8_t *p = runs;
+        uint32_t region, gap, len, offset = 0;
+        if( ! kernel_wire_get_varint(&p, end, &region) || (region != (uint32_t)size) ){ return false; }
+
+        while( p < end ){
+            if( ! kernel_wire_get_varint(&p, end, &gap) ){ return false; }
+            if( ! kernel_wire_get_varint(&p, end, &len) ){ return false; }
+            if( (gap > (uint32_t)size - offset) || (len > (uint32_t)size - offset - gap) ){ return false; }
+            if( len > (uint32_t)(end - p) ){ return false; }
+            offset += gap;
+            if( (pass == 1) && (memcmp(&mem[offset], p, len) != 0x0) ){
+                memcpy( &mem[offset], p, len );
+                *changed = true;
+            }
+            offset += len;  p += len;
+        }
+    }
+    return true;
+}
+
+/**
+ *  @brief send changed runs of local mmap against prev_sync_mem, prev_sync_mem is
+ *         patched by the runs once sent
+ *
+ *  @param [in] p : mmap of kernel_mmap_to_queue
+ *  @param [out]
+ *  @return false if nothing sent, whole region should be sent then
+ **/
+static bool kernel_wire_send_mmap_delta(struct kernel_mmap_t *p, const char *src_core){
+    struct kernel_wire_t runs;
+    memset( &runs, 0x0, sizeof(struct kernel_wire_t) );
+    runs.size = 64;
+    runs.buf  = (uint8_t *)kernel_pass_malloc( runs.size );
+    if( runs.buf == NULL ){ return false; }
+
+    kernel_wire_put_varint( &runs, p->mem_size );
+    int32_t offset = 0, last = 0, len;
+    while( (! runs.err) && ((len = kernel_mmap_dirty_run(p, &offset)) > 0) ){
+        kernel_wire_put_varint( &runs, offset - last );
+        kernel_wire_put_varint( &runs, len );
+        if( kernel_wire_reserve(&runs, len) ){
+            memcpy( &runs.buf[runs.len], (const uint8_t *)p->mem + offset, len );
+            runs.len += len;
+        }
+        if( runs.len > p->mem_size / 2 ){ runs.err = true; }    // <! whole region is cheaper
+        offset += len;  last = offset;
+    }
+
+    bool ret = false;
+    uint32_t epoch;
+    const struct kernel_route_snap_t *snap = kernel_route_read_lock( &epoch );     // <! no lock against receive path
+    const struct kernel_route_core_t *route = kernel_route_snap_core( snap, p->to_core );
+    if( (route == NULL) || (route->tunnel == NULL) ||
+        (route->tunnel->passive_tunnel && (! route->tunnel->tunnel_enabled)) ){     // <! Tunnel Disabled
+        runs.err = true;
+    }
+
+    struct kernel_wire_t w;
+    if( (! runs.err) && kernel_wire_begin_to(&w, KERNEL_WIRE_MMAP, route->id, route->jump) ){
+        kernel_wire_put_mmap_head( &w, snap, src_core, p->to_core, p->mem_name, p->mem_id );
+        kernel_wire_put_bytes( &w, WIRE_MEM_RUNS, runs.buf, runs.len );
+        ret = kernel_wire_route( &w, route->tunnel, NULL );
+        if( ret ){
+            bool changed;
+            kernel_wire_apply_runs( (uint8_t *)p->prev_sync_mem, p->mem_size, runs.buf, runs.len, &changed );
+        }
+    }
+    kernel_route_read_unlock( epoch );
+    kernel_pass_free( runs.buf );
+    return ret;
+}
+
+static bool kernel_wire_send_mmap_req(const struct kernel_route_snap_t *snap, const struct kernel_route_core_t *route,
+                                      const char *src_core, const char *dst_core, struct comm_tunnel_t *avoid_tunnel){
+    struct kernel_wire_t w;
+    if( ! kernel_wire_begin_to(&w, KERNEL_WIRE_MMAP_SYNC_REQ, route->id, route->jump) ){ return false; }
+
+    const struct kernel_route_core_t *src = NULL, *dst = NULL;
+    if( kernel_wire_core_ids(snap, src_core, dst_core, &src, &dst) ){
+        kernel_wire_put_uint( &w, WIRE_SRC_CORE_ID, src->id );
+        kernel_wire_put_uint( &w, WIRE_DST_CORE_ID, dst->id );
+    }else{
+        kernel_wire_put_str( &w, WIRE_SRC_CORE, src_core );
+        kernel_wire_put_str( &w, WIRE_DST_CORE, dst_core );
+    }
+
+    const struct kernel_route_core_t *local = kernel_route_snap_core( snap, dst_core );
+    if( (all_support & KERNEL_CAP_IDS) && (local != NULL) && local->is_local ){    // <! ids of receiving spaces for sending core
+        for( struct kernel_mmap_t *p = kernel_mmap_from_queue; p != NULL; p = p->next ){
+            if( (p->mem_id == 0) || (strcmp(p->from_core, src_core) != 0x0) ){ continue; }
+            kernel_wire_put_str( &w, WIRE_MEM_NAME, p->mem_name );
+            kernel_wire_put_uint( &w, WIRE_MEM_ID, p->mem_id );
+        }
+    }
+    return kernel_wire_route( &w, route->tunnel, avoid_tunnel );
+}
+
+/**
+ *  @brief pack task list of cores, same content as "Cores" JSON of synchonize_tasklist
+ *
+ *  @param [in] mark : only cores of KERNEL_SYNC_MARK_xxx, 0 for all cores
+ *  @param [out] length
+ *  @return frame in pass arena, NULL if failed
+ **/
+static uint8_t * kernel_wire_pack_cores(int32_t *length, uint8_t mark){
+    struct kernel_wire_t w;
+    if( ! kernel_wire_begin(&w, KERNEL_WIRE_CORES) ){ return NULL; }
+
+    struct MCUs_t *mcu = kernel_mcu_queue;
+    while( mcu != NULL ){
+        if( ! mcu->is_local ){                                          // <! Check Non-local MCU
+            struct kernel_external_task_t  *t = mcu->task_queue;
+            while( t != NULL ){ if( t->cached ){ break; } t = t->next; }  // <! Remove cached tasks
+            if( t != NULL ){ mcu = mcu->next; continue; }                 // <! Ignore MCU when cached
+        }
+        if( (mark != 0) && (! (mcu->sync_mark & mark)) ){ mcu = mcu->next;  continue; }
+
+        uint8_t flag_bytes[2] = { (uint8_t)( mcu->caps & 0xFF ), (uint8_t)( mcu->caps >> 8 ) };
+        kernel_wire_put_str( &w, WIRE_CORE, mcu->core );
+        kernel_wire_put_uint( &w, WIRE_JUMP, mcu->jump + 1 );
+        kernel_wire_put_bytes( &w, WIRE_FLAGS, flag_bytes, 2 );
+        if( mcu->id != 0 ){ kernel_wire_put_uint( &w, WIRE_CORE_ID, mcu->id ); }
+        kernel_wire_put_uint( &w, WIRE_VERSION, mcu->version );
+        kernel_wire_put_uint( &w, WIRE_COST, (mcu->is_local)?(0):(mcu->cost) );
+        if( kernel_link_via(mcu) != 0 ){ kernel_wire_put_uint( &w, WIRE_VIA, kernel_link_via(mcu) ); }
+
+        struct kernel_external_task_t  *task = mcu->task_queue;
+        while( task != NULL ){
+            if( task->id != 0 ){ kernel_wire_put_uint( &w, WIRE_TASK_ID, task->id ); }
+            kernel_wire_put_str( &w, WIRE_TASK, task->task_name );
+            task = task->next;
+        }
+        mcu = mcu->next;
+    }
+
+    if( w.err ){
+        if( w.buf != NULL ){ kernel_pass_free( w.buf ); }
+        return NULL;
+    }
+    *length = w.len;
+    return w.buf;
+}
+
+  /**********************************************************************
+  |                                                                     |
+  |                          frame unpacker                             |
+  |                                                                     |
+  **********************************************************************/
+
+static void kernel_wire_unpack_msg(struct comm_tunnel_t *tunnel, struct kernel_wire_reader_t *r,
+                                   const uint8_t *raw_data, int32_t raw_length){
+    struct kernel_recv_msg_t m;  uint8_t tag;  const uint8_t *v;  int32_t len;
+    uint8_t *inflated = NULL;
+    memset( &m, 0x0, sizeof(m) );
+
+    while( kernel_wire_next(r, &tag, &v, &len) ){
+        switch( tag ){
+            case WIRE_TARG_TASK  : m.target_task  = kernel_wire_str( v, len );  break;
+            case WIRE_SRC_TASK   : m.src_task     = kernel_wire_str( v, len );  break;
+            case WIRE_TARG_ID    :
+                if( NULL != (m.target = kernel_wire_task(v, len)) ){ m.target_task = m.target->task_name; }
+                else{ WARNING( "Unknown target task id" ); }
+                break;
+            case WIRE_SRC_ID     : {
+                struct kernel_external_task_t *src = kernel_wire_task( v, len );
+                if( src != NULL ){ m.src_task = src->task_name; }
+            } break;
+            case WIRE_NOTIFY     : m.notification = kernel_wire_str( v, len );  break;
+            case WIRE_DATA       : m.data = (const char *)v;  m.length = (len > 0)?(len):(-1);  break;
+            case WIRE_DATA_LZ    :
+                if( inflated == NULL ){ inflated = kernel_wire_inflate( v, len, &m.length ); }
+                m.data   = (const char *)inflated;
+                m.length = (inflated != NULL)?(m.length):(-1);
+                break;
+            case WIRE_CALL_ID    : m.call_id      = kernel_wire_uint( v, len ); break;
+            case WIRE_CALL_REPLY : m.call_reply   = true;                       break;
+            case WIRE_TIMER      : {
+                uint32_t delay = 0, preodic = 0, cnt = 0;
+                const uint8_t *p = v, *end = v + len;
+                if( kernel_wire_get_varint(&p, end, &delay) && kernel_wire_get_varint(&p, end, &preodic) &&
+                    kernel_wire_get_varint(&p, end, &cnt) ){
+                    m.timer   = true;
+                    m.delay   = kernel_wire_unzigzag( delay );
+                    m.preodic = kernel_wire_unzigzag( preodic );
+                    m.cnt     = kernel_wire_unzigzag( cnt );
+                }
+            } break;
+            default : break;
+        }
+    }
+    kernel_recv_msg( tunnel, &m, raw_data, raw_length );
+    if( inflated != NULL ){ kernel_pass_free( inflated ); }
+}
+
+/**
+ *  @brief mmap entry carried by id and not for local core: name is unknown here, pass the frame on
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+static void kernel_wire_pass_on(const struct MCUs_t *dst, struct comm_tunnel_t *tunnel, const uint8_t *raw_data, int32_t raw_length){
+    if( dst == NULL ){ return; }
+
+    uint32_t epoch;
+    const struct kernel_route_snap_t *snap = kernel_route_read_lock( &epoch );
+    const struct kernel_route_core_t *route = kernel_route_snap_core( snap, dst->core );
+    if( (route != NULL) && (route->tunnel != NULL) &&                                    // <! NULL for local core
+        ((! route->tunnel->passive_tunnel) || route->tunnel->tunnel_enabled) ){            // <! Tunnel Disabled
+        uint8_t *router_data = (uint8_t *)x_malloc( raw_length );
+        if( router_data != NULL ){
+            memcpy( router_data, raw_data, raw_length );
+            kernel_router_raw_to( route, router_data, raw_length, tunnel );
+        }
+    }
+    kernel_route_read_unlock( epoch );
+}
+
+static void kernel_wire_unpack_mmap(struct comm_tunnel_t *tunnel, struct kernel_wire_reader_t *r,
+                                    const uint8_t *raw_data, int32_t raw_length){
+    const char *mem_name = NULL, *src_core = NULL, *dst_core = NULL;
+    const uint8_t *mem_data = NULL;  int32_t mem_size = 0;  int32_t mem_id = -1;
+    const uint8_t *runs = NULL;  int32_t runs_len = 0;
+    uint8_t *inflated = NULL;
+    struct MCUs_t *src = NULL, *dst = NULL;
+    uint8_t tag;  const uint8_t *v;  int32_t len;
+
+    for( bool more = true; more; ){
+        more = kernel_wire_next( r, &tag, &v, &len );
+        if( (! more) || (tag == WIRE_MEM_NAME) || (tag == WIRE_MEM_ID) ){     // <! entry finished
+            if( src != NULL ){ src_core = src->core; }
+            if( dst != NULL ){ dst_core = dst->core; }
+            if( (mem_id >= 0) && (src_core != NULL) && (dst != NULL) ){
+                if( dst->is_local ){ mem_name = kernel_mmap_id_name( src_core, (uint16_t)mem_id ); }
+                else               { kernel_wire_pass_on( dst, tunnel, raw_data, raw_length );  mem_data = NULL;  runs = NULL; }
+            }
+            if( (mem_name != NULL) && (mem_data != NULL) && (mem_size > 0) ){
+                kernel_recv_mmap( tunnel, src_core, dst_core, mem_name, (void *)mem_data, mem_size );
+            }
+            if( (mem_name != NULL) && (runs != NULL) && (src_core != NULL) && (dst_core != NULL) ){
+                struct MCUs_t *to = (dst != NULL)?(dst):(is_mcu_exist( dst_core ));
+                if( (to != NULL) && to->is_local ){ kernel_mmap_patch_from( src_core, mem_name, runs, runs_len ); }
+                else                              { kernel_wire_pass_on( to, tunnel, raw_data, raw_length ); }
+            }
+            if( inflated != NULL ){ kernel_pass_free( inflated );  inflated = NULL; }
+            mem_name = NULL;  src_core = NULL;  dst_core = NULL;  mem_data = NULL;  mem_size = 0;
+            runs = NULL;  runs_len = 0;  mem_id = -1;  src = NULL;  dst = NULL;
+        }
+        if( ! more ){ break; }
+
+        switch( tag ){
+            case WIRE_MEM_NAME    : mem_name = kernel_wire_str( v, len );  break;
+            case WIRE_SRC_CORE    : src_core = kernel_wire_str( v, len );  break;
+            case WIRE_DST_CORE    : dst_core = kernel_wire_str( v, len );  break;
+            case WIRE_MEM_DATA    : mem_data = v;  mem_size = len;         break;
+            case WIRE_MEM_DATA_LZ :
+                if( inflated == NULL ){ inflated = kernel_wire_inflate( v, len, &mem_size ); }
+                mem_data = inflated;
+                break;
+            case WIRE_MEM_RUNS    : runs = v;  runs_len = len;             break;
+            case WIRE_MEM_ID      : mem_id = (int32_t)(kernel_wire_uint( v, len ) & 0xFFFF);  break;
+            case WIRE_SRC_CORE_ID : src = kernel_wire_core( v, len );      break;
+            case WIRE_DST_CORE_ID : dst = kernel_wire_core( v, len );      break;
+            default : break;
+        }
+    }
+}
+
+static void kernel_wire_unpack_mmap_req(struct comm_tunnel_t *tunnel, struct kernel_wire_reader_t *r,
+                                        const uint8_t *raw_data, int32_t raw_length){
+    const char *src_core = NULL, *dst_core = NULL, *mem_name = NULL;
+    struct MCUs_t *src = NULL;
+    uint8_t tag;  const uint8_t *v;  int32_t len;
+
+    while( kernel_wire_next(r, &tag, &v, &len) ){
+        switch( tag ){
+            case WIRE_SRC_CORE    : src_core = kernel_wire_str( v, len );  break;
+            case WIRE_DST_CORE    : dst_core = kernel_wire_str( v, len );  break;
+            case WIRE_SRC_CORE_ID : {
+                if( NULL != (src = kernel_wire_core( v, len )) ){ src_core = src->core; }
+            } break;
+            case WIRE_DST_CORE_ID : {
+                struct MCUs_t *dst = kernel_wire_core( v, len );
+                if( dst != NULL ){ dst_core = dst->core; }
+            } break;
+            case WIRE_MEM_NAME    : mem_name = kernel_wire_str( v, len );  break;
+            case WIRE_MEM_ID      : {                                     // <! follows its WIRE_MEM_NAME
+                uint32_t mem_id = kernel_wire_uint( v, len );
+                if( (mem_name != NULL) && (src_core != NULL) && (dst_core != NULL) && (mem_id <= 0xFFFF) ){
+                    kernel_mmap_to_bind( src_core, dst_core, mem_name, (uint16_t)mem_id );
+                }
+                mem_name = NULL;
+            } break;
+            default : break;
+        }
+    }
+
+    if( (src_core != NULL) && (src == NULL) ){ src = is_mcu_exist( src_core ); }
+    if( (src != NULL) && (! src->is_local) && (src->tunnel != tunnel) ){      // <! ids go on to sending core
+        kernel_wire_pass_on( src, tunnel, raw_data, raw_length );
+        return;
+    }
+    kernel_recv_mmap_sync_req( tunnel, src_core, dst_core );
+}
+
+static void kernel_wire_unpack_cores(struct comm_tunnel_t *tunnel, struct kernel_wire_reader_t *r){
+    if( get_my_core_name() == NULL ){ return; }
+
+    struct kernel_recv_cores_t ctx;  struct kernel_recv_core_t c;
+    struct MCUs_t *mcu = NULL;  const char *core_name = NULL;  bool head_done = true;
+    int32_t task_id = -1;
+    uint8_t tag;  const uint8_t *v;  int32_t len;
+
+    kernel_recv_cores_begin( &ctx, tunnel );
+    for( bool more = true; more; ){
+        more = kernel_wire_next( r, &tag, &v, &len );
+        if( (! head_done) && ((! more) || (tag == WIRE_CORE) || (tag == WIRE_TASK) || (tag == WIRE_TASK_ID)) ){  // <! core head finished
+            mcu = kernel_recv_core( &ctx, &c );
+            head_done = true;
+        }
+        if( (core_name != NULL) && ((! more) || (tag == WIRE_CORE)) ){                     // <! core finished
+            kernel_recv_core_end( &ctx, mcu );
+            core_name = NULL;  mcu = NULL;
+        }
+        if( ! more ){ break; }
+
+        switch( tag ){
+            case WIRE_CORE    :
+                if( NULL != (core_name = kernel_wire_str(v, len)) ){
+                    kernel_recv_core_init( &c, core_name );
+                    head_done = false;  task_id = -1;
+                } break;
+
+            case WIRE_JUMP    : c.jump    = (int32_t)kernel_wire_uint( v, len );  break;
+            case WIRE_CORE_ID : c.core_id = (int32_t)kernel_wire_uint( v, len );  break;
+            case WIRE_COST    : c.cost    = (int32_t)kernel_wire_uint( v, len );  break;
+            case WIRE_VIA     : c.via     = (int32_t)kernel_wire_uint( v, len );  break;
+            case WIRE_VERSION : c.version = kernel_wire_uint( v, len );           break;
+            case WIRE_FLAGS   :
+                if( len > 0 ){
+                    c.caps       = v[0] | ((len > 1)?((uint16_t)v[1] << 8):(0));      // <! second byte missing: not supported
+                    c.caps_known = 0xFFFF;
+                } break;
+
+            case WIRE_TASK_ID : task_id = (int32_t)kernel_wire_uint( v, len );  break;
+            case WIRE_TASK    : {
+                const char *task_name = kernel_wire_str( v, len );
+                if( task_name != NULL ){ kernel_recv_core_task( &ctx, mcu, task_name, task_id ); }
+                task_id = -1;
+            } break;
+            default : break;
+        }
+    }
+    kernel_recv_cores_end( &ctx );
+}
+
+/**
+ *  @brief unpack binary frame, called by kernel_msg_layer_unpack
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+static void kernel_wire_unpack_credit(struct comm_tunnel_t *tunnel, struct kernel_wire_reader_t *r){
+    uint8_t tag;  const uint8_t *v;  int32_t len;
+    while( kernel_wire_next(r, &tag, &v, &len) ){
+        if( tag == WIRE_CREDIT ){ kernel_tx_credit( tunnel, kernel_wire_uint(v, len) ); }
+    }
+}
+
+/**
+ *  @brief routed frame: unpack inner frame when it is for local core, otherwise pass it
+ *         on by the header only, body is never parsed on relays
+ *
+ *  @param [in] taken : NULL when data is not owned, otherwise data is x_malloc and
+ *                      handed to next tunnel without copy
+ *  @param [out] taken : true if data was handed over
+ *  @return false: not a routed frame
+ **/
+static bool kernel_wire_relay(struct comm_tunnel_t *tunnel, uint8_t *data, int32_t length, bool *taken){
+    if( (length < 2) || (data[0] != KERNEL_WIRE_MAGIC) || (data[1] != KERNEL_WIRE_ROUTED) ){ return false; }
+    if( length <= KERNEL_WIRE_ROUTE_HEAD ){ return true; }
+
+    uint16_t dst_id = (uint16_t)( data[2] | (data[3] << 8) );
+    uint32_t epoch;
+    const struct kernel_route_snap_t *snap = kernel_route_read_lock( &epoch );
+    const struct kernel_route_core_t *dst = kernel_route_snap_core_id( snap, dst_id );
+    if( dst == NULL ){
+        WARNING( "Unknown core id %d of routed frame", dst_id );
+        goto UNLOCK;
+    }
+
+    if( dst->is_local ){                                // <! destination is me, strip header
+        kernel_route_read_unlock( epoch );              // <! frame may change topology
+        uint8_t *frame = &data[ KERNEL_WIRE_ROUTE_HEAD ];
+        int32_t frame_length = length - KERNEL_WIRE_ROUTE_HEAD;
+        if( (frame_length >= 2) && (frame[0] == KERNEL_WIRE_MAGIC) && (frame[1] == KERNEL_WIRE_ROUTED) ){ return true; }    // <! no nested header
+        kernel_frame_unpack( tunnel, frame, frame_length );
+        return true;
+    }
+
+    if( data[4] == 0 ){
+        WARNING( "Routed frame to (%s) run out of hops", dst->core );
+        goto UNLOCK;
+    }
+    if( dst->tunnel == tunnel ){ goto UNLOCK; }         // <! avoid same channel
+    if( dst->tunnel->passive_tunnel && (! dst->tunnel->tunnel_enabled) ){ goto UNLOCK; }   // <! Tunnel Disabled
+
+    uint8_t *router_data = data;
+    if( taken == NULL ){                                // <! part of batch, or buffer kept by port
+        if( NULL == (router_data = (uint8_t *)x_malloc(length)) ){ goto UNLOCK; }
+        memcpy( router_data, data, length );
+    }else{
+        *taken = true;
+    }
+    router_data[4]--;
+    kernel_router_raw_to( dst, router_data, length, tunnel );
+
+    UNLOCK:
+    kernel_route_read_unlock( epoch );
+    return true;
+}
+
+static int32_t kernel_wire_unpack(struct comm_tunnel_t *tunnel, uint8_t *data, int32_t length){
+    if( length < 2 ){ return 0; }
+
+    struct kernel_wire_reader_t r = { &data[2], &data[length] };
+    switch( data[1] ){
+        case KERNEL_WIRE_MSG           : kernel_wire_unpack_msg( tunnel, &r, data, length );  break;
+        case KERNEL_WIRE_MMAP          : kernel_wire_unpack_mmap( tunnel, &r, data, length ); break;
+        case KERNEL_WIRE_MMAP_SYNC_REQ : kernel_wire_unpack_mmap_req( tunnel, &r, data, length ); break;
+        case KERNEL_WIRE_CORES         : kernel_wire_unpack_cores( tunnel, &r );              break;
+        case KERNEL_WIRE_BATCH         : kernel_batch_unpack( tunnel, &r );                   break;
+        case KERNEL_WIRE_CREDIT        : kernel_wire_unpack_credit( tunnel, &r );             break;
+        case KERNEL_WIRE_ROUTED        : kernel_wire_relay( tunnel, data, length, NULL );     break;
+        case KERNEL_WIRE_PROBE         : kernel_link_unpack_probe( tunnel, &r );              break;
+        case KERNEL_WIRE_DELTA         : kernel_delta_unpack( tunnel, &r, data, length );     break;
+        case KERNEL_WIRE_DIGEST        : kernel_delta_unpack_digest( tunnel, &r );            break;
+        case KERNEL_WIRE_SYNC_REQ      : kernel_delta_unpack_req( tunnel, &r );               break;
+        default : WARNING( "Unknown binary frame type %d", data[1] );  break;
+    }
+    return 0;
+}
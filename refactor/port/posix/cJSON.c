@@ -0,0 +1,401 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cJSON.h"
+
+static void * (*cJSON_malloc)(size_t size) = malloc;
+static void   (*cJSON_free)(void *p)       = free;
+
+void cJSON_InitHooks(cJSON_Hooks *hooks){
+    cJSON_malloc = ( (hooks != NULL) && (hooks->malloc_fn != NULL) )?(hooks->malloc_fn):(malloc);
+    cJSON_free   = ( (hooks != NULL) && (hooks->free_fn != NULL) )  ?(hooks->free_fn)  :(free);
+}
+
+static char * cJSON_strndup(const char *s, size_t n){
+    char *p = (char *)cJSON_malloc( n + 1 );
+    if( p != NULL ){
+        memcpy( p, s, n );
+        p[n] = '\0';
+    }
+    return p;
+}
+
+static cJSON * cJSON_New_Item(int type){
+    cJSON *item = (cJSON *)cJSON_malloc( sizeof(cJSON) );
+    if( item != NULL ){
+        memset( item, 0x0, sizeof(cJSON) );
+        item->type = type;
+    }
+    return item;
+}
+
+void cJSON_Delete(cJSON *item){
+    while( item != NULL ){
+        cJSON *next = item->next;
+        cJSON_Delete( item->child );
+        if( item->valuestring != NULL ){ cJSON_free( item->valuestring ); }
+        if( item->string != NULL )     { cJSON_free( item->string );      }
+        cJSON_free( item );
+        item = next;
+    }
+}
+
+  /**********************************************************************
+  |                                                                     |
+  |                               create                                |
+  |                                                                     |
+  **********************************************************************/
+
+cJSON * cJSON_CreateNull(void){ return cJSON_New_Item( cJSON_NULL ); }
+
+cJSON * cJSON_CreateBool(int b){ return cJSON_New_Item( (b)?(cJSON_True):(cJSON_False) ); }
+
+cJSON * cJSON_CreateNumber(double num){
+    cJSON *item = cJSON_New_Item( cJSON_Number );
+    if( item != NULL ){
+        item->valuedouble = num;
+        item->valueint    = (int)num;
+    }
+    return item;
+}
+
+cJSON * cJSON_CreateString(const char *string){
+    cJSON *item = cJSON_New_Item( cJSON_String );
+    if( item != NULL ){
+        item->valuestring = cJSON_strndup( (string != NULL)?(string):(""), (string != NULL)?(strlen(string)):(0) );
+        if( item->valuestring == NULL ){ cJSON_Delete( item );  return NULL; }
+    }
+    return item;
+}
+
+/**
+ *  @brief binary data, NULL / 0 length marks data carried outside of JSON
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+cJSON * cJSON_CreateHexString(const uint8_t *data, int length){
+    static const char digits[] = "0123456789ABCDEF";
+    cJSON *item = cJSON_New_Item( cJSON_HexString );
+    if( item == NULL ){ return NULL; }
+    if( data == NULL ){ length = 0; }
+
+    item->valueint    = length;
+    item->valuestring = (char *)cJSON_malloc( 2 * length + 1 );
+    if( item->valuestring == NULL ){ cJSON_Delete( item );  return NULL; }
+    for( int i=0; i<length; i++ ){
+        item->valuestring[2 * i]     = digits[ data[i] >> 4 ];
+        item->valuestring[2 * i + 1] = digits[ data[i] & 0xF ];
+    }
+    item->valuestring[2 * length] = '\0';
+    return item;
+}
+
+cJSON * cJSON_CreateArray(void) { return cJSON_New_Item( cJSON_Array );  }
+cJSON * cJSON_CreateObject(void){ return cJSON_New_Item( cJSON_Object ); }
+
+void cJSON_AddItemToArray(cJSON *array, cJSON *item){
+    if( (array == NULL) || (item == NULL) ){ return; }
+
+    cJSON *c = array->child;
+    if( c == NULL ){ array->child = item;  return; }
+    while( c->next != NULL ){ c = c->next; }
+    c->next = item;  item->prev = c;
+}
+
+void cJSON_AddItemToObject(cJSON *object, const char *string, cJSON *item){
+    if( (object == NULL) || (string == NULL) || (item == NULL) ){ return; }
+
+    if( item->string != NULL ){ cJSON_free( item->string ); }
+    item->string = cJSON_strndup( string, strlen(string) );
+    cJSON_AddItemToArray( object, item );
+}
+
+cJSON * cJSON_AddNumberToObject(cJSON *object, const char *name, double number){
+    cJSON *item = cJSON_CreateNumber( number );
+    cJSON_AddItemToObject( object, name, item );
+    return item;
+}
+
+cJSON * cJSON_AddStringToObject(cJSON *object, const char *name, const char *string){
+    cJSON *item = cJSON_CreateString( string );
+    cJSON_AddItemToObject( object, name, item );
+    return item;
+}
+
+cJSON * cJSON_AddBoolToObject(cJSON *object, const char *name, int boolean){
+    cJSON *item = cJSON_CreateBool( boolean );
+    cJSON_AddItemToObject( object, name, item );
+    return item;
+}
+
+  /**********************************************************************
+  |                                                                     |
+  |                               access                                |
+  |                                                                     |
+  **********************************************************************/
+
+int cJSON_GetArraySize(const cJSON *array){
+    int n = 0;
+    for( cJSON *c = (array != NULL)?(array->child):(NULL); c != NULL; c = c->next ){ n++; }
+    return n;
+}
+
+cJSON * cJSON_GetArrayItem(const cJSON *array, int index){
+    cJSON *c = (array != NULL)?(array->child):(NULL);
+    while( (c != NULL) && (index-- > 0) ){ c = c->next; }
+    return c;
+}
+
+cJSON * cJSON_GetObjectItem(const cJSON *object, const char *string){
+    cJSON *c = (object != NULL)?(object->child):(NULL);
+    while( (c != NULL) && ((c->string == NULL) || (strcmp(c->string, string) != 0)) ){ c = c->next; }
+    return c;
+}
+
+static int cJSON_nibble(char c){
+    if( (c >= '0') && (c <= '9') ){ return c - '0'; }
+    if( (c >= 'a') && (c <= 'f') ){ return c - 'a' + 10; }
+    if( (c >= 'A') && (c <= 'F') ){ return c - 'A' + 10; }
+    return -1;
+}
+
+uint8_t * cJSON_hexassemble(const char *hex){
+    if( hex == NULL ){ return NULL; }
+
+    size_t digits = strlen( hex );
+    if( digits & 1 ){ return NULL; }
+
+    uint8_t *out = (uint8_t *)cJSON_malloc( (digits / 2) + 1 );       // <! never 0 size
+    if( out == NULL ){ return NULL; }
+    for( size_t i=0; i<digits / 2; i++ ){
+        int h = cJSON_nibble( hex[2 * i] ), l = cJSON_nibble( hex[2 * i + 1] );
+        if( (h < 0) || (l < 0) ){ cJSON_free( out );  return NULL; }
+        out[i] = (uint8_t)((h << 4) | l);
+    }
+    return out;
+}
+
+  /**********************************************************************
+  |                                                                     |
+  |                               parse                                 |
+  |                                                                     |
+  **********************************************************************/
+
+static const char * cJSON_ws(const char *p){
+    while( (*p == ' ') || (*p == '\t') || (*p == '\r') || (*p == '\n') ){ p++; }
+    return p;
+}
+
+static const char * cJSON_parse_value(cJSON *item, const char *p, int depth);
+
+// !> '"' ... '"' to malloced C string, \uXXXX keeps ASCII only
+static const char * cJSON_parse_str(char **out, const char *p){
+    if( *p != '"' ){ return NULL; }
+
+    const char *s = ++p;  size_t n = 0;
+    while( (*p != '"') && (*p != '\0') ){
+        if( (*p == '\\') && (p[1] != '\0') ){ p++; }
+        p++;  n++;
+    }
+    if( *p != '"' ){ return NULL; }
+
+    char *str = (char *)cJSON_malloc( n + 1 );
+    if( str == NULL ){ return NULL; }
+    for( n = 0; s < p; s++ ){
+        char c = *s;
+        if( c == '\\' ){
+            switch( c = *++s ){
+                case 'b' : c = '\b';  break;
+                case 'f' : c = '\f';  break;
+                case 'n' : c = '\n';  break;
+                case 'r' : c = '\r';  break;
+                case 't' : c = '\t';  break;
+                case 'u' : {
+                    int u = 0;
+                    for( int k=0; (k<4) && (s + 1 < p); k++ ){
+                        int h = cJSON_nibble( *++s );
+                        u = (u << 4) | ((h < 0)?(0):(h));
+                    }
+                    c = (u < 0x80)?((char)u):('?');
+                } break;
+                default : break;
+            }
+        }
+        str[n++] = c;
+    }
+    str[n] = '\0';
+    *out = str;
+    return p + 1;
+}
+
+static const char * cJSON_parse_container(cJSON *item, const char *p, int depth){
+    bool is_obj = (*p == '{');
+    char close  = (is_obj)?('}'):(']');
+    item->type  = (is_obj)?(cJSON_Object):(cJSON_Array);
+
+    p = cJSON_ws( p + 1 );
+    if( *p == close ){ return p + 1; }
+
+    cJSON *last = NULL;
+    for( ;; ){
+        cJSON *c = cJSON_New_Item( 0 );
+        if( c == NULL ){ return NULL; }
+        if( last == NULL ){ item->child = c; }
+        else{ last->next = c;  c->prev = last; }
+        last = c;
+
+        if( is_obj ){
+            p = cJSON_parse_str( &c->string, cJSON_ws(p) );
+            if( p == NULL ){ return NULL; }
+            p = cJSON_ws( p );
+            if( *p++ != ':' ){ return NULL; }
+        }
+        p = cJSON_parse_value( c, cJSON_ws(p), depth + 1 );
+        if( p == NULL ){ return NULL; }
+
+        p = cJSON_ws( p );
+        if( *p == ',' ){ p++;  continue; }
+        if( *p == close ){ return p + 1; }
+        return NULL;
+    }
+}
+
+static const char * cJSON_parse_value(cJSON *item, const char *p, int depth){
+    if( depth > 64 ){ return NULL; }
+
+    switch( *p ){
+        case '"' : item->type = cJSON_String;  return cJSON_parse_str( &item->valuestring, p );
+        case 'x' : {
+            item->type = cJSON_HexString;
+            p = cJSON_parse_str( &item->valuestring, p + 1 );
+            if( p != NULL ){ item->valueint = (int)(strlen( item->valuestring ) / 2); }
+            return p;
+        }
+        case '{' :
+        case '[' : return cJSON_parse_container( item, p, depth );
+        case 't' : if( strncmp(p, "true", 4) == 0 ) { item->type = cJSON_True;   return p + 4; }  return NULL;
+        case 'f' : if( strncmp(p, "false", 5) == 0 ){ item->type = cJSON_False;  return p + 5; }  return NULL;
+        case 'n' : if( strncmp(p, "null", 4) == 0 ) { item->type = cJSON_NULL;   return p + 4; }  return NULL;
+        default  : {
+            char *end = NULL;
+            double num = strtod( p, &end );
+            if( end == p ){ return NULL; }
+            item->type        = cJSON_Number;
+            item->valuedouble = num;
+            item->valueint    = (int)num;
+            return end;
+        }
+    }
+}
+
+cJSON * cJSON_Parse(const char *value){
+    if( value == NULL ){ return NULL; }
+
+    cJSON *item = cJSON_New_Item( 0 );
+    if( item == NULL ){ return NULL; }
+    if( cJSON_parse_value(item, cJSON_ws(value), 0) == NULL ){
+        cJSON_Delete( item );
+        return NULL;
+    }
+    return item;
+}
+
+  /**********************************************************************
+  |                                                                     |
+  |                               print                                 |
+  |                                                                     |
+  **********************************************************************/
+
+struct cJSON_buf_t {
+    char                          *s;
+    size_t                        len;
+    size_t                        size;
+    bool                          err;
+};
+
+static void cJSON_put(struct cJSON_buf_t *b, const char *s, size_t n){
+    if( b->err ){ return; }
+    if( b->len + n + 1 > b->size ){
+        size_t size = (b->size * 2 > b->len + n + 1)?(b->size * 2):(b->len + n + 64);
+        char *p = (char *)cJSON_malloc( size );
+        if( p == NULL ){ b->err = true;  return; }
+        if( b->s != NULL ){
+            memcpy( p, b->s, b->len );
+            cJSON_free( b->s );
+        }
+        b->s = p;  b->size = size;
+    }
+    memcpy( &b->s[b->len], s, n );
+    b->len += n;
+    b->s[b->len] = '\0';
+}
+
+static void cJSON_print_str(struct cJSON_buf_t *b, const char *s){
+    cJSON_put( b, "\"", 1 );
+    for( ; (s != NULL) && (*s != '\0'); s++ ){
+        char esc[8];
+        switch( *s ){
+            case '"'  : cJSON_put( b, "\\\"", 2 );  break;
+            case '\\' : cJSON_put( b, "\\\\", 2 );  break;
+            case '\b' : cJSON_put( b, "\\b", 2 );   break;
+            case '\f' : cJSON_put( b, "\\f", 2 );   break;
+            case '\n' : cJSON_put( b, "\\n", 2 );   break;
+            case '\r' : cJSON_put( b, "\\r", 2 );   break;
+            case '\t' : cJSON_put( b, "\\t", 2 );   break;
+            default   :
+                if( (uint8_t)*s < 0x20 ){
+                    snprintf( esc, sizeof(esc), "\\u%04x", (uint8_t)*s );
+                    cJSON_put( b, esc, 6 );
+                }else{
+                    cJSON_put( b, s, 1 );
+                } break;
+        }
+    }
+    cJSON_put( b, "\"", 1 );
+}
+
+static void cJSON_print_value(struct cJSON_buf_t *b, const cJSON *item){
+    char num[32];
+    switch( item->type ){
+        case cJSON_False     : cJSON_put( b, "false", 5 );  break;
+        case cJSON_True      : cJSON_put( b, "true", 4 );   break;
+        case cJSON_NULL      : cJSON_put( b, "null", 4 );   break;
+        case cJSON_String    : cJSON_print_str( b, item->valuestring );  break;
+        case cJSON_HexString : cJSON_put( b, "x", 1 );  cJSON_print_str( b, item->valuestring );  break;
+        case cJSON_Number    : {
+            int n = ( item->valuedouble == (double)(int64_t)item->valuedouble )?
+                    ( snprintf(num, sizeof(num), "%lld", (long long)item->valuedouble) ):
+                    ( snprintf(num, sizeof(num), "%.17g", item->valuedouble) );
+            cJSON_put( b, num, n );
+        } break;
+        case cJSON_Array     :
+        case cJSON_Object    : {
+            bool is_obj = (item->type == cJSON_Object);
+            cJSON_put( b, (is_obj)?("{"):("["), 1 );
+            for( const cJSON *c = item->child; c != NULL; c = c->next ){
+                if( c != item->child ){ cJSON_put( b, ",", 1 ); }
+                if( is_obj ){ cJSON_print_str( b, c->string );  cJSON_put( b, ":", 1 ); }
+                cJSON_print_value( b, c );
+            }
+            cJSON_put( b, (is_obj)?("}"):("]"), 1 );
+        } break;
+        default : b->err = true;  break;
+    }
+}
+
+char * cJSON_PrintUnformatted(const cJSON *item){
+    struct cJSON_buf_t b = { NULL, 0, 0, false };
+    if( item == NULL ){ return NULL; }
+
+    cJSON_print_value( &b, item );
+    if( b.err ){
+        if( b.s != NULL ){ cJSON_free( b.s ); }
+        return NULL;
+    }
+    return b.s;
+}
@@ -0,0 +1,76 @@
+#ifndef KERNEL_PORT_POSIX_CJSON_H
+#define KERNEL_PORT_POSIX_CJSON_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*************************************************************************
+
+           -------------------------------------------------
+          |                                                 |
+          |        cJSON Subset of POSIX Host Port          |
+          |                                                 |
+           -------------------------------------------------
+
+ Note:
+ 1.only the API the kernel calls, same names and fields as the target
+   cJSON so kernel sources build unchanged
+ 2.cJSON_HexString is binary data, printed as  x"<hex digits>"  and
+   parsed back to cJSON_HexString, valueint is the byte length, 0 means
+   data is carried outside of JSON (json_extra_data_t after '\0')
+ 3.every buffer comes from the hooks, kernel points them at pass arena
+
+*************************************************************************/
+
+#define cJSON_False             (1 << 0)
+#define cJSON_True              (1 << 1)
+#define cJSON_NULL              (1 << 2)
+#define cJSON_Number            (1 << 3)
+#define cJSON_String            (1 << 4)
+#define cJSON_Array             (1 << 5)
+#define cJSON_Object            (1 << 6)
+#define cJSON_HexString         (1 << 7)
+
+typedef struct cJSON {
+    struct cJSON                  *next;
+    struct cJSON                  *prev;
+    struct cJSON                  *child;
+    int                           type;
+    char                          *valuestring;           // <! hex digits of cJSON_HexString
+    int                           valueint;               // <! byte length of cJSON_HexString
+    double                        valuedouble;
+    char                          *string;                // <! key of object member
+} cJSON;
+
+typedef struct cJSON_Hooks {
+    void *(*malloc_fn)(size_t size);
+    void  (*free_fn)(void *p);
+} cJSON_Hooks;
+
+void    cJSON_InitHooks(cJSON_Hooks *hooks);
+
+cJSON * cJSON_Parse(const char *value);
+char *  cJSON_PrintUnformatted(const cJSON *item);
+void    cJSON_Delete(cJSON *item);
+
+int     cJSON_GetArraySize(const cJSON *array);
+cJSON * cJSON_GetArrayItem(const cJSON *array, int index);
+cJSON * cJSON_GetObjectItem(const cJSON *object, const char *string);
+
+cJSON * cJSON_CreateNull(void);
+cJSON * cJSON_CreateBool(int b);
+cJSON * cJSON_CreateNumber(double num);
+cJSON * cJSON_CreateString(const char *string);
+cJSON * cJSON_CreateHexString(const uint8_t *data, int length);
+cJSON * cJSON_CreateArray(void);
+cJSON * cJSON_CreateObject(void);
+
+void    cJSON_AddItemToArray(cJSON *array, cJSON *item);
+void    cJSON_AddItemToObject(cJSON *object, const char *string, cJSON *item);
+cJSON * cJSON_AddNumberToObject(cJSON *object, const char *name, double number);
+cJSON * cJSON_AddStringToObject(cJSON *object, const char *name, const char *string);
+cJSON * cJSON_AddBoolToObject(cJSON *object, const char *name, int boolean);
+
+uint8_t * cJSON_hexassemble(const char *hex);                // <! bytes of hex digits, freed by hooks
+
+#endif
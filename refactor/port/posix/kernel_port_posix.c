@@ -0,0 +1,296 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE                                         // <! sched_getcpu()
+#endif
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <time.h>
+#include <poll.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/socket.h>
+
+#include "kernel_port_posix.h"
+
+  /**********************************************************************
+  |                                                                     |
+  |                         malloc backed heap                          |
+  |                                                                     |
+  **********************************************************************/
+
+static int64_t x_malloc_count = 0, x_free_count = 0;
+
+void * x_malloc(size_t size){
+    void *p = malloc( size );
+    if( p != NULL ){ __atomic_add_fetch( &x_malloc_count, 1, __ATOMIC_RELAXED ); }
+    return p;
+}
+
+void x_free(void *p){
+    if( p == NULL ){ return; }
+    __atomic_add_fetch( &x_free_count, 1, __ATOMIC_RELAXED );
+    free( p );
+}
+
+void show_x_malloc(void){
+    LOG( "\r\nHeap : malloc %lld, free %lld, in use %lld\r\n",
+         (long long)x_malloc_count, (long long)x_free_count, (long long)(x_malloc_count - x_free_count) );
+}
+
+  /**********************************************************************
+  |                                                                     |
+  |                    monotonic tick (wrap at 32bit)                   |
+  |                                                                     |
+  **********************************************************************/
+
+static int64_t posix_monotonic_us(void){
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+int32_t tick_us(void)          { return (int32_t)(uint32_t)posix_monotonic_us(); }
+int32_t tock_us(int32_t t0)    { return (int32_t)( (uint32_t)tick_us() - (uint32_t)t0 ); }
+int32_t tick(void)             { return (int32_t)(uint32_t)( posix_monotonic_us() / 1000 ); }
+int32_t tock(int32_t t0)       { return (int32_t)( (uint32_t)tick() - (uint32_t)t0 ); }
+
+int32_t kernel_get_tick_callback(void){ return tick(); }
+
+void watchdog_feed(void){ }
+
+int32_t posix_current_cpu(void){
+    #if defined (__linux__)
+    int cpu = sched_getcpu();
+    return (cpu < 0)?(0):(cpu);
+    #else
+    return 0;
+    #endif
+}
+
+  /**********************************************************************
+  |                                                                     |
+  |          simulated power manager: power is always activated         |
+  |                                                                     |
+  **********************************************************************/
+
+void        pwr_mgr_timer_update(int32_t delta_ms)          { (void)delta_ms; }
+bool        pwr_mgr_activate(xPwrMgrHandler pm)             { (void)pm;  return true; }
+bool        pwr_mgr_diactivate(xPwrMgrHandler pm)           { (void)pm;  return true; }
+pwr_state_t pwr_mgr_check(xPwrMgrHandler pm)                { (void)pm;  return POWER_ACTIVATED; }
+bool        pwr_mgr_check_power_failure(xPwrMgrHandler pm)  { (void)pm;  return false; }
+
+  /**********************************************************************
+  |                                                                     |
+  |                fd backed comm tunnel (pipe / socket)                |
+  |                                                                     |
+  |         frame on fd: [ length : 4 bytes, little endian ][ data ]    |
+  |                                                                     |
+  **********************************************************************/
+
+#ifndef POSIX_TUNNEL_MAX
+#define POSIX_TUNNEL_MAX                8
+#endif
+
+#ifndef POSIX_TUNNEL_FRAME_MAX
+#define POSIX_TUNNEL_FRAME_MAX          (64 * 1024)
+#endif
+
+static struct comm_tunnel_t *posix_tunnel_list[POSIX_TUNNEL_MAX];
+static int32_t               posix_tunnel_num = 0;
+
+int32_t kernel_msg_layer_take(layer_proc_func_list *proc, void *arg, uint8_t *data, int32_t length);
+
+static bool posix_write_all(int fd, const uint8_t *data, int32_t length){
+    while( length > 0 ){
+        ssize_t n = write( fd, data, length );
+        if( n < 0 ){
+            if( errno == EINTR ){ continue; }
+            return false;
+        }
+        data += n;  length -= (int32_t)n;
+    }
+    return true;
+}
+
+/**
+ *  @brief last send layer: write frame to fd, frame is freed here
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return sent length, -1 when failed
+ **/
+static int32_t posix_tunnel_send(layer_proc_func_list *proc, void *arg, uint8_t *data, int32_t length){
+    struct comm_tunnel_t *tunnel = (struct comm_tunnel_t *)arg;
+    uint8_t head[4] = { (uint8_t)length, (uint8_t)(length >> 8), (uint8_t)(length >> 16), (uint8_t)(length >> 24) };
+
+    pthread_mutex_lock( &tunnel->tx_mutex );
+    bool ok = posix_write_all( tunnel->tx_fd, head, sizeof(head) ) && posix_write_all( tunnel->tx_fd, data, length );
+    pthread_mutex_unlock( &tunnel->tx_mutex );
+
+    x_free( data );
+    return (ok)?(length):(-1);
+}
+
+static layer_proc_func_list posix_send_proc[2] = { { posix_tunnel_send },       { NULL } };
+static layer_proc_func_list posix_recv_proc[2] = { { kernel_msg_layer_take },   { NULL } };
+
+/**
+ *  @brief bind tunnel to fd pair, use the same fd for socket
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+bool posix_tunnel_open(struct comm_tunnel_t *tunnel, int rx_fd, int tx_fd){
+    ASSERT_NULL( tunnel );
+    if( posix_tunnel_num >= POSIX_TUNNEL_MAX ){
+        WARNING( "No more posix tunnel" );
+        return false;
+    }
+
+    memset( tunnel, 0x0, sizeof(struct comm_tunnel_t) );
+    tunnel->rx_fd     = rx_fd;
+    tunnel->tx_fd     = tx_fd;
+    tunnel->send_proc = posix_send_proc;
+    tunnel->recv_proc = posix_recv_proc;
+    tunnel->rx_size   = 256;
+    pthread_mutex_init( &tunnel->tx_mutex, NULL );
+    tunnel->rx_buf    = (uint8_t *)x_malloc( tunnel->rx_size );
+    if( tunnel->rx_buf == NULL ){ return false; }
+
+    posix_tunnel_list[ posix_tunnel_num++ ] = tunnel;
+    return true;
+}
+
+bool posix_tunnel_socketpair(struct comm_tunnel_t *a, struct comm_tunnel_t *b){
+    int fd[2];
+    if( socketpair(AF_UNIX, SOCK_STREAM, 0, fd) != 0 ){ return false; }
+    return posix_tunnel_open( a, fd[0], fd[0] ) && posix_tunnel_open( b, fd[1], fd[1] );
+}
+
+/**
+ *  @brief stop polling tunnel and close its fds, tunnel must not be used by kernel any more
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+void posix_tunnel_close(struct comm_tunnel_t *tunnel){
+    for( int32_t i=0; i<posix_tunnel_num; i++ ){
+        if( posix_tunnel_list[i] != tunnel ){ continue; }
+
+        posix_tunnel_list[i] = posix_tunnel_list[ --posix_tunnel_num ];
+        if( tunnel->rx_fd >= 0 ){ close( tunnel->rx_fd ); }
+        if( (tunnel->tx_fd >= 0) && (tunnel->tx_fd != tunnel->rx_fd) ){ close( tunnel->tx_fd ); }
+        tunnel->rx_fd = tunnel->tx_fd = -1;
+        x_free( tunnel->rx_buf );
+        tunnel->rx_buf = NULL;
+        pthread_mutex_destroy( &tunnel->tx_mutex );
+        return;
+    }
+}
+
+/**
+ *  @brief read fd, hand over every complete frame to recv layers
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return false: fd closed or error
+ **/
+static bool posix_tunnel_read(struct comm_tunnel_t *tunnel){
+    if( tunnel->rx_len == tunnel->rx_size ){
+        uint8_t *p = (uint8_t *)x_malloc( tunnel->rx_size * 2 );
+        if( p == NULL ){ return false; }
+        memcpy( p, tunnel->rx_buf, tunnel->rx_len );
+        x_free( tunnel->rx_buf );
+        tunnel->rx_buf   = p;
+        tunnel->rx_size *= 2;
+    }
+
+    ssize_t n = read( tunnel->rx_fd, &tunnel->rx_buf[tunnel->rx_len], tunnel->rx_size - tunnel->rx_len );
+    if( n <= 0 ){ return (n < 0) && (errno == EINTR); }
+    tunnel->rx_len += (int32_t)n;
+
+    while( tunnel->rx_len >= 4 ){
+        uint8_t *h = tunnel->rx_buf;
+        int32_t length = (int32_t)( h[0] | (h[1] << 8) | (h[2] << 16) | ((uint32_t)h[3] << 24) );
+        if( (length <= 0) || (length > POSIX_TUNNEL_FRAME_MAX) ){
+            WARNING( "Bad frame length %d, drop rx buffer", length );
+            tunnel->rx_len = 0;
+            break;
+        }
+        if( tunnel->rx_len < 4 + length ){ break; }       // <! wait for the rest
+
+        uint8_t *frame = (uint8_t *)x_malloc( length + 1 );
+        if( frame != NULL ){
+            memcpy( frame, &h[4], length );
+            frame[length] = 0;                              // <! JSON layer expects C string
+            layer_proc_func_list *proc = tunnel->recv_proc;
+            proc[0].func( &proc[1], tunnel, frame, length );  // <! frame is freed or passed on by kernel_msg_layer_take
+        }
+        tunnel->rx_len -= 4 + length;
+        memmove( tunnel->rx_buf, &tunnel->rx_buf[4 + length], tunnel->rx_len );
+    }
+    return true;
+}
+
+/**
+ *  @brief wait for tunnel traffic up to timeout_ms
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return number of tunnels with traffic
+ **/
+int32_t posix_tunnel_poll(int32_t timeout_ms){
+    struct pollfd fds[POSIX_TUNNEL_MAX];
+    for( int32_t i=0; i<posix_tunnel_num; i++ ){
+        fds[i].fd      = posix_tunnel_list[i]->rx_fd;
+        fds[i].events  = POLLIN;
+        fds[i].revents = 0;
+    }
+
+    int n = poll( fds, posix_tunnel_num, timeout_ms );
+    if( n <= 0 ){ return 0; }
+
+    for( int32_t i=0; i<posix_tunnel_num; i++ ){
+        if( fds[i].revents & (POLLIN | POLLHUP) ){
+            if( ! posix_tunnel_read(posix_tunnel_list[i]) ){
+                WARNING( "tunnel fd[%d] closed", posix_tunnel_list[i]->rx_fd );
+                posix_tunnel_list[i]->rx_fd = -1;           // <! poll() ignores negative fd
+            }
+        }
+    }
+    return n;
+}
+
+int32_t get_secure_tunnel_next_retry(struct comm_tunnel_t *tunnel){
+    (void)tunnel;
+    return -1;                                              // <! fd tunnel is reliable, nothing to retry
+}
+
+  /**********************************************************************
+  |                                                                     |
+  |                  kernel main loop as userspace service              |
+  |                                                                     |
+  **********************************************************************/
+
+/**
+ *  @brief run scheduler, sleep on tunnels until next work state
+ *
+ *  @param [in] running: loop until *running becomes false
+ *  @param [out]
+ *  @return
+ **/
+void kernel_port_posix_loop(volatile bool *running){
+    void kernel_task_sheduler(void);
+    uint32_t kernel_idle_time(void);
+
+    while( (running == NULL) || *running ){
+        kernel_task_sheduler();
+
+        uint32_t idle = kernel_idle_time();
+        int32_t timeout = (idle > 1000)?(1000):((int32_t)idle);   // <! wake up at least once a second
+        posix_tunnel_poll( timeout );
+    }
+}
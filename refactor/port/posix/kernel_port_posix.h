@@ -0,0 +1,230 @@
+#ifndef KERNEL_PORT_POSIX_H
+#define KERNEL_PORT_POSIX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#include "cJSON.h"
+
+/*************************************************************************
+
+           -------------------------------------------------
+          |                                                 |
+          |     POSIX Host Port (run kernel on Linux)       | 
+          |                                                 |
+           -------------------------------------------------
+
+ Platform symbols the kernel expects from the target, implemented on top
+ of POSIX: monotonic tick, malloc-backed allocator, simulated power
+ manager, fd (pipe/socket) backed comm tunnel and the list macros.
+ Types and API of the product kernel header are declared at the end,
+ kernel sources are built as one unit, see CMakeLists.txt.
+
+*************************************************************************/
+
+#define PTHREAD_H                                           // <! enable mutex protection of kernel
+
+#ifndef LOG
+#define LOG(...)            printf( __VA_ARGS__ )
+#endif
+#ifndef WARNING
+#define WARNING(fmt, ...)   printf( "[W] %s:%d " fmt "\r\n", __func__, __LINE__, ##__VA_ARGS__ )
+#endif
+#ifndef ERROR
+#define ERROR(fmt, ...)     printf( "[E] %s:%d " fmt "\r\n", __func__, __LINE__, ##__VA_ARGS__ )
+#endif
+#ifndef ASSERT_NULL
+#define ASSERT_NULL(p)      do{ if( (p) == NULL ){ ERROR( "assert null: %s", #p ); } }while(0)
+#endif
+#ifndef ASSERT_TRUE
+#define ASSERT_TRUE(e)      do{ if( !(e) ){ ERROR( "assert false: %s", #e ); } }while(0)
+#endif
+#ifndef MIN
+#define MIN(a, b)           ( ((a) < (b))?(a):(b) )
+#endif
+#ifndef MAX
+#define MAX(a, b)           ( ((a) > (b))?(a):(b) )
+#endif
+
+// !> MOUNT: append node to the tail of queue     UNMOUNT: remove node from queue
+#define MOUNT(queue, node)                                                          \
+    do{ (node)->next = NULL;                                                        \
+        if( (queue) == NULL ){ (queue) = (node); }                                  \
+        else{ __typeof__(queue) __q = (queue);                                      \
+              while( __q->next != NULL ){ __q = __q->next; }                        \
+              __q->next = (node); }                                                 \
+    }while(0)
+
+#define UNMOUNT(queue, node)                                                        \
+    do{ if( (queue) == (node) ){ (queue) = (node)->next; }                          \
+        else{ __typeof__(queue) __q = (queue);                                      \
+              while( (__q != NULL) && (__q->next != (node)) ){ __q = __q->next; }   \
+              if( __q != NULL ){ __q->next = (node)->next; } }                      \
+        (node)->next = NULL;                                                        \
+    }while(0)
+
+void *  x_malloc(size_t size);
+void    x_free(void *p);
+void    show_x_malloc(void);
+
+int32_t tick_us(void);                                      // <! monotonic us
+int32_t tock_us(int32_t t0);
+int32_t tick(void);                                         // <! monotonic ms
+int32_t tock(int32_t t0);
+int32_t kernel_get_tick_callback(void);
+void    watchdog_feed(void);
+
+#ifndef KERNEL_MAILBOX_POOL_NUM
+#define KERNEL_MAILBOX_POOL_NUM         4                   // <! mailbox pools, producer picks pool of its cpu
+#endif
+#define KERNEL_MAILBOX_POOL_ID()        posix_current_cpu()
+int32_t posix_current_cpu(void);
+
+  /**********************************************************************
+  |                                                                     |
+  |                 simulated power manager, always on                  |
+  |                                                                     |
+  **********************************************************************/
+
+typedef void * xPwrMgrHandler;
+typedef enum {
+    POWER_DIACTIVATED = 0,
+    POWER_ACTIVATING,
+    POWER_ACTIVATED,
+    POWER_DIACTIVATING,
+    POWER_GIVE_UP_ACTIVATE,
+} pwr_state_t;
+
+void        pwr_mgr_timer_update(int32_t delta_ms);
+bool        pwr_mgr_activate(xPwrMgrHandler pm);
+bool        pwr_mgr_diactivate(xPwrMgrHandler pm);
+pwr_state_t pwr_mgr_check(xPwrMgrHandler pm);
+bool        pwr_mgr_check_power_failure(xPwrMgrHandler pm);
+
+  /**********************************************************************
+  |                                                                     |
+  |                fd backed comm tunnel (pipe / socket)                |
+  |                                                                     |
+  **********************************************************************/
+
+typedef struct layer_proc_func_list {
+    int32_t (*func)(struct layer_proc_func_list *proc, void *arg, uint8_t *data, int32_t length);
+} layer_proc_func_list;
+
+struct comm_tunnel_t {
+    struct comm_tunnel_t          *next;
+    layer_proc_func_list          *send_proc;             // <! send layers, proc[0] called first
+    layer_proc_func_list          *recv_proc;             // <! recv layers, proc[0] called first
+    bool                          passive_tunnel;
+    bool                          tunnel_enabled;
+
+    int                           rx_fd;
+    int                           tx_fd;
+    pthread_mutex_t               tx_mutex;               // <! keep frames of threads apart
+    uint8_t                       *rx_buf;                // <! length prefixed frame reassembly
+    int32_t                       rx_len;
+    int32_t                       rx_size;
+};
+
+bool    posix_tunnel_open(struct comm_tunnel_t *tunnel, int rx_fd, int tx_fd);
+bool    posix_tunnel_socketpair(struct comm_tunnel_t *a, struct comm_tunnel_t *b);
+void    posix_tunnel_close(struct comm_tunnel_t *tunnel);
+int32_t posix_tunnel_poll(int32_t timeout_ms);
+int32_t get_secure_tunnel_next_retry(struct comm_tunnel_t *tunnel);
+
+void    kernel_port_posix_loop(volatile bool *running);
+
+  /**********************************************************************
+  |                                                                     |
+  |            product kernel header: task, msg and mmap API            |
+  |                                                                     |
+  **********************************************************************/
+
+#ifndef DEFAULT_BUSY_TIMEOUT
+#define DEFAULT_BUSY_TIMEOUT            (3 * 60 * 1000)     // <! busy task without traffic is reset after
+#endif
+
+typedef enum {
+    TASK_IDLE            = 0,
+    TASK_BUSY            = 1,
+    TASK_READY_TO_SLEEP  = 2,
+    TASK_IGNORE          = 3,
+    TASK_MSG_PENDING     = 0x10,                            // <! or'ed by kernel, msg left in queue
+} task_state;
+
+typedef enum {
+    TASK_SUSPEND = 0,
+    TASK_RESUME,
+    TASK_PAUSE,
+    TASK_RESTART,
+} task_freeze_event;
+
+typedef void (*task_freeze_event_callback)(task_freeze_event event);
+
+struct msg_t {
+    const char                    *notification;
+    const char                    *src_task;
+    int32_t                       length;                 // <! 0: data is '\0' ended string
+    char                          data[];
+};
+
+typedef void * xMsgHandler;
+
+struct json_extra_data_t {                                  // <! binary data after '\0' of JSON frame
+    uint8_t                       data_type;              // <! cJSON_HexString
+    uint16_t                      length;
+    uint8_t                       data[1];
+} __attribute__((packed));
+
+struct kernel_mmap_t;
+typedef struct kernel_mmap_t * xMmapHandler;
+typedef void (*mmap_update_notify)(void *arg, void *mem, int32_t size);
+
+struct kernel_task_t;
+struct kernel_mailbox_group_t;
+
+bool        create_task(const char *task_name, task_state (*task_callback)(const char *this_task, struct msg_t *msg, void *arg), void *arg, int32_t prio);
+bool        delete_task(const char *task_name);
+bool        create_mailbox(int32_t mailbox_size, int32_t num_of_boxes);
+void        kernel_task_sheduler(void);
+uint32_t    kernel_idle_time(void);
+void        synchonize_tasklist(const char local_core[], int tunnel_num, ...);
+
+xMsgHandler __new_msg(const char *notification, char *data, int32_t length);
+xMsgHandler __new_str(const char *notification, char *str);
+xMsgHandler __new_notification(const char *notification);
+xMsgHandler msg_set_repeat_n_timer(xMsgHandler msg, int32_t delay, int32_t preodic, int32_t cnt);
+xMsgHandler msg_set_repeat_timer(xMsgHandler msg, int32_t delay, int32_t preodic);
+xMsgHandler msg_set_delay_timer(xMsgHandler msg, int32_t delay);
+bool        __post_msg(const char *target_task, xMsgHandler msg);
+bool        __post_msg_from(const char *target_task, xMsgHandler msg, const char *src_task);
+
+// !> new_msg( notify ) / new_msg( notify, str ) / new_msg( notify, data, length )
+#define KERNEL_ARGS_SELECT(_1, _2, _3, _4, NAME, ...)       NAME
+#define new_msg(...)        KERNEL_ARGS_SELECT( __VA_ARGS__, _, __new_msg, __new_str, __new_notification, _ )( __VA_ARGS__ )
+#define post_msg(...)       KERNEL_ARGS_SELECT( __VA_ARGS__, _, __post_msg_from, __post_msg, _, _ )( __VA_ARGS__ )
+#define msg_set_timer(...)  KERNEL_ARGS_SELECT( __VA_ARGS__, msg_set_repeat_n_timer, msg_set_repeat_timer, msg_set_delay_timer, _, _ )( __VA_ARGS__ )
+
+xMmapHandler kernel_mmap_from(const char core_name[], const char mem_name[], void *mem, int32_t mem_size);
+xMmapHandler kernel_mmap_to(const char core_name[], const char mem_name[], void *mem, int32_t mem_size);
+xMmapHandler kernel_mmap_set_update_callback(xMmapHandler handler, mmap_update_notify callback, void *arg);
+
+void        show_task(void);
+void        show_mailbox(void);
+
+// !> product helpers, see kernel_port_posix_kernel.c
+extern struct kernel_task_t *kernel_task_queue;
+int32_t     str_verify(const char *str, int32_t length);
+void        str_chksum(uint32_t *chksum, const char *str);
+uint32_t    get_local_sync_list_chksum(void);
+void        draw_topo_layer(void *mcu_queue, int layer);
+bool        is_tunnel_available(struct comm_tunnel_t *tunnel, const char *core_name, const char *task_name, const char *notification);
+struct comm_tunnel_t * kernel_aquire_tunnel_by_core(const char *core_name);
+
+#endif
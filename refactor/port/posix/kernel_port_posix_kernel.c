@@ -0,0 +1,75 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/*************************************************************************
+
+           -------------------------------------------------
+          |                                                 |
+          |      Product Helpers of Kernel on POSIX Host    |
+          |                                                 |
+           -------------------------------------------------
+
+ Note:
+ 1.symbols the kernel sources call but the product code defines
+   (task queue head, string checksum, topology drawing, tunnel lookup)
+ 2.built as the last part of kernel_posix_unity.c, so kernel statics
+   (kernel_mcu_queue, kernel_name_hash ...) are visible here
+
+*************************************************************************/
+
+struct kernel_task_t *kernel_task_queue = NULL;
+
+/**
+ *  @brief count of leading printable chars, equal to length for text data
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+int32_t str_verify(const char *str, int32_t length){
+    int32_t n = 0;
+    if( str == NULL ){ return 0; }
+    while( (n < length) && (((uint8_t)str[n] >= 0x20) || (str[n] == '\t') || (str[n] == '\r') || (str[n] == '\n')) ){ n++; }
+    return n;
+}
+
+/**
+ *  @brief order independent checksum of names, peer list and local list are compared by it
+ *
+ *  @param [in]
+ *  @param [out]
+ *  @return
+ **/
+void str_chksum(uint32_t *chksum, const char *str){
+    if( (chksum == NULL) || (str == NULL) ){ return; }
+    *chksum += kernel_name_hash( str );
+}
+
+uint32_t get_local_sync_list_chksum(void){
+    uint32_t chksum = 0;
+    for( struct MCUs_t *mcu = kernel_mcu_queue; mcu != NULL; mcu = mcu->next ){
+        str_chksum( &chksum, mcu->core );
+        for( struct kernel_external_task_t *t = mcu->task_queue; t != NULL; t = t->next ){
+            str_chksum( &chksum, t->task_name );
+        }
+    }
+    return chksum;
+}
+
+void draw_topo_layer(void *mcu_queue, int layer){
+    (void)layer;
+    for( struct MCUs_t *mcu = (struct MCUs_t *)mcu_queue; mcu != NULL; mcu = mcu->next ){
+        LOG( "  %s%s jump %d id %d\r\n", mcu->core, (mcu->is_local)?(" (local)"):(""), mcu->jump, mcu->id );
+    }
+}
+
+struct comm_tunnel_t * kernel_aquire_tunnel_by_core(const char *core_name){
+    struct MCUs_t *mcu = (core_name != NULL)?(is_mcu_exist( core_name )):(NULL);
+    return ( (mcu != NULL) && (! mcu->is_local) )?(mcu->tunnel):(NULL);
+}
+
+bool is_tunnel_available(struct comm_tunnel_t *tunnel, const char *core_name, const char *task_name, const char *notification){
+    (void)core_name;  (void)task_name;  (void)notification;
+    return (tunnel != NULL) && ( (! tunnel->passive_tunnel) || tunnel->tunnel_enabled );
+}
@@ -0,0 +1,139 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "kernel_port_posix.h"
+
+/*************************************************************************
+
+           -------------------------------------------------
+          |                                                 |
+          |     POSIX Host Demo: two cores over a socket    |
+          |                                                 |
+           -------------------------------------------------
+
+ Note:
+ 1.parent runs core "host_a" with "ping_task", child (fork) runs core
+   "host_b" with "pong_task", cores are linked by socketpair tunnel
+ 2.ping_task posts "ping" to the remote task once task lists are synced,
+   pong_task echoes every payload back as "pong"
+ 3.pong_task counts pongs in "pongs" mmap of host_b, mapped to host_a
+ 4.exit 0 after POSIX_DEMO_ROUNDS round trips and every pong counted in
+   mmap, 1 on timeout
+
+*************************************************************************/
+
+#ifndef POSIX_DEMO_ROUNDS
+#define POSIX_DEMO_ROUNDS               100
+#endif
+
+#ifndef POSIX_DEMO_TIMEOUT
+#define POSIX_DEMO_TIMEOUT              (10 * 1000)         // <! ms
+#endif
+
+static volatile bool posix_demo_running = true;
+static bool          posix_demo_passed  = false;
+static int32_t       posix_demo_rounds  = 0;
+static int32_t       posix_demo_start   = 0;
+static bool          posix_demo_pinged  = false;
+static uint32_t      posix_demo_pongs   = 0;                // <! "pongs" mmap, written by host_b
+
+static bool posix_demo_ping(int32_t round){
+    char payload[32];
+    int32_t n = snprintf( payload, sizeof(payload), "round %d", (int)round );
+    return post_msg( "pong_task", new_msg("ping", payload, n), "ping_task" );
+}
+
+static task_state ping_task(const char *this_task, struct msg_t *msg, void *arg){
+    (void)this_task;  (void)arg;
+
+    if( strcmp(msg->notification, "tick") == 0 ){
+        if( tock(posix_demo_start) > POSIX_DEMO_TIMEOUT ){
+            ERROR( "timeout after %d round trips", (int)posix_demo_rounds );
+            posix_demo_running = false;
+        }else if( ! posix_demo_pinged ){
+            posix_demo_pinged = posix_demo_ping( 0 );       // <! fails until pong_task is synced, retried by tick
+        }
+    }else if( strcmp(msg->notification, "pong") == 0 ){
+        if( ++posix_demo_rounds >= POSIX_DEMO_ROUNDS ){
+            LOG( "ping_task: %d round trips in %d ms, last \"%.*s\"\r\n",
+                 (int)posix_demo_rounds, (int)tock(posix_demo_start), (int)msg->length, msg->data );
+            post_msg( "pong_task", new_msg("bye"), "ping_task" );
+            if( posix_demo_pongs != (uint32_t)posix_demo_rounds ){
+                ERROR( "mmap counted %u pongs", (unsigned)posix_demo_pongs );
+            }
+            posix_demo_passed  = ( posix_demo_pongs == (uint32_t)posix_demo_rounds );
+            posix_demo_running = false;
+        }else{
+            posix_demo_ping( posix_demo_rounds );
+        }
+    }
+    return TASK_IDLE;
+}
+
+static task_state pong_task(const char *this_task, struct msg_t *msg, void *arg){
+    (void)this_task;  (void)arg;
+
+    if( strcmp(msg->notification, "ping") == 0 ){
+        posix_demo_pongs++;                                 // <! synced before the pong is sent
+        post_msg( msg->src_task, new_msg("pong", msg->data, msg->length), "pong_task" );
+    }else if( strcmp(msg->notification, "bye") == 0 ){
+        posix_demo_passed  = true;
+        posix_demo_running = false;
+    }
+    return TASK_IDLE;
+}
+
+static int posix_demo_core(const char *core, struct comm_tunnel_t *tunnel, bool is_ping){
+    posix_demo_start = tick();
+
+    if( is_ping ){
+        create_task( "ping_task", ping_task, NULL, 0 );
+        post_msg( "ping_task", msg_set_timer(new_msg("tick"), 100, 100) );
+        kernel_mmap_from( "host_b", "pongs", &posix_demo_pongs, sizeof(posix_demo_pongs) );
+    }else{
+        create_task( "pong_task", pong_task, NULL, 0 );
+        kernel_mmap_to( "host_a", "pongs", &posix_demo_pongs, sizeof(posix_demo_pongs) );
+    }
+    synchonize_tasklist( core, 1, tunnel );
+
+    while( posix_demo_running ){
+        kernel_task_sheduler();
+        if( (! is_ping) && (tock(posix_demo_start) > POSIX_DEMO_TIMEOUT) ){ break; }
+
+        uint32_t idle = kernel_idle_time();
+        posix_tunnel_poll( (idle > 100)?(100):((int32_t)idle) );
+    }
+    kernel_task_sheduler();                                 // <! flush "bye"
+    return (posix_demo_passed)?(0):(1);
+}
+
+int main(void){
+    static struct comm_tunnel_t tunnel_a, tunnel_b;
+    setvbuf( stdout, NULL, _IOLBF, 0 );
+
+    if( ! posix_tunnel_socketpair(&tunnel_a, &tunnel_b) ){
+        ERROR( "socketpair failed" );
+        return 1;
+    }
+
+    pid_t pid = fork();
+    if( pid < 0 ){
+        ERROR( "fork failed" );
+        return 1;
+    }
+    if( pid == 0 ){
+        posix_tunnel_close( &tunnel_a );                    // <! each process keeps its own end
+        return posix_demo_core( "host_b", &tunnel_b, false );
+    }
+    posix_tunnel_close( &tunnel_b );
+
+    int ret = posix_demo_core( "host_a", &tunnel_a, true ), status = 0;
+    waitpid( pid, &status, 0 );
+    if( (! WIFEXITED(status)) || (WEXITSTATUS(status) != 0) ){ ret = 1; }
+
+    LOG( "kernel_posix: %s\r\n", (ret == 0)?("PASS"):("FAIL") );
+    return ret;
+}
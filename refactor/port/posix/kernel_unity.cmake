@@ -0,0 +1,68 @@
+# Kernel sources have no headers of their own: every file is a part of one
+# translation unit and uses structs of the others in function bodies.
+# This script glues them into one file for the host build:
+#
+#   #include "kernel_port_posix.h"
+#   <structs of HOISTED, in the given order>
+#   #line 1 "kernel_xxx.c"  <source, hoisted struct replaced by blank lines>
+#   ...
+#
+# cmake -DKERNEL_DIR=<dir> -DSOURCES="a.c b.c" -DHOISTED="t1 t2" -DEXTRA="x.c" -DOUTPUT=<file> -P kernel_unity.cmake
+
+separate_arguments( SOURCES )
+separate_arguments( HOISTED )
+separate_arguments( EXTRA )
+
+foreach( src IN LISTS SOURCES )
+    file( READ "${KERNEL_DIR}/${src}" text )
+    set( "text_${src}" "${text}" )
+endforeach()
+
+set( out "/* generated by kernel_unity.cmake, do not edit */\n#include \"kernel_port_posix.h\"\n" )
+
+foreach( name IN LISTS HOISTED )
+    set( found FALSE )
+    foreach( src IN LISTS SOURCES )
+        set( text "${text_${src}}" )
+        string( FIND "${text}" "\nstruct ${name} {" begin )
+        if( begin LESS 0 )
+            continue()
+        endif()
+        math( EXPR begin "${begin} + 1" )
+        string( SUBSTRING "${text}" ${begin} -1 tail )
+        string( FIND "${tail}" "\n};" length )
+        if( length LESS 0 )
+            message( FATAL_ERROR "struct ${name} in ${src} is not closed" )
+        endif()
+        math( EXPR length "${length} + 3" )
+        string( SUBSTRING "${tail}" 0 ${length} body )
+        string( SUBSTRING "${text}" 0 ${begin} head )
+        string( SUBSTRING "${tail}" ${length} -1 rest )
+        string( REGEX REPLACE "[^\n]" "" blank "${body}" )       # keep line numbers of the source
+        set( "text_${src}" "${head}${blank}${rest}" )
+
+        string( APPEND out "\n${body}\n" )
+        set( found TRUE )
+        break()
+    endforeach()
+    if( NOT found )
+        message( FATAL_ERROR "struct ${name} not found in kernel sources" )
+    endif()
+endforeach()
+
+foreach( src IN LISTS SOURCES )
+    string( APPEND out "\n#line 1 \"${KERNEL_DIR}/${src}\"\n${text_${src}}\n" )
+endforeach()
+
+foreach( src IN LISTS EXTRA )
+    file( READ "${src}" text )
+    string( APPEND out "\n#line 1 \"${src}\"\n${text}\n" )
+endforeach()
+
+if( EXISTS "${OUTPUT}" )
+    file( READ "${OUTPUT}" old )
+    if( old STREQUAL out )
+        return()                                                # unchanged, keep timestamp
+    endif()
+endif()
+file( WRITE "${OUTPUT}" "${out}" )